@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "catable.h"
+#include "flat_hash.h"
+#include "point.h"
+
+namespace {
+
+// The hash that CATable used with std::unordered_set before FlatHashSet
+struct XorTimePointHash {
+    std::size_t operator()(const TimePoint &tp) const {
+        return std::hash<int>()(tp.x) ^ (std::hash<int>()(tp.y) << 1) ^
+               (std::hash<int>()(tp.t) << 2);
+    }
+};
+
+template <typename Function>
+double measure_ms(Function &&function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto finish = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+void report(const std::string &name, double std_ms, double flat_ms) {
+    std::cout << name << ": std " << std_ms << " ms, flat " << flat_ms
+              << " ms, speedup " << std_ms / flat_ms << std::endl;
+}
+
+// Agents walking across a 200x200 map: the access pattern of the
+// reservation table and of the visited set of the space-time search
+std::vector<TimePoint> make_trajectories(int agents, int length) {
+    std::mt19937 generator(239);
+    std::uniform_int_distribution<int> coordinate(0, 199);
+    std::uniform_int_distribution<int> step(-1, 1);
+    std::vector<TimePoint> points;
+    points.reserve(std::size_t(agents) * std::size_t(length));
+    for (int agent = 0; agent < agents; ++agent) {
+        int x = coordinate(generator);
+        int y = coordinate(generator);
+        for (int t = 0; t < length; ++t) {
+            points.push_back({x, y, t});
+            x += step(generator);
+            y += step(generator);
+        }
+    }
+    return points;
+}
+
+void bench_time_points(const std::vector<TimePoint> &points) {
+    std::size_t std_found = 0;
+    std::size_t flat_found = 0;
+    double std_ms = measure_ms([&points, &std_found] {
+        std::unordered_set<TimePoint, XorTimePointHash> set;
+        for (const auto &tp : points) {
+            set.insert(tp);
+        }
+        for (const auto &tp : points) {
+            if (set.contains({tp.x + 1, tp.y, tp.t})) {
+                ++std_found;
+            }
+        }
+    });
+    double flat_ms = measure_ms([&points, &flat_found] {
+        FlatHashSet<TimePoint> set;
+        for (const auto &tp : points) {
+            set.insert(tp);
+        }
+        for (const auto &tp : points) {
+            if (set.contains({tp.x + 1, tp.y, tp.t})) {
+                ++flat_found;
+            }
+        }
+    });
+    if (std_found != flat_found) {
+        std::cout << "results differ!\n";
+    }
+    report("TimePoint set, " + std::to_string(points.size()) + " keys", std_ms,
+           flat_ms);
+}
+
+void bench_points(const std::vector<TimePoint> &points) {
+    std::int64_t std_sum = 0;
+    std::int64_t flat_sum = 0;
+    double std_ms = measure_ms([&points, &std_sum] {
+        std::unordered_map<Point, int> map;
+        for (const auto &tp : points) {
+            int &last = map[Point(tp.x, tp.y)];
+            last = std::max(last, tp.t);
+        }
+        for (const auto &tp : points) {
+            auto it = map.find(Point(tp.y, tp.x));
+            std_sum += it == map.end() ? 0 : it->second;
+        }
+    });
+    double flat_ms = measure_ms([&points, &flat_sum] {
+        FlatHashMap<Point, int> map;
+        for (const auto &tp : points) {
+            int &last = map[Point(tp.x, tp.y)];
+            last = std::max(last, tp.t);
+        }
+        for (const auto &tp : points) {
+            const int *last = map.find(Point(tp.y, tp.x));
+            flat_sum += last == nullptr ? 0 : *last;
+        }
+    });
+    if (std_sum != flat_sum) {
+        std::cout << "results differ!\n";
+    }
+    report("Point map, " + std::to_string(points.size()) + " accesses",
+           std_ms, flat_ms);
+}
+
+}  // namespace
+
+int main() {
+    for (int agents : {100, 500, 1000}) {
+        auto points = make_trajectories(agents, 400);
+        bench_time_points(points);
+        bench_points(points);
+    }
+    return 0;
+}
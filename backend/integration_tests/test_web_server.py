@@ -3,10 +3,31 @@ import requests
 URL_POST_SIMPLE = "http://localhost:8080/route/simple"
 URL_POST_DENSE = "http://localhost:8080/route/dense"
 URL_POST_RANDOM = "http://localhost:8080/route/random"
+URL_POST_WINDOWED = "http://localhost:8080/route/windowed"
+URL_POST_PIBT = "http://localhost:8080/route/pibt"
+URL_POST_LACAM = "http://localhost:8080/route/lacam"
+URL_POST_ECBS = "http://localhost:8080/route/ecbs"
+URL_POST_PBS = "http://localhost:8080/route/pbs"
+URL_POST_LNS = "http://localhost:8080/route/lns"
+URL_POST_FLOW = "http://localhost:8080/route/flow"
+URL_POST_FLOW_FIELD = "http://localhost:8080/route/flow_field"
+URL_POST_SOCIAL_FORCE = "http://localhost:8080/route/social_force"
+URL_POST_INCREMENTAL = "http://localhost:8080/route/incremental"
+URL_POST_GROUP = "http://localhost:8080/route/group"
 
-URL_POSTS = [URL_POST_DENSE, URL_POST_SIMPLE]
+URL_POSTS = [URL_POST_DENSE, URL_POST_SIMPLE, URL_POST_WINDOWED]
 URL_POSTS_INACCURATE = URL_POSTS[:]
 URL_POSTS_INACCURATE.append(URL_POST_RANDOM)
+URL_POSTS_INACCURATE.append(URL_POST_PIBT)
+URL_POSTS_INACCURATE.append(URL_POST_LACAM)
+URL_POSTS_INACCURATE.append(URL_POST_ECBS)
+URL_POSTS_INACCURATE.append(URL_POST_PBS)
+URL_POSTS_INACCURATE.append(URL_POST_LNS)
+URL_POSTS_INACCURATE.append(URL_POST_FLOW)
+URL_POSTS_INACCURATE.append(URL_POST_FLOW_FIELD)
+URL_POSTS_INACCURATE.append(URL_POST_SOCIAL_FORCE)
+URL_POSTS_INACCURATE.append(URL_POST_INCREMENTAL)
+URL_POSTS_INACCURATE.append(URL_POST_GROUP)
 
 def test_simple_route_good():
     data = '''
@@ -238,3 +259,731 @@ def test_complicated_route_good():
         response = requests.post(url=url_post, data=data, timeout=10)
         assert response.status_code == 200
         assert response.text == result
+
+def test_dense_stats_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 2 }
+        }
+    ],
+    "groups": [],
+    "lazy": true,
+    "congestion": true,
+    "portfolio": 3,
+    "deadline_ms": 1000,
+    "with_stats": true
+}
+    '''
+    response = requests.post(url=URL_POST_DENSE, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["routes"] == [{"id": 0, "route": ["UP"]}]
+    assert body["partial"] is False
+    assert body["stats"]["static_routes"] == 1
+    assert body["stats"]["failed_routes"] == 0
+    assert body["stats"]["portfolio_runs"] == 3
+    assert body["stats"]["waits"] == 0
+    assert body["stats"]["makespan"] == 2
+
+def test_dense_portfolio_bad():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 2 }
+        }
+    ],
+    "groups": [],
+    "portfolio": %s
+}
+    '''
+    for runs in ["-1", "0", "65", "4294967295"]:
+        response = requests.post(url=URL_POST_DENSE, data=data % runs,
+                                 timeout=10)
+        assert response.status_code == 400
+        assert "portfolio" in response.text
+
+
+def test_dense_independence_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 50, "y": 50 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 2 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 51, "y": 50 }
+        }
+    ],
+    "groups": [],
+    "independence": true,
+    "with_stats": true
+}
+    '''
+    response = requests.post(url=URL_POST_DENSE, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["routes"] == [{"id": 0, "route": ["UP"]},
+                              {"id": 1, "route": ["RIGHT"]}]
+    assert body["stats"]["groups"] == 2
+    assert body["stats"]["group_size_1"] == 2
+
+def test_budget_without_stats_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 2 }
+        }
+    ],
+    "groups": [],
+    "deadline_ms": 1000,
+    "max_expansions": 100000
+}
+    '''
+    for url_post in URL_POSTS:
+        response = requests.post(url=url_post, data=data, timeout=10)
+        assert response.status_code == 200
+        assert response.json() == [{"id": 0, "route": ["UP"]}]
+
+
+def test_dense_independence_options_bad():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 2 }
+        }
+    ],
+    "groups": [],
+    "independence": true,
+    %s
+}
+    '''
+    for option in ['"portfolio": 3',
+                   '"previous_routes": [{"id": 0, "route": ["UP"]}]']:
+        response = requests.post(url=URL_POST_DENSE, data=data % option,
+                                 timeout=10)
+        assert response.status_code == 400
+        assert "independence" in response.text
+
+
+def test_dense_previous_routes_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 50, "y": 50 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 4, "y": 1 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 51, "y": 50 }
+        }
+    ],
+    "groups": [],
+    "previous_routes": [
+        { "id": 0, "route": ["RIGHT", "WAIT", "RIGHT", "RIGHT"] },
+        { "id": 1, "route": ["UP"] }
+    ],
+    "with_stats": true
+}
+    '''
+    response = requests.post(url=URL_POST_DENSE, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["routes"] == [
+        {"id": 0, "route": ["RIGHT", "WAIT", "RIGHT", "RIGHT"]},
+        {"id": 1, "route": ["RIGHT"]}]
+    assert body["stats"]["kept_routes"] == 1
+    assert body["stats"]["searched_routes"] == 1
+
+def test_pibt_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 5, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 3, "y": 1 }
+        }
+    ],
+    "groups": [],
+    "with_stats": true
+}
+    '''
+    response = requests.post(url=URL_POST_PIBT, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["routes"] == [{"id": 0, "route": ["RIGHT", "RIGHT"]},
+                              {"id": 1, "route": ["LEFT", "WAIT", "LEFT"]}]
+    assert body["partial"] is False
+    assert body["stats"]["unfinished_routes"] == 0
+    assert body["stats"]["waits"] == 1
+    assert body["stats"]["makespan"] == 6
+
+def test_lacam_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 5, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 3, "y": 1 }
+        }
+    ],
+    "groups": [],
+    "refine": true,
+    "deadline_ms": 100,
+    "with_stats": true
+}
+    '''
+    response = requests.post(url=URL_POST_LACAM, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["partial"] is False
+    assert body["stats"]["sum_of_costs"] == 10
+    assert body["stats"]["makespan"] == 6
+
+
+def test_flow_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 3, "y": 1 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 5, "y": 1 }
+        },
+        {
+            "id": 2,
+            "position": { "x": 4, "y": 2 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 4, "y": 1 }
+        }
+    ],
+    "groups": []
+}
+    '''
+    response = requests.post(url=URL_POST_FLOW, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["partial"] is False
+    assert body["stats"]["makespan"] == 6
+    assert body["stats"]["optimal"] == 1
+    assert body["stats"]["failed_routes"] == 0
+
+
+def test_flow_field_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 4, "y": 3 }
+        }
+    ],
+    "groups": []
+}
+    '''
+    response = requests.post(url=URL_POST_FLOW_FIELD, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["partial"] is False
+    assert body["stats"]["unfinished_routes"] == 0
+    assert body["stats"]["makespan"] == 8
+
+
+def test_social_force_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 8, "y": 5 }
+        }
+    ],
+    "groups": []
+}
+    '''
+    response = requests.post(url=URL_POST_SOCIAL_FORCE, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["partial"] is False
+    assert body["stats"]["unfinished_routes"] == 0
+    assert body["stats"]["makespan"] >= 18
+
+
+def test_social_force_speed_bad():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 8, "y": 5 }
+        }
+    ],
+    "groups": [],
+    "speed": %s
+}
+    '''
+    for speed in ['0', '-1', '50']:
+        response = requests.post(url=URL_POST_SOCIAL_FORCE,
+                                 data=data % speed, timeout=10)
+        assert response.status_code == 400
+        assert "speed" in response.text
+
+
+def test_incremental_good():
+    data = '''
+{
+    "_id": "incremental",
+    "name": "Test map",
+    "up_right_point": { "x": 20, "y": 20 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [%s],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 2, "y": 10 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 17, "y": 10 }
+        }
+    ],
+    "groups": [],
+    "with_stats": true
+}
+    '''
+    response = requests.post(url=URL_POST_INCREMENTAL, data=data % "",
+                             timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["stats"]["rebuilt"] == 1
+    assert len(body["routes"][0]["route"]) == 15
+
+    # Only the moves next to the new wall are repaired
+    wall = '{ "first": { "x": 10, "y": 3 }, "second": { "x": 10, "y": 17 } }'
+    response = requests.post(url=URL_POST_INCREMENTAL, data=data % wall,
+                             timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["stats"]["rebuilt"] == 0
+    assert body["stats"]["changed_borders"] == 1
+    assert len(body["routes"][0]["route"]) > 15
+
+
+def test_group_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 30, "y": 30 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 2, "y": 2 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 3, "y": 2 }
+        },
+        {
+            "id": 2,
+            "position": { "x": 2, "y": 3 }
+        },
+        {
+            "id": 3,
+            "position": { "x": 3, "y": 3 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 25, "y": 3 }
+        }
+    ],
+    "groups": [
+        {
+            "id": 0,
+            "start_position": { "x": 2, "y": 2 },
+            "total_count": 4,
+            "person_ids": [0, 1, 2, 3]
+        }
+    ],
+    "with_stats": true
+}
+    '''
+    response = requests.post(url=URL_POST_GROUP, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["stats"]["group_searches"] == 1
+    assert body["stats"]["failed_routes"] == 0
+    assert len(body["routes"]) == 4
+
+
+def test_group_expansion_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 30, "y": 30 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 4,
+            "position": { "x": 10, "y": 2 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 25, "y": 25 }
+        }
+    ],
+    "groups": [
+        {
+            "id": 0,
+            "start_position": { "x": 2, "y": 2 },
+            "total_count": 3,
+            "person_ids": []
+        }
+    ],
+    "with_stats": true
+}
+    '''
+    for url_post in URL_POSTS:
+        response = requests.post(url=url_post, data=data, timeout=10)
+        assert response.status_code == 200
+        routes = response.json()["routes"]
+        assert sorted(route["id"] for route in routes) == [4, 5, 6, 7]
+        assert all(len(route["route"]) > 0 for route in routes)
+
+    response = requests.post(url=URL_POST_DENSE, data=data, timeout=10)
+    assert response.json()["stats"]["staggered_routes"] == 2
+
+
+def test_group_expansion_bad():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 30, "y": 30 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 25, "y": 25 }
+        }
+    ],
+    "groups": [
+        {
+            "id": 0,
+            "start_position": { "x": 2, "y": 2 },
+            "total_count": %s,
+            "person_ids": [%s]
+        }
+    ]
+}
+    '''
+    for total_count, person_ids in [("2000000000", ""), ("2", "2147483647")]:
+        response = requests.post(url=URL_POST_SIMPLE,
+                                 data=data % (total_count, person_ids),
+                                 timeout=10)
+        assert response.status_code == 400
+
+
+def test_ecbs_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 5, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 3, "y": 1 }
+        }
+    ],
+    "groups": [],
+    "suboptimality": 1.0,
+    "deadline_ms": 1000,
+    "with_stats": true
+}
+    '''
+    response = requests.post(url=URL_POST_ECBS, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["partial"] is False
+    assert body["stats"]["sum_of_costs"] == 10
+    assert body["stats"]["bound_permille"] == 1000
+
+
+def test_pbs_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 5, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 3, "y": 1 }
+        }
+    ],
+    "groups": [],
+    "deadline_ms": 1000,
+    "with_stats": true
+}
+    '''
+    response = requests.post(url=URL_POST_PBS, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["partial"] is False
+    assert body["stats"]["sum_of_costs"] == 10
+    assert body["stats"]["priority_pairs"] == 1
+
+
+def test_lns_good():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 100, "y": 100 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [
+        {
+            "id": 0,
+            "position": { "x": 1, "y": 1 }
+        },
+        {
+            "id": 1,
+            "position": { "x": 5, "y": 1 }
+        }
+    ],
+    "goals": [
+        {
+            "id": 0,
+            "position": { "x": 3, "y": 1 }
+        }
+    ],
+    "groups": [],
+    "initial": "random",
+    "deadline_ms": 500,
+    "with_stats": true
+}
+    '''
+    response = requests.post(url=URL_POST_LNS, data=data, timeout=10)
+    assert response.status_code == 200
+    body = response.json()
+    assert body["stats"]["failed_routes"] == 0
+    assert body["stats"]["sum_of_costs"] <= body["stats"]["initial_sum_of_costs"]
+    assert body["progress"][0]["iteration"] == 0
+    assert body["progress"][-1]["sum_of_costs"] == body["stats"]["sum_of_costs"]
+
+
+def test_lns_unknown_initial():
+    data = '''
+{
+    "_id": "0",
+    "name": "Test map",
+    "up_right_point": { "x": 10, "y": 10 },
+    "down_left_point": { "x": 0, "y": 0 },
+    "borders": [],
+    "persons": [],
+    "goals": [],
+    "groups": [],
+    "initial": "astar"
+}
+    '''
+    response = requests.post(url=URL_POST_LNS, data=data, timeout=10)
+    assert response.status_code == 400
+    assert response.text == "unknown initial planner astar"
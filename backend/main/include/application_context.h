@@ -2,6 +2,7 @@
 #define APPLICATION_CONTEXT_H
 
 #include <memory>
+#include <stdexcept>
 #include <vector>
 
 #include "json.hpp"
@@ -10,6 +11,13 @@
 using PlannerFactory = std::function<std::unique_ptr<Planner>(
     const std::vector<Person> &, const std::vector<Goal> &, Grid *)>;
 
+// Thrown for a well formed request with a value the service does not
+// accept, the message tells the client what is wrong
+class RequestError : public std::invalid_argument {
+ public:
+    using std::invalid_argument::invalid_argument;
+};
+
 class ApplicationContext {
  public:
     ApplicationContext() noexcept = delete;
@@ -22,6 +30,17 @@ class ApplicationContext {
     static nlohmann::json calculate_route_dense(nlohmann::json input);
     static nlohmann::json calculate_route_simple(nlohmann::json input);
     static nlohmann::json calculate_route_random(nlohmann::json input);
+    static nlohmann::json calculate_route_windowed(nlohmann::json input);
+    static nlohmann::json calculate_route_pibt(nlohmann::json input);
+    static nlohmann::json calculate_route_lacam(nlohmann::json input);
+    static nlohmann::json calculate_route_ecbs(nlohmann::json input);
+    static nlohmann::json calculate_route_pbs(nlohmann::json input);
+    static nlohmann::json calculate_route_lns(nlohmann::json input);
+    static nlohmann::json calculate_route_flow(nlohmann::json input);
+    static nlohmann::json calculate_route_flow_field(nlohmann::json input);
+    static nlohmann::json calculate_route_social_force(nlohmann::json input);
+    static nlohmann::json calculate_route_incremental(nlohmann::json input);
+    static nlohmann::json calculate_route_group(nlohmann::json input);
 
  private:
     static nlohmann::json calculate_route(nlohmann::json input,
@@ -1,11 +1,11 @@
 #ifndef CATABLE_H
 #define CATABLE_H
 
-#include <unordered_map>
-#include <unordered_set>
+#include <cstdint>
 #include <vector>
 
 #include "actions.h"
+#include "flat_hash.h"
 #include "point.h"
 
 struct TimePoint {
@@ -18,17 +18,28 @@ struct TimePoint {
     }
 };
 
-struct TimePointHash {
-    std::size_t operator()(const TimePoint& tp) const {
-        return std::hash<int>()(tp.x) ^ (std::hash<int>()(tp.y) << 1) ^
-               (std::hash<int>()(tp.t) << 2);
+// Largest |x| and |y| of a space-time key, requests with cells farther out
+// are rejected before planning
+constexpr int MAX_KEY_COORDINATE = (1 << 15) - 1;
+
+// Packs x and y into 16 bits each and t into 32 bits, so keys are exact for
+// |x|, |y| <= MAX_KEY_COORDINATE and every t >= 0
+template <>
+struct FlatHashKey<TimePoint> {
+    static std::uint64_t pack(const TimePoint& tp) noexcept {
+        constexpr std::uint64_t COORD_MASK = (std::uint64_t(1) << 16) - 1;
+        return ((std::uint64_t(static_cast<std::uint32_t>(tp.x)) & COORD_MASK)
+                << 48) |
+               ((std::uint64_t(static_cast<std::uint32_t>(tp.y)) & COORD_MASK)
+                << 32) |
+               std::uint64_t(static_cast<std::uint32_t>(tp.t));
     }
 };
 
 class CATable {
  private:
-    std::unordered_set<TimePoint, TimePointHash> _pos_time_table;
-    std::unordered_map<Point, int> _last_visit_table;
+    FlatHashSet<TimePoint> _pos_time_table;
+    FlatHashMap<Point, int> _last_visit_table;
 
  public:
     void add_trajectory(int traj_id, const std::vector<Point>& trajectory);
@@ -0,0 +1,105 @@
+#ifndef CONCURRENT_CATABLE_H
+#define CONCURRENT_CATABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "interval_catable.h"
+#include "point.h"
+
+// Reservation table with the same rules as IntervalCATable for one writer
+// thread at a time and any number of concurrent readers. Every cell points
+// to an immutable sorted array of disjoint intervals. A writer builds a new
+// array and publishes it with one atomic store, so readers never lock and
+// never wait. Each committed trajectory advances the epoch. A replaced array
+// is freed once every pinned reader has moved past the epoch that replaced
+// it.
+//
+// Readers pin one of the <reader_slots> slots for the time they hold the
+// table, a reader that runs alone with the writers may skip pinning.
+// Readers see the cells of a trajectory being committed appear one by one,
+// comparing get_epoch() before and after a search tells whether a commit
+// overlapped it.
+class ConcurrentCATable {
+ public:
+    // Unpins the slot when destroyed
+    class ReadGuard {
+     public:
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard(ReadGuard&& other) noexcept
+            : _slot(std::exchange(other._slot, nullptr)) {}
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+        ~ReadGuard() noexcept {
+            if (_slot != nullptr) {
+                _slot->store(IDLE);
+            }
+        }
+
+     private:
+        friend class ConcurrentCATable;
+        explicit ReadGuard(std::atomic<std::uint64_t>* slot) : _slot(slot) {}
+
+        std::atomic<std::uint64_t>* _slot;
+    };
+
+    ConcurrentCATable(const Point& lower_left, const Point& upper_right,
+                      std::size_t reader_slots);
+    ConcurrentCATable(const ConcurrentCATable&) = delete;
+    ConcurrentCATable(ConcurrentCATable&&) = delete;
+    ConcurrentCATable& operator=(const ConcurrentCATable&) = delete;
+    ConcurrentCATable& operator=(ConcurrentCATable&&) = delete;
+    ~ConcurrentCATable() noexcept;
+
+    // Writers are serialized with each other, never with readers
+    void add_trajectory(int traj_id, const std::vector<Point>& trajectory,
+                        int start_time = 0);
+    // Needs all readers to be gone
+    void clear();
+
+    // <reader> is below reader_slots and used by one thread at a time
+    ReadGuard pin(std::size_t reader) const;
+    std::uint64_t get_epoch() const noexcept { return _epoch.load(); }
+    bool check_move(const Point& from, const Point& to, int start_time) const;
+    int last_visited(const Point& point) const;
+    int get_horizon() const noexcept { return _horizon.load(); }
+    std::vector<Point> get_neighbors_timestep(const Point& point,
+                                              int time) const;
+
+ private:
+    using Intervals = std::vector<TimeInterval>;
+
+    static constexpr std::uint64_t IDLE =
+        std::numeric_limits<std::uint64_t>::max();
+
+    struct Retired {
+        std::uint64_t epoch;
+        std::unique_ptr<const Intervals> intervals;
+    };
+
+    Point _lower_left;
+    int _width;
+    int _height;
+    std::unique_ptr<std::atomic<const Intervals*>[]> _cells;
+    mutable std::unique_ptr<std::atomic<std::uint64_t>[]> _reader_epochs;
+    std::size_t _reader_count;
+    std::atomic<std::uint64_t> _epoch{0};
+    std::atomic<int> _horizon{-1};
+    // Guarded by _write_mutex
+    std::mutex _write_mutex;
+    std::vector<Retired> _retired;
+    std::vector<int> _used_cells;
+
+    int cell_id(int x, int y) const noexcept;
+    bool is_range_available(int x, int y, int t_from, int t_to) const;
+    void add_interval(int x, int y, TimeInterval interval);
+    void reclaim();
+};
+
+#endif  // CONCURRENT_CATABLE_H
@@ -0,0 +1,51 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "grid.h"
+#include "point.h"
+
+// Exact cost of the cheapest route to the nearest goal for every cell inside
+// the grid bounds, ignoring other persons. Built once by a multi-source
+// Dijkstra from the goals. Moves through borders are cached as a bitmask per
+// cell, so lookups never touch the border list, and every border is tested
+// only against the moves next to it.
+class DistanceField {
+ public:
+    static constexpr int UNREACHABLE = std::numeric_limits<int>::max();
+
+    // Without diagonals the costs are of routes of straight moves only
+    DistanceField(const Grid& grid, const std::vector<Point>& goals,
+                  bool with_diagonals = true);
+    DistanceField(const DistanceField&) = default;
+    DistanceField(DistanceField&&) noexcept = default;
+    DistanceField& operator=(const DistanceField&) = default;
+    DistanceField& operator=(DistanceField&&) noexcept = default;
+    ~DistanceField() noexcept = default;
+
+    bool is_inside(const Point& cell) const noexcept;
+    int get_distance(const Point& cell) const noexcept;
+    // <to> must be <from> itself or one of its neighbours
+    bool is_valid_move(const Point& from, const Point& to) const noexcept;
+    // Neighbour on a cheapest route, nothing at goals and unreachable cells
+    std::optional<Point> get_next(const Point& cell) const;
+
+ private:
+    Point _lower_left;
+    int _width;
+    int _height;
+    std::vector<int> _distances;
+    // bit k is set if the move along DIRECTIONS[k] stays inside the grid and
+    // does not cross a border
+    std::vector<std::uint8_t> _moves;
+
+    int cell_id(const Point& cell) const noexcept;
+    void remove_crossed_moves(const Border& border);
+    static int direction_index(const Point& from, const Point& to) noexcept;
+};
+
+#endif  // DISTANCE_FIELD_H
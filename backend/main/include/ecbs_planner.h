@@ -0,0 +1,141 @@
+#ifndef ECBS_PLANNER_H
+#define ECBS_PLANNER_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "flat_hash.h"
+#include "planner.h"
+
+struct EcbsOptions {
+    // The sum of costs found is at most this many times the cheapest one
+    double suboptimality = 1.2;
+    // High-level nodes after which the conflicts left are given up
+    int max_nodes = 10000;
+};
+
+// Enhanced conflict-based search (ECBS). Every person is planned alone by a
+// focal search over cells and ticks, and when two routes collide, the search
+// branches: one of the two persons must keep away from the cell at the tick
+// of the collision, or from the move in case of a swap. Both levels expand
+// the node with the fewest collisions among the ones no costlier than the
+// cheapest lower bound times the suboptimality, so the routes found cost at
+// most that much more than the cheapest ones.
+//
+// A constraint on a cell at a tick forbids every action that keeps the
+// person in the cell at the tick, not only the ones arriving then, so a
+// wait of 2 ticks or a diagonal of 3 ticks is checked over its whole
+// duration. Collisions are found on the intervals a person stays in a cell,
+// the same as the ones reserved by CATable.
+//
+// When the budget or the nodes run out before the routes are free of
+// collisions, the persons still colliding are left standing where they are.
+class EcbsPlanner : public Planner {
+ public:
+    EcbsPlanner(const std::vector<Person>& persons,
+                const std::vector<Goal>& goals, Grid* grid,
+                EcbsOptions options = {});
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    // Ticks from <start> to <end> a person stays in a cell
+    struct Visit {
+        int cell;
+        int start;
+        int end;
+    };
+
+    struct Path {
+        std::vector<Action> actions;
+        std::vector<Visit> visits;
+        int cost;
+        // No route of the person under its constraints is cheaper
+        int lower_bound;
+    };
+
+    using Paths = std::vector<std::shared_ptr<const Path>>;
+
+    // Person <agent> may not stay in <cell> at <time>, or with <move> > 0,
+    // may not take the move MOVES[move] from <cell> arriving at <time>
+    struct Constraint {
+        int agent;
+        int cell;
+        int move;
+        int time;
+    };
+
+    // Person <agent> collides with <other> in <cell> at <time>, or with
+    // <move> > 0, by the move MOVES[move] from <cell> arriving at <time>
+    struct Conflict {
+        int agent;
+        int other;
+        int cell;
+        int move;
+        int time;
+    };
+
+    struct HighNode {
+        int parent;
+        Constraint constraint;
+        Paths paths;
+        std::int64_t cost;
+        std::int64_t lower_bound;
+        std::int64_t conflicts;
+    };
+
+    struct LowNode {
+        int cell;
+        int time;
+        int parent;
+        int move;
+        int conflicts;
+        bool is_closed;
+    };
+
+    // Route of <agent> under the constraints of high-level node <node>,
+    // colliding with <paths> as little as possible, nullptr if none is found
+    std::shared_ptr<const Path> plan_path(int agent, const Paths& paths,
+                                          int node);
+    void open_node(int node);
+    void close_node(int node);
+    // Keeps the focal nodes no costlier than the suboptimality times
+    // <lower_bound>
+    void update_focal(std::int64_t lower_bound);
+    std::vector<Conflict> find_conflicts(const Paths& paths) const;
+    // Leaves standing the persons still colliding in <paths>
+    Paths drop_conflicting(Paths paths);
+    Path make_path(int agent, std::vector<Action> actions,
+                   int lower_bound) const;
+    int cell_id(const Point& cell) const noexcept;
+    Point to_point(int cell) const noexcept;
+    static std::uint64_t pack(int cell, int move, int time) noexcept;
+
+    EcbsOptions _options;
+    DistanceField _field;
+    Point _lower_left;
+    int _width;
+    int _height;
+    std::vector<int> _starts;
+    // Cells of persons that stand where they are forever
+    std::vector<char> _blocked;
+    std::vector<HighNode> _nodes;
+    // Open high-level nodes by lower bound, by cost and the focal ones by
+    // collisions
+    std::set<std::pair<std::int64_t, int>> _by_lower_bound;
+    std::set<std::pair<std::int64_t, int>> _by_cost;
+    std::set<std::tuple<std::int64_t, std::int64_t, int>> _focal;
+    std::int64_t _focal_bound;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // ECBS_PLANNER_H
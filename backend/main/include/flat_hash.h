@@ -0,0 +1,195 @@
+#ifndef FLAT_HASH_H
+#define FLAT_HASH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "point.h"
+
+// Keys are packed into 64 bits before hashing, specialize FlatHashKey for
+// every key type
+template <typename Key>
+struct FlatHashKey;
+
+template <>
+struct FlatHashKey<Point> {
+    static std::uint64_t pack(const Point &point) noexcept {
+        return (std::uint64_t(static_cast<std::uint32_t>(point.get_x()))
+                << 32) |
+               std::uint64_t(static_cast<std::uint32_t>(point.get_y()));
+    }
+};
+
+// Keys that are hashes of larger objects already
+template <>
+struct FlatHashKey<std::uint64_t> {
+    static std::uint64_t pack(std::uint64_t key) noexcept { return key; }
+};
+
+// Open-addressing hash map with linear probing. All slots live in flat
+// arrays, so a probe sequence touches neighbouring memory only. There is no
+// erase: planners only fill their sets and clear them as a whole.
+template <typename Key, typename Value>
+class FlatHashMap {
+ public:
+    FlatHashMap() = default;
+    FlatHashMap(const FlatHashMap &) = default;
+    FlatHashMap(FlatHashMap &&other) noexcept
+        : _keys(std::move(other._keys)),
+          _values(std::move(other._values)),
+          _used(std::move(other._used)),
+          _size(std::exchange(other._size, 0)) {}
+    FlatHashMap &operator=(const FlatHashMap &) = default;
+    FlatHashMap &operator=(FlatHashMap &&other) noexcept {
+        _keys = std::move(other._keys);
+        _values = std::move(other._values);
+        _used = std::move(other._used);
+        _size = std::exchange(other._size, 0);
+        return *this;
+    }
+    ~FlatHashMap() noexcept = default;
+
+    std::size_t size() const noexcept { return _size; }
+    bool empty() const noexcept { return _size == 0; }
+
+    void clear() noexcept {
+        std::fill(_used.begin(), _used.end(), std::uint8_t(0));
+        _size = 0;
+    }
+
+    void reserve(std::size_t count) {
+        std::size_t capacity = MIN_CAPACITY;
+        while (capacity < count * 2) {
+            capacity *= 2;
+        }
+        if (capacity > _keys.size()) {
+            rehash(capacity);
+        }
+    }
+
+    bool contains(const Key &key) const noexcept {
+        return find_slot(FlatHashKey<Key>::pack(key)) != NOT_FOUND;
+    }
+
+    const Value *find(const Key &key) const noexcept {
+        std::size_t slot = find_slot(FlatHashKey<Key>::pack(key));
+        return slot == NOT_FOUND ? nullptr : &_values[slot];
+    }
+
+    Value *find(const Key &key) noexcept {
+        std::size_t slot = find_slot(FlatHashKey<Key>::pack(key));
+        return slot == NOT_FOUND ? nullptr : &_values[slot];
+    }
+
+    bool insert(const Key &key, Value value) {
+        auto [slot, inserted] = insert_slot(FlatHashKey<Key>::pack(key));
+        if (inserted) {
+            _values[slot] = std::move(value);
+        }
+        return inserted;
+    }
+
+    Value &operator[](const Key &key) {
+        auto [slot, inserted] = insert_slot(FlatHashKey<Key>::pack(key));
+        if (inserted) {
+            _values[slot] = Value();
+        }
+        return _values[slot];
+    }
+
+ private:
+    static constexpr std::size_t MIN_CAPACITY = 16;
+    static constexpr std::size_t NOT_FOUND = ~std::size_t(0);
+
+    std::vector<std::uint64_t> _keys;
+    std::vector<Value> _values;
+    std::vector<std::uint8_t> _used;
+    std::size_t _size = 0;
+
+    static std::uint64_t mix(std::uint64_t key) noexcept {
+        // murmur3 finalizer: neighbouring cells must not land in
+        // neighbouring slots
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    std::size_t find_slot(std::uint64_t key) const noexcept {
+        if (_keys.empty()) {
+            return NOT_FOUND;
+        }
+        std::size_t mask = _keys.size() - 1;
+        for (std::size_t slot = std::size_t(mix(key)) & mask;;
+             slot = (slot + 1) & mask) {
+            if (_used[slot] == 0) {
+                return NOT_FOUND;
+            }
+            if (_keys[slot] == key) {
+                return slot;
+            }
+        }
+    }
+
+    std::pair<std::size_t, bool> insert_slot(std::uint64_t key) {
+        if ((_size + 1) * 2 > _keys.size()) {
+            rehash(_keys.empty() ? MIN_CAPACITY : _keys.size() * 2);
+        }
+        std::size_t mask = _keys.size() - 1;
+        for (std::size_t slot = std::size_t(mix(key)) & mask;;
+             slot = (slot + 1) & mask) {
+            if (_used[slot] == 0) {
+                _used[slot] = 1;
+                _keys[slot] = key;
+                ++_size;
+                return {slot, true};
+            }
+            if (_keys[slot] == key) {
+                return {slot, false};
+            }
+        }
+    }
+
+    void rehash(std::size_t capacity) {
+        std::vector<std::uint64_t> keys(capacity);
+        std::vector<Value> values(capacity);
+        std::vector<std::uint8_t> used(capacity, 0);
+        std::size_t mask = capacity - 1;
+        for (std::size_t old_slot = 0; old_slot < _keys.size(); ++old_slot) {
+            if (_used[old_slot] == 0) {
+                continue;
+            }
+            std::size_t slot = std::size_t(mix(_keys[old_slot])) & mask;
+            while (used[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            used[slot] = 1;
+            keys[slot] = _keys[old_slot];
+            values[slot] = std::move(_values[old_slot]);
+        }
+        _keys = std::move(keys);
+        _values = std::move(values);
+        _used = std::move(used);
+    }
+};
+
+template <typename Key>
+class FlatHashSet {
+ public:
+    std::size_t size() const noexcept { return _map.size(); }
+    bool empty() const noexcept { return _map.empty(); }
+    void clear() noexcept { _map.clear(); }
+    void reserve(std::size_t count) { _map.reserve(count); }
+    bool contains(const Key &key) const noexcept { return _map.contains(key); }
+    bool insert(const Key &key) { return _map.insert(key, Empty{}); }
+
+ private:
+    struct Empty {};
+    FlatHashMap<Key, Empty> _map;
+};
+
+#endif  // FLAT_HASH_H
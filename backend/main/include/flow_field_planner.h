@@ -0,0 +1,51 @@
+#ifndef FLOW_FIELD_PLANNER_H
+#define FLOW_FIELD_PLANNER_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "planner.h"
+
+// Flow field crowd mode for very large crowds. The distance field is turned
+// into a few preferred moves per cell once, then every tick each ready
+// person takes the first of them to a free cell, or waits. Nobody searches
+// or cooperates, so routes are only locally free of collisions and persons
+// may get stuck, but a tick costs a few array lookups per deciding person.
+//
+// Moves cost the same ticks as in RandomPlanner and a cell holds one person:
+// it is taken when a person decides to move there and freed when the person
+// leaving it arrives, before anybody decides at that tick. Persons vanish
+// when they arrive at a goal. Positions and decision ticks are kept as
+// arrays of cells, not Person objects, and the occupancy as a dense grid.
+class FlowFieldPlanner : public Planner {
+ public:
+    FlowFieldPlanner(const std::vector<Person>& persons,
+                     const std::vector<Goal>& goals, Grid* grid);
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    static constexpr std::size_t MAX_CHOICES = 4;
+
+    int cell_id(const Point& cell) const noexcept;
+    Point to_point(int cell) const noexcept;
+
+    DistanceField _field;
+    Point _lower_left;
+    int _width;
+    int _height;
+    // Offset of the neighbour cell id for every move
+    std::array<int, 8> _offsets;
+    // Moves to strictly closer neighbours by cell, the cheapest first, 4 bits
+    // each and 0xF after the last one
+    std::vector<std::uint16_t> _choices;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // FLOW_FIELD_PLANNER_H
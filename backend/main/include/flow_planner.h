@@ -0,0 +1,79 @@
+#ifndef FLOW_PLANNER_H
+#define FLOW_PLANNER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "planner.h"
+
+// Anonymous (unlabeled) planning by maximum flow. Any person may use any
+// goal, so routes for a horizon of T steps exist exactly when the network of
+// cells copied for every step carries one unit of flow from every start to
+// the goals: a cell holds one person per step, a person moves to a
+// neighbour or waits, and one gadget per pair of neighbours and step lets
+// only one of them cross, so nobody swaps. Cells too far from the starts or
+// from the goals for the step are left out.
+//
+// The horizon starts at the longest static distance and grows until the
+// flow is full, then binary search finds the smallest one. Every network
+// starts with the routes of the largest horizon known to be too short,
+// which stay valid in longer networks, and only augments them. The flow is
+// split into the routes of the persons at the end, so the makespan is the
+// smallest possible for routes of synchronous steps.
+//
+// Persons sharing a start cell, as the members of a group expanded by the
+// server, queue there the same as in the prioritized planner: the k-th of
+// them enters the network k steps late, after the ones before have left.
+//
+// All persons step together, so only straight moves and waits of 2 ticks
+// are used, as in LaCAM. When even the longest horizon tried or the budget
+// is not enough, the persons that can not reach a goal by then stop where
+// the flow leaves them.
+class FlowPlanner : public Planner {
+ public:
+    FlowPlanner(const std::vector<Person>& persons,
+                const std::vector<Goal>& goals, Grid* grid);
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    // Cells of the route of every mover by step
+    using Paths = std::vector<std::vector<int>>;
+
+    struct FlowResult {
+        Paths paths;
+        // Every mover reached a goal
+        bool complete = false;
+        // The budget ran out before the flow was maximal
+        bool cut = false;
+    };
+
+    // Maximum flow for <horizon> steps starting with <seed>, the routes of
+    // the movers that reach a goal. With <with_stops> a person may also end
+    // anywhere at the horizon and every mover gets a route.
+    FlowResult solve(int horizon, const Paths& seed, bool with_stops);
+    std::vector<Action> to_route(const std::vector<int>& path) const;
+    int cell_id(const Point& cell) const noexcept;
+    Point to_point(int cell) const noexcept;
+
+    DistanceField _field;
+    Point _lower_left;
+    int _width;
+    int _height;
+    // Steps from the nearest start and to the nearest goal by cell
+    std::vector<int> _from_starts;
+    std::vector<int> _to_goals;
+    // Cells of persons that can not reach any goal and never move
+    std::vector<char> _blocked;
+    std::vector<int> _movers;
+    // Steps every mover waits for the movers before it in its start cell
+    std::vector<int> _delays;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // FLOW_PLANNER_H
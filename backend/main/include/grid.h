@@ -21,6 +21,7 @@ class Grid {
     bool is_incorrect_move(const Segment &route) const noexcept;
     Point get_lower_left() const noexcept;
     Point get_upper_right() const noexcept;
+    const std::vector<Border> &get_borders() const noexcept;
 
  private:
     std::vector<Border> _borders;
@@ -0,0 +1,90 @@
+#ifndef GROUP_PLANNER_H
+#define GROUP_PLANNER_H
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "flat_hash.h"
+#include "interval_catable.h"
+#include "planner.h"
+
+struct GroupOptions {
+    // Indices of the persons of every group, persons of no group move alone
+    std::vector<std::vector<int>> groups;
+};
+
+// Plans every group as one meta-agent. The members keep the shape they
+// start in and the whole formation is searched for at once: a state is the
+// cell of the leader, the member nearest to a goal, and a tick, and a step
+// moves every member the same way, so it must be free for all of them. The
+// search ends when the leader is at a goal. Only then the formation breaks
+// up: the other members search the few cells left to a goal one by one,
+// nearest first, while the ones still waiting block their cells. A group of
+// n members costs one long search and n - 1 short ones instead of n long
+// ones.
+//
+// Groups are planned shortest first against the reservations of the groups
+// before them, as in the prioritized planner, and persons of no group are
+// groups of one. A formation that can not get through, for example a
+// corridor narrower than it, splits and its members are searched alone.
+// Persons left without a route stand where they are, they become stops and
+// planning starts again while the budget lasts.
+//
+// Members sharing a start cell, as the ones of a group expanded by the
+// server, are not in the formation twice: the first one is, and the others
+// queue behind it as in the prioritized planner, taking its route a few
+// ticks later. Only if no such delay is free a follower is searched alone.
+class GroupPlanner : public Planner {
+ public:
+    GroupPlanner(const std::vector<Person>& persons,
+                 const std::vector<Goal>& goals, Grid* grid,
+                 GroupOptions options = {});
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    struct Formation {
+        // The leader comes first
+        std::vector<int> members;
+        // Start of every member relative to the start of the leader
+        std::vector<std::pair<int, int>> offsets;
+        // Persons queued in the start cell of every member, in order
+        std::vector<std::vector<int>> followers;
+    };
+
+    std::vector<Formation> make_formations() const;
+    void plan_formation(const Formation& formation,
+                        std::vector<std::vector<Action>>& routes,
+                        std::int64_t searches_left);
+    void plan_alone(const Formation& formation,
+                    std::vector<std::vector<Action>>& routes,
+                    std::int64_t searches_left);
+    // Plans the followers of the formation, whose members are planned
+    void commit_followers(const Formation& formation,
+                          std::vector<std::vector<Action>>& routes,
+                          std::int64_t searches_left);
+    // Moves of the formation until the leader is at a goal
+    std::optional<std::vector<Action>> search_formation(
+        const Formation& formation, int max_steps, int& expansions);
+    bool can_move(const Formation& formation, const Point& leader,
+                  Action action, int time) const;
+    std::optional<std::vector<Action>> search_alone(
+        const Point& start, int start_time, const FlatHashSet<Point>& stops,
+        int max_steps, int& expansions);
+    void reserve(const Point& start, const std::vector<Action>& route);
+
+    GroupOptions _options;
+    DistanceField _field;
+    IntervalCATable _table;
+    FlatHashSet<Point> _stops;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // GROUP_PLANNER_H
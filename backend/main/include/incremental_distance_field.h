@@ -0,0 +1,98 @@
+#ifndef INCREMENTAL_DISTANCE_FIELD_H
+#define INCREMENTAL_DISTANCE_FIELD_H
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "distance_field.h"
+#include "grid.h"
+#include "point.h"
+#include "search_budget.h"
+
+// Distance field of one map that survives border edits (LPA*, the static
+// core of D* Lite). Every cell keeps its distance g and the one-step
+// lookahead rhs, the minimum over its neighbours of their distance plus the
+// move cost. A border edit only changes the moves next to the border, those
+// cells and their neighbours become inconsistent (g != rhs) and are queued,
+// and repairs spread from them until the distances of the persons' cells are
+// exact again. Cells the edit does not affect are never touched.
+//
+// The field is built with DistanceField on the first update and after the
+// bounds or goals change. A repair cut by the budget leaves the queue as it
+// is, so the next one goes on from there. The field is not thread safe,
+// planners sharing it lock get_mutex() around update, repair and reads.
+class IncrementalDistanceField {
+ public:
+    static constexpr int UNREACHABLE = DistanceField::UNREACHABLE;
+
+    // Counters of the last update and repair calls
+    struct Changes {
+        bool rebuilt = false;
+        std::int64_t borders = 0;
+        std::int64_t moves = 0;
+        std::int64_t repaired_cells = 0;
+    };
+
+    IncrementalDistanceField() = default;
+    IncrementalDistanceField(const IncrementalDistanceField&) = delete;
+    IncrementalDistanceField& operator=(const IncrementalDistanceField&) =
+        delete;
+    ~IncrementalDistanceField() noexcept = default;
+
+    // Brings the moves to the borders of <grid>. Distances stay as they are
+    // until repair, unless the field is built from scratch.
+    void update(const Grid& grid, const std::vector<Point>& goals);
+    // Repairs distances until those of <targets> are exact. Returns false if
+    // the budget ran out first.
+    bool repair(const std::vector<Point>& targets, SearchBudget& budget);
+
+    // Exact only where is_exact holds
+    int get_distance(const Point& cell) const noexcept;
+    // Neighbour on a cheapest route, nothing at goals and unreachable cells
+    std::optional<Point> get_next(const Point& cell) const;
+    // The distance of <cell> is final, so are those along its route
+    bool is_exact(const Point& cell) const noexcept;
+    const Changes& get_changes() const noexcept { return _changes; }
+    std::mutex& get_mutex() noexcept { return _mutex; }
+
+ private:
+    using QueueItem = std::pair<int, int>;
+    using Segments = std::vector<std::array<int, 4>>;
+
+    int cell_id(const Point& cell) const noexcept;
+    void rebuild(const Grid& grid, const std::vector<Point>& goals);
+    // Recomputes the moves of the cells around <changed> against <borders>
+    // and queues the cells whose moves differ
+    void update_moves(const std::array<int, 4>& changed,
+                      const Segments& borders);
+    void update_cell(int id);
+    int get_key(int id) const noexcept;
+
+    std::mutex _mutex;
+    Point _lower_left = Point(0, 0);
+    Point _upper_right = Point(-1, -1);
+    // Goals and borders of the last update, each sorted
+    std::vector<Point> _goals;
+    Segments _borders;
+    int _width = 0;
+    int _height = 0;
+    std::array<int, 8> _offsets{};
+    std::vector<int> _g;
+    std::vector<int> _rhs;
+    // bit k is set if the move along Point::get_neighbors()[k] is valid
+    std::vector<std::uint8_t> _moves;
+    std::vector<std::uint8_t> _is_goal;
+    // Inconsistent cells by key min(g, rhs), entries with an outdated key
+    // are skipped
+    std::priority_queue<QueueItem, std::vector<QueueItem>,
+                        std::greater<QueueItem>>
+        _open;
+    Changes _changes;
+};
+
+#endif  // INCREMENTAL_DISTANCE_FIELD_H
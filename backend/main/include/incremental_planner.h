@@ -0,0 +1,34 @@
+#ifndef INCREMENTAL_PLANNER_H
+#define INCREMENTAL_PLANNER_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "actions.h"
+#include "incremental_distance_field.h"
+#include "planner.h"
+
+// Independent cheapest routes, the same as SimplePlanner gives, read off an
+// incremental distance field. The field is meant to outlive the planner: the
+// server keeps one per map, so when only some borders changed since the last
+// request of the map, the next one repairs the distances next to them
+// instead of searching again. Planners sharing a field run one at a time.
+class IncrementalPlanner : public Planner {
+ public:
+    IncrementalPlanner(const std::vector<Person>& persons,
+                       const std::vector<Goal>& goals, Grid* grid,
+                       std::shared_ptr<IncrementalDistanceField> field =
+                           std::make_shared<IncrementalDistanceField>());
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    std::shared_ptr<IncrementalDistanceField> _field;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // INCREMENTAL_PLANNER_H
@@ -0,0 +1,61 @@
+#ifndef INDEPENDENCE_PLANNER_H
+#define INDEPENDENCE_PLANNER_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "distance_field.h"
+#include "planner.h"
+#include "prioritized_planner.h"
+
+struct IndependenceOptions {
+    // Groups planned concurrently, 0 means one per hardware thread
+    unsigned threads = 0;
+    // Options of the planner of every group
+    PrioritizedOptions planner;
+};
+
+// Independence detection. Every person starts with the static shortest
+// route, as if alone on the map. Persons of different groups that are in one
+// cell within one tick of each other are merged into one group, and every
+// changed group is planned again by its own prioritized planner, the groups
+// of one round in parallel. Rounds repeat until no two groups interact, at
+// worst everybody ends up in one group planned as a whole.
+//
+// A person without a route occupies the start cell forever, the same as in
+// the prioritized planner.
+class IndependencePlanner : public Planner {
+ public:
+    IndependencePlanner(const std::vector<Person>& persons,
+                        const std::vector<Goal>& goals, Grid* grid,
+                        IndependenceOptions options = {});
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    struct GroupResult {
+        std::vector<std::vector<Action>> routes;
+        std::map<std::string, std::int64_t> stats;
+        bool partial = false;
+    };
+
+    // Every group is planned over the one distance field of the goals
+    GroupResult plan_group(const std::vector<int>& members,
+                           std::shared_ptr<const DistanceField> field) const;
+    // Pairs of persons of different groups that interact, <group_of> maps a
+    // person to its group
+    std::vector<std::pair<int, int>> find_interactions(
+        const std::vector<std::vector<Action>>& routes,
+        const std::vector<int>& group_of) const;
+
+    IndependenceOptions _options;
+    std::vector<Goal> _goal_list;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // INDEPENDENCE_PLANNER_H
@@ -0,0 +1,87 @@
+#ifndef INTERVAL_CATABLE_H
+#define INTERVAL_CATABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "point.h"
+
+// Closed range of ticks [start, end] during which a cell is reserved
+struct TimeInterval {
+    int start;
+    int end;
+};
+
+// Reservation table with the same rules as CATable, but every cell keeps a
+// sorted list of disjoint occupied intervals instead of one entry per tick.
+// Cells are indexed densely inside a box that grows with the reserved cells up
+// to the grid bounds, so a table of a few persons stays small on a large map.
+// Cells outside the grid bounds are always free. Every change is written to an undo log, so the table can go back to
+// the state after any earlier trajectory in time proportional to the changes
+// made since then.
+class IntervalCATable {
+ public:
+    IntervalCATable(const Point& lower_left, const Point& upper_right);
+    IntervalCATable(const IntervalCATable&) = default;
+    IntervalCATable(IntervalCATable&&) noexcept = default;
+    IntervalCATable& operator=(const IntervalCATable&) = default;
+    IntervalCATable& operator=(IntervalCATable&&) noexcept = default;
+    ~IntervalCATable() noexcept = default;
+
+    // The trajectory starts at <start_time> instead of zero
+    void add_trajectory(int traj_id, const std::vector<Point>& trajectory,
+                        int start_time = 0);
+    bool check_move(const Point& from, const Point& to, int start_time) const;
+    int last_visited(const Point& point) const;
+    // Reserved ticks of the cell over all time
+    int get_reserved_ticks(const Point& point) const;
+    // Last reserved tick over all cells, -1 for the empty table
+    int get_horizon() const noexcept { return _horizon; }
+    // Trajectories added since the last clear
+    std::size_t get_trajectory_count() const noexcept {
+        return _trajectory_marks.size();
+    }
+    // Removes every trajectory added after the first <trajectory_count> ones
+    void rollback(std::size_t trajectory_count);
+    std::vector<Point> get_neighbors_timestep(const Point& point,
+                                              int time) const;
+    void clear();
+
+ private:
+    // add_interval replaced <absorbed_count> intervals of <cell> starting at
+    // <position> by one, the replaced ones are kept in _undo_intervals
+    struct UndoEntry {
+        int cell;
+        std::uint32_t position;
+        std::uint32_t absorbed_begin;
+        std::uint32_t absorbed_count;
+        bool new_slot;
+        int previous_horizon;
+    };
+
+    Point _lower_left;
+    Point _upper_right;
+    // Indexed box, empty until the first reservation
+    Point _index_lower_left;
+    int _width = 0;
+    int _height = 0;
+    // cell id -> index in _intervals plus one, zero for never reserved cells
+    std::vector<std::uint32_t> _cell_slots;
+    std::vector<std::vector<TimeInterval>> _intervals;
+    std::vector<int> _slot_cells;
+    int _horizon = -1;
+    std::vector<UndoEntry> _undo_log;
+    std::vector<TimeInterval> _undo_intervals;
+    // Size of the undo log before every trajectory
+    std::vector<std::size_t> _trajectory_marks;
+
+    int cell_id(int x, int y) const noexcept;
+    // Grows the indexed box to hold the cell, which is inside the bounds
+    void grow_index(int x, int y);
+    bool is_range_available(int x, int y, int t_from, int t_to) const;
+    const std::vector<TimeInterval>* get_intervals(int x, int y) const;
+    void add_interval(int x, int y, TimeInterval interval);
+};
+
+#endif  // INTERVAL_CATABLE_H
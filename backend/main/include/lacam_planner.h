@@ -0,0 +1,110 @@
+#ifndef LACAM_PLANNER_H
+#define LACAM_PLANNER_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "distance_field.h"
+#include "flat_hash.h"
+#include "planner.h"
+
+struct LacamOptions {
+    // Keep improving the first solution until the budget runs out
+    bool refine = false;
+    // Seeds the order in which the constraints are tried
+    unsigned seed = 0;
+};
+
+// Lazy search over configurations of all persons (LaCAM). A configuration
+// holds the cell of every person after one synchronous step, its successor
+// is generated by PIBT, and when PIBT leads into a configuration seen
+// before, the node is visited again with one more person forced to a
+// certain cell. The constraints of a node are tried breadth-first, so every
+// successor is eventually tried and a solution is found whenever the
+// persons can reach the goals at all. With refinement the search goes on
+// after the first solution, reconnects the configurations reached by a
+// cheaper way (LaCAM*) and returns the cheapest solution found.
+//
+// All persons step together, so only straight moves and waits of 2 ticks
+// are used: a diagonal of 3 ticks would break the step. Persons vanish at
+// the goals, as in the other planners.
+class LacamPlanner : public Planner {
+ public:
+    LacamPlanner(const std::vector<Person>& persons,
+                 const std::vector<Goal>& goals, Grid* grid,
+                 LacamOptions options = {});
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    // Cell of every moving person, VANISHED once it left a goal
+    using Configuration = std::vector<int>;
+
+    // Persons forced to cells, one more than in the parent constraint
+    struct Constraint {
+        std::vector<int> who;
+        std::vector<int> where;
+    };
+
+    struct Node {
+        Configuration cells;
+        int parent;
+        // Ticks all persons spent to get here and at least to the goals
+        std::int64_t cost;
+        std::int64_t estimate;
+        // Ticks the persons still on the way spend on one step
+        std::int64_t step_cost;
+        std::vector<Constraint> constraints;
+        std::size_t next_constraint;
+        // Nodes reached from this one, to reconnect cheaper ways
+        std::vector<int> successors;
+        // Next node with the same hash
+        int next_same_hash;
+    };
+
+    bool generate(const Node& node, const Constraint& constraint,
+                  Configuration& next);
+    bool push(int person, const Configuration& cells, Configuration& next);
+    int add_node(Configuration cells, int parent);
+    int find_node(const Configuration& cells, std::uint64_t hash) const;
+    void reconnect(int from, int to, std::vector<int>& open);
+    void offer_goal(int node);
+    std::vector<int> get_order(const Configuration& cells) const;
+    // The cell itself and the cells a straight move leads to
+    std::size_t get_moves(int cell, std::array<int, 5>& moves) const;
+    bool is_present(int cell) const noexcept;
+    int cell_id(const Point& cell) const noexcept;
+    Point to_point(int cell) const noexcept;
+    std::vector<std::vector<Action>> extract_routes(int node) const;
+
+    LacamOptions _options;
+    DistanceField _field;
+    Point _lower_left;
+    int _width;
+    int _height;
+    std::mt19937 _generator;
+    // Persons that have to move, the rest stay where they are
+    std::vector<int> _movers;
+    // Movers by the cost of their way, the longest first
+    std::vector<int> _priority;
+    // Cost of the way to a goal from every cell by straight moves
+    std::vector<int> _distances;
+    // Cells of persons that can not reach any goal
+    std::vector<char> _blocked;
+    // Mover standing at every cell and mover going to every cell
+    std::vector<int> _holders;
+    std::vector<int> _next_holders;
+    std::vector<Node> _nodes;
+    FlatHashMap<std::uint64_t, int> _explored;
+    // Cheapest node with every person at a goal, -1 until one is found
+    int _goal;
+    std::int64_t _goal_cost;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // LACAM_PLANNER_H
@@ -0,0 +1,104 @@
+#ifndef LNS_PLANNER_H
+#define LNS_PLANNER_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "interval_catable.h"
+#include "planner.h"
+
+// Best routes found so far, reported after the initial planner and after
+// every improvement
+struct LnsProgress {
+    // Neighborhoods tried before this solution, 0 for the initial one
+    std::int64_t iteration;
+    std::int64_t failed_routes;
+    std::int64_t sum_of_costs;
+    std::int64_t makespan;
+};
+
+struct LnsOptions {
+    // Persons destroyed and planned again in every neighborhood
+    unsigned neighborhood = 8;
+    // Neighborhoods tried before giving up, the deadline usually ends the
+    // search earlier
+    unsigned iterations = 1000;
+    // Neighborhoods repaired concurrently, 0 means one per hardware thread
+    unsigned threads = 0;
+    unsigned seed = 0;
+    // Called on the planning thread, so it must not block for long. The lns
+    // endpoint answers the reports as "progress".
+    std::function<void(const LnsProgress&)> on_improvement;
+};
+
+// Anytime large neighborhood search (MAPF-LNS). The initial planner finds
+// some routes, then rounds of neighborhoods improve them until the budget,
+// the iterations or the lower bound end the search. Every worker of a round
+// takes another group of persons, forgets their routes and plans them again
+// one by one in random order around the routes of everybody else, the same
+// space-time search as in the prioritized planner. Of the repaired groups
+// the best one replaces the routes of the round when it has fewer failed
+// persons, then a smaller sum of costs, then a smaller makespan.
+//
+// Groups are chosen in turn among random persons, the persons crossing the
+// shortest route of a delayed person and the persons passing near a random
+// cell. A repair stopped by the budget is thrown away, so the routes are
+// always the best ones found before the deadline.
+class LnsPlanner : public Planner {
+ public:
+    LnsPlanner(const std::vector<Person>& persons,
+               const std::vector<Goal>& goals, Grid* grid,
+               std::unique_ptr<Planner> initial, LnsOptions options = {});
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    enum class NeighborhoodKind { RANDOM, AGENT, MAP };
+
+    struct Solution {
+        std::vector<std::vector<Action>> routes;
+        std::vector<int> costs;
+        std::vector<char> failed;
+        std::int64_t failed_count = 0;
+        std::int64_t sum_of_costs = 0;
+        std::int64_t makespan = 0;
+    };
+
+    struct Repair {
+        std::vector<int> members;
+        std::vector<std::vector<Action>> routes;
+        std::int64_t expansions = 0;
+        // Every member got a route before the budget ran out
+        bool complete = false;
+    };
+
+    Solution evaluate(std::vector<std::vector<Action>> routes) const;
+    std::vector<int> choose_neighborhood(const Solution& solution,
+                                         NeighborhoodKind kind,
+                                         std::mt19937& random) const;
+    // New routes of <members> around the routes of everybody else, <table>
+    // is the worker's own and is cleared first
+    Repair repair(const Solution& solution, std::vector<int> members,
+                  std::mt19937& random, IntervalCATable& table) const;
+    std::vector<Point> to_trajectory(int agent,
+                                     const std::vector<Action>& route) const;
+    static bool is_better(const Solution& lhs, const Solution& rhs);
+    void report(const Solution& solution, std::int64_t iteration) const;
+
+    std::unique_ptr<Planner> _initial;
+    LnsOptions _options;
+    DistanceField _field;
+    // Persons that are not at a goal and can reach one
+    std::vector<int> _movers;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // LNS_PLANNER_H
@@ -0,0 +1,95 @@
+#ifndef PBS_PLANNER_H
+#define PBS_PLANNER_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "flat_hash.h"
+#include "interval_catable.h"
+#include "planner.h"
+#include "space_time_search.h"
+
+struct PbsOptions {
+    // Priority orders tried after which the collisions left are given up
+    int max_nodes = 10000;
+};
+
+// Priority-based search (PBS). Persons start without priorities, each on its
+// cheapest route as if alone. When two persons collide, the search branches
+// on which of them goes first, and the other one and every person below it
+// are planned again around the routes of all persons above them. A person
+// below whose route still keeps clear of the ones above is not searched
+// again. The cheaper branch is explored first, depth first, so priorities
+// are only added between persons that actually meet, instead of one fixed
+// order for everybody.
+//
+// Routes are searched by SpaceTimeSearch, the same as in the prioritized
+// planner. When the budget or the nodes run out before the routes are free
+// of collisions, the persons still colliding are left standing where they
+// are.
+class PbsPlanner : public Planner {
+ public:
+    PbsPlanner(const std::vector<Person>& persons,
+               const std::vector<Goal>& goals, Grid* grid,
+               PbsOptions options = {});
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    // Ticks from <start> to <end> a person stays in a cell
+    struct Stay {
+        Point cell;
+        int start;
+        int end;
+    };
+
+    struct Route {
+        std::vector<Action> actions;
+        std::vector<Point> trajectory;
+        std::vector<Stay> stays;
+        int cost;
+    };
+
+    using Routes = std::vector<std::shared_ptr<const Route>>;
+
+    struct Collision {
+        int first;
+        int second;
+        int time;
+    };
+
+    struct Node {
+        Routes routes;
+        // Persons every person goes before
+        std::vector<std::vector<int>> lower;
+        std::int64_t cost;
+    };
+
+    // Plans <agent> and the persons below it again, false if one of them
+    // has no route
+    bool replan(Node& node, int agent);
+    std::shared_ptr<const Route> plan_route(int agent);
+    // Search around the reserved routes that never enters a reserved cell
+    SpaceTimeSearch make_search() const;
+    bool is_above(const Node& node, int agent, int other) const;
+    std::vector<Collision> find_collisions(const Routes& routes) const;
+    // Leaves standing the persons still colliding in <routes>
+    Routes drop_colliding(Routes routes) const;
+    Route make_route(int agent, std::vector<Action> actions) const;
+
+    PbsOptions _options;
+    DistanceField _field;
+    // Routes of the persons above the one being planned
+    IntervalCATable _table;
+    // Cells of persons that stand where they are forever
+    FlatHashSet<Point> _stops;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // PBS_PLANNER_H
@@ -0,0 +1,70 @@
+#ifndef PIBT_PLANNER_H
+#define PIBT_PLANNER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "planner.h"
+
+// Priority inheritance with backtracking (PIBT). Every person that is ready
+// picks one action at a time, older persons first: the neighbour on the
+// cheapest way to a goal by the distance field, or staying if none is. A person
+// standing in the way is asked to step aside first and inherits the
+// priority of the asking one, if it can not move, the next neighbour is
+// tried. A tick costs time linear in the persons deciding at it, so
+// thousands of persons are planned quickly, but routes are not the shortest
+// and persons may get stuck in dead ends.
+//
+// Actions take 2 or 3 ticks, so persons decide at different ticks, the ones
+// ready in the same round of two ticks decide together. A cell stays
+// reserved until the person leaving it arrives, the same as in CATable, and
+// a person stepping aside arrives no later than the one taking its cell.
+class PibtPlanner : public Planner {
+ public:
+    PibtPlanner(const std::vector<Person>& persons,
+                const std::vector<Goal>& goals, Grid* grid);
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    enum class AgentStatus { MOVING, ARRIVED, UNREACHABLE };
+
+    struct AgentState {
+        AgentStatus status;
+        // Where the last action ends
+        Point position;
+        int ready_time;
+        // Actions taken, older persons decide first
+        int age;
+        int decided_round;
+        int best_distance;
+    };
+
+    // Picks the action of the person and commits it, a person pushed by
+    // another one has to arrive somewhere else no later than the deadline
+    bool decide(int agent_id, int round, int pusher, int deadline);
+    void commit(int agent_id, const Point& to);
+    bool is_older(int agent_id, int other_id) const;
+    int cell_id(const Point& cell) const noexcept;
+
+    DistanceField _field;
+    Point _lower_left;
+    int _width;
+    int _height;
+    // Person standing at, waiting at or going to every cell, -1 for nobody
+    std::vector<int> _holders;
+    // First tick the person who left the cell no longer reserves it
+    std::vector<int> _free_from;
+    std::vector<AgentState> _agents;
+    std::vector<std::vector<Action>> _routes;
+    // Persons by the round they are ready in
+    std::map<int, std::vector<int>> _ready;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // PIBT_PLANNER_H
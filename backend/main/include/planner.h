@@ -2,11 +2,17 @@
 #define PLANNER_H
 
 #include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "grid.h"
 #include "person.h"
+#include "search_budget.h"
 
 class Planner {
  public:
@@ -16,11 +22,28 @@ class Planner {
 
     virtual ~Planner() = default;
     virtual std::vector<std::vector<Action>> plan_all_routes() = 0;
+    // Counters of the last plan_all_routes call, empty if the planner keeps
+    // none
+    virtual std::map<std::string, std::int64_t> get_stats() const {
+        return {};
+    }
+
+    // Limits the work of the next plan_all_routes calls, several planners
+    // may share one budget
+    void set_budget(std::shared_ptr<SearchBudget> budget) {
+        _budget = std::move(budget);
+    }
+
+    // The budget ran out during the last plan_all_routes call, some persons
+    // did not get the routes they would get otherwise
+    bool is_partial() const noexcept { return _partial; }
 
  protected:
     std::vector<Person> _persons;
     std::unordered_set<Goal> _goals;
     Grid* _grid;
+    std::shared_ptr<SearchBudget> _budget = std::make_shared<SearchBudget>();
+    bool _partial = false;
 
     int h(const Point& point) const noexcept {
         if (_goals.size() == 0) {
@@ -35,6 +58,15 @@ class Planner {
         return minim;
     }
 
+    std::vector<Point> get_goal_positions() const {
+        std::vector<Point> positions;
+        positions.reserve(_goals.size());
+        for (const auto& goal : _goals) {
+            positions.push_back(goal.get_position());
+        }
+        return positions;
+    }
+
     bool is_reached_goal(const Point& point) const noexcept {
         return std::any_of(_goals.begin(), _goals.end(),
                            [&point](const auto& goal) {
@@ -0,0 +1,53 @@
+#ifndef PORTFOLIO_PLANNER_H
+#define PORTFOLIO_PLANNER_H
+
+#include <cstdint>
+#include <map>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+#include "planner.h"
+#include "prioritized_planner.h"
+
+struct PortfolioOptions {
+    // Orderings tried: shortest first and runs - 1 seeded perturbations of it
+    unsigned runs = 4;
+    // Runs planned concurrently, 0 means one per hardware thread
+    unsigned threads = 0;
+    // Options of every run, the seed and the stop are set by the portfolio
+    PrioritizedOptions planner;
+};
+
+// Prioritized planning with several priority orders at once. Every run has
+// its own planner and reservation table, the runs share the budget of the
+// portfolio. Complete routes win over partial ones, then the fewest failed
+// persons and then the smallest makespan, ties go to the earlier run. A run
+// that reaches the lower bound of both cancels all others.
+class PortfolioPlanner : public Planner {
+ public:
+    PortfolioPlanner(const std::vector<Person>& persons,
+                     const std::vector<Goal>& goals, Grid* grid,
+                     PortfolioOptions options = {});
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    struct RunResult {
+        bool finished = false;
+        bool partial = false;
+        std::vector<std::vector<Action>> routes;
+        std::map<std::string, std::int64_t> stats;
+        int failed = 0;
+        int makespan = 0;
+    };
+
+    RunResult run(unsigned index, std::stop_token stop) const;
+
+    PortfolioOptions _options;
+    std::vector<Goal> _goal_list;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // PORTFOLIO_PLANNER_H
@@ -1,27 +1,130 @@
 #ifndef PRIORITIZED_PLANNER_H
 #define PRIORITIZED_PLANNER_H
 
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <optional>
-#include <unordered_set>
+#include <stop_token>
+#include <string>
 #include <vector>
 
-#include "catable.h"
+#include "distance_field.h"
+#include "flat_hash.h"
+#include "interval_catable.h"
 #include "planner.h"
+#include "search_footprint.h"
+#include "space_time_search.h"
 
+struct PrioritizedOptions {
+    // Threads for speculative planning, 1 plans strictly one by one
+    unsigned threads = 1;
+    // Agents planned concurrently against one snapshot of the table,
+    // 0 means twice the number of threads
+    unsigned window = 0;
+    // Try the static route first and search around its first conflict only
+    bool lazy = false;
+    // 0 plans shortest first, other values perturb that order randomly
+    unsigned seed = 0;
+    // Stops planning early, the routes of a cancelled run are meaningless
+    std::stop_token stop;
+    // Of the routes arriving equally early prefer the ones through cells
+    // that are reserved for fewer ticks
+    bool congestion = false;
+    // Routes of an earlier plan by person. The ones still valid are kept
+    // and go first, only the other persons and the ones near them are
+    // searched for.
+    std::vector<std::optional<std::vector<Action>>> previous_routes;
+};
+
+// Persons sharing a start cell, as the members of a group expanded by the
+// server, queue there: the first one in priority order is planned as usual
+// and every next one is committed right after it, taking the same route a
+// few ticks after the one before has left. Only if no such delay is free a
+// follower is searched for, so the queue is planned in the same pass.
 class PrioritizedPlanner : public Planner {
  public:
     PrioritizedPlanner(const std::vector<Person>& persons,
-                       const std::vector<Goal>& goals, Grid* grid);
+                       const std::vector<Goal>& goals, Grid* grid,
+                       PrioritizedOptions options = {});
+    // <field> is the distance field to <goals> on <grid>, planners of one
+    // map may share it
+    PrioritizedPlanner(const std::vector<Person>& persons,
+                       const std::vector<Goal>& goals, Grid* grid,
+                       std::shared_ptr<const DistanceField> field,
+                       PrioritizedOptions options = {});
     std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
     std::optional<std::vector<Action>> calculate_route(
         const Person& person) const;
+    // The last plan_all_routes call was stopped before it finished
+    bool is_cancelled() const noexcept;
 
  private:
+    enum class RouteKind { STATIC, REPAIRED, SEARCHED, KEPT, STAGGERED };
+
+    struct SearchStats {
+        RouteKind kind = RouteKind::SEARCHED;
+        int expansions = 0;
+        // Share of the budget the search was given
+        int max_steps = 0;
+        // Stopped by the budget, not by the lack of a route
+        bool cut = false;
+    };
+
+    struct AgentPlan {
+        std::vector<Action> route;
+        // Reserved points, empty if the agent has no route
+        std::vector<Point> trajectory;
+        SearchFootprint footprint;
+        SearchStats stats;
+        // Trajectories of the followers committed right after this one
+        std::size_t committed_followers = 0;
+    };
+
     std::vector<int> get_priorities_shortest_first() const;
+    // Removes the persons starting in the cell of a person before them from
+    // <indices> and makes them followers of the first one
+    void take_followers(std::vector<int>& indices);
+    // Commits the followers of <agent_id>, whose trajectory is committed
+    void commit_followers(int agent_id, std::vector<AgentPlan>& plans,
+                          FlatHashSet<Point>* changed_area,
+                          FlatHashSet<Point>* committed_area);
+    bool is_affected(int agent_id, const std::vector<AgentPlan>& plans,
+                     const FlatHashSet<Point>& changed_area) const;
     int calculate_distance(const Person& person) const;
-    bool validate_results(std::vector<std::vector<Action>>& results);
-    CATable ca_table;
-    std::unordered_set<Point> stops;
+    std::vector<Point> validate_results(const std::vector<AgentPlan>& plans);
+    // Reserves the previous routes that are still valid and returns the
+    // order with their persons first. The starts of the other persons are
+    // added to <changed_area>.
+    std::vector<int> keep_previous_routes(const std::vector<int>& indices,
+                                          std::vector<AgentPlan>& plans,
+                                          FlatHashSet<Point>& changed_area);
+    bool is_valid_route(const Person& person,
+                        const std::vector<Action>& route) const;
+    void plan_pass(const std::vector<int>& indices,
+                   std::vector<AgentPlan>& plans,
+                   FlatHashSet<Point>* changed_area);
+    std::vector<AgentPlan> speculate(const std::vector<int>& agents,
+                                     std::int64_t searches_left) const;
+    AgentPlan plan_agent(int agent_id, int max_steps) const;
+    std::optional<std::vector<Action>> calculate_route(
+        const Person& person, SearchFootprint& footprint,
+        SearchStats& stats) const;
+    // Search over the current table and stops
+    SpaceTimeSearch make_search() const;
+    void count_route(const AgentPlan& plan, const Person& person);
+    std::vector<Point> to_trajectory(const Person& person,
+                                     const std::vector<Action>& route) const;
+    PrioritizedOptions _options;
+    std::shared_ptr<const DistanceField> _field;
+    IntervalCATable ca_table;
+    FlatHashSet<Point> stops;
+    // Persons queued behind every person in its start cell, in order
+    std::vector<std::vector<int>> _followers;
+    std::vector<std::uint8_t> _is_follower;
+    std::map<std::string, std::int64_t> _stats;
+    bool _cancelled = false;
 };
 
 #endif  // PRIORITIZED_PLANNER_H
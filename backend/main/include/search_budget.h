@@ -0,0 +1,62 @@
+#ifndef SEARCH_BUDGET_H
+#define SEARCH_BUDGET_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Work a request may spend on planning: a wall-clock deadline and a number
+// of search expansions shared by all searches of the request, so several
+// planners or threads may spend from one budget at once. One search never
+// spends more than <search_limit> expansions, that also bounds searches
+// which can not reach any goal.
+class SearchBudget {
+ public:
+    static constexpr std::int64_t UNLIMITED = -1;
+    static constexpr std::int64_t DEFAULT_SEARCH_LIMIT = 50000;
+
+    explicit SearchBudget(
+        std::chrono::milliseconds deadline = std::chrono::milliseconds(0),
+        std::int64_t expansions = UNLIMITED,
+        std::int64_t search_limit = DEFAULT_SEARCH_LIMIT)
+        : _deadline(std::chrono::steady_clock::now() + deadline),
+          _has_deadline(deadline.count() > 0),
+          _expansions(expansions),
+          _search_limit(search_limit) {}
+
+    bool is_expired() const noexcept {
+        return _has_deadline && std::chrono::steady_clock::now() >= _deadline;
+    }
+
+    bool is_exhausted() const noexcept {
+        return is_expired() ||
+               (_expansions != UNLIMITED && _spent.load() >= _expansions);
+    }
+
+    // Expansions the next search may spend when <searches_left> searches,
+    // this one included, still share the rest of the budget
+    std::int64_t get_share(std::int64_t searches_left) const noexcept {
+        if (_expansions == UNLIMITED) {
+            return _search_limit;
+        }
+        std::int64_t rest = std::max<std::int64_t>(0, _expansions - _spent);
+        return std::min(_search_limit,
+                        rest / std::max<std::int64_t>(1, searches_left));
+    }
+
+    void spend(std::int64_t expansions) noexcept { _spent += expansions; }
+
+    std::int64_t get_spent() const noexcept { return _spent.load(); }
+
+    std::int64_t get_search_limit() const noexcept { return _search_limit; }
+
+ private:
+    std::chrono::steady_clock::time_point _deadline;
+    bool _has_deadline;
+    std::int64_t _expansions;
+    std::int64_t _search_limit;
+    std::atomic<std::int64_t> _spent{0};
+};
+
+#endif  // SEARCH_BUDGET_H
@@ -0,0 +1,49 @@
+#ifndef SEARCH_FOOTPRINT_H
+#define SEARCH_FOOTPRINT_H
+
+#include <vector>
+
+#include "flat_hash.h"
+#include "point.h"
+
+// Cells expanded by a space-time search. The search reads reservations of
+// the expanded cells and of their neighbours and the stop status of the
+// expanded cells only, so it replays to the same route unless something
+// changes in the 3x3 area around one of them.
+class SearchFootprint {
+ public:
+    void add(const Point &cell) {
+        if (_seen.insert(cell)) {
+            _cells.push_back(cell);
+        }
+    }
+
+    // Drops the lookup set once the search is finished
+    void seal() { _seen = FlatHashSet<Point>(); }
+
+    const std::vector<Point> &get_cells() const noexcept { return _cells; }
+
+    bool is_affected_by(const FlatHashSet<Point> &changed_area) const {
+        for (const auto &cell : _cells) {
+            if (changed_area.contains(cell)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Marks every cell whose search could have looked at <cell>
+    static void mark_changed(FlatHashSet<Point> &changed_area,
+                             const Point &cell) {
+        changed_area.insert(cell);
+        for (const auto &neighbor : cell.get_neighbors()) {
+            changed_area.insert(neighbor);
+        }
+    }
+
+ private:
+    FlatHashSet<Point> _seen;
+    std::vector<Point> _cells;
+};
+
+#endif  // SEARCH_FOOTPRINT_H
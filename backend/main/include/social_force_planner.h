@@ -0,0 +1,90 @@
+#ifndef SOCIAL_FORCE_PLANNER_H
+#define SOCIAL_FORCE_PLANNER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "planner.h"
+
+struct SocialForceOptions {
+    // Simulated time of one step, in ticks
+    double step = 0.25;
+    // Preferred speed in cells per tick, a straight move takes 2 ticks
+    double speed = 0.5;
+    // Tiles simulated concurrently, 0 means one per hardware thread
+    unsigned threads = 0;
+};
+
+// Continuous crowd engine (social force model). Persons are discs moving in
+// the plane: each one is pulled toward the next cell of its cheapest route
+// by the distance field and pushed away by persons and borders nearby, so
+// densities at bottlenecks look like real ones instead of one person per
+// cell.
+//
+// Neighbours are found with a uniform cell list: every step the persons are
+// sorted by bin, so positions and velocities of a bin are contiguous arrays
+// and the force loops run over plain ranges. Borders are binned once. Rows
+// of bins form tiles, forces and moves of the tiles are computed
+// concurrently by threads kept for the whole run, each tile writing only its
+// own persons.
+//
+// Positions are sampled back into actions: a person takes a move when the
+// cell it is in changes, waiting in between so the move ends about when the
+// person got there. The model is soft, so two persons may be in one cell at
+// once and the routes are not free of cell conflicts. A person vanishes when
+// its cell is a goal. When nobody has changed cell for a while the crowd is
+// stuck, and the persons still walking keep the routes they have.
+class SocialForcePlanner : public Planner {
+ public:
+    SocialForcePlanner(const std::vector<Person>& persons,
+                       const std::vector<Goal>& goals, Grid* grid,
+                       SocialForceOptions options = {});
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+    std::map<std::string, std::int64_t> get_stats() const override;
+
+ private:
+    // Persons still in the plane, sorted by bin at the start of each step
+    struct Crowd {
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> vx;
+        std::vector<double> vy;
+        std::vector<double> ax;
+        std::vector<double> ay;
+        // Index of the person, negative for persons that never move
+        std::vector<int> agent;
+    };
+
+    void sort_into_bins(Crowd& crowd);
+    void compute_forces(Crowd& crowd, int first_row, int last_row) const;
+    void move(Crowd& crowd, int first_row, int last_row) const;
+    int bin_of(double x, double y) const noexcept;
+    // Cell of the map the point is in
+    Point cell_of(double x, double y) const noexcept;
+
+    SocialForceOptions _options;
+    DistanceField _field;
+    double _min_x;
+    double _min_y;
+    double _max_x;
+    double _max_y;
+    int _bin_columns;
+    int _bin_rows;
+    // Persons of bin b are [_bin_starts[b], _bin_starts[b + 1]) of the crowd
+    std::vector<int> _bin_starts;
+    // Borders near bin b are _wall_indices[_wall_starts[b].._wall_starts[b + 1])
+    std::vector<int> _wall_starts;
+    std::vector<int> _wall_indices;
+    std::vector<double> _wall_x1;
+    std::vector<double> _wall_y1;
+    std::vector<double> _wall_x2;
+    std::vector<double> _wall_y2;
+    std::map<std::string, std::int64_t> _stats;
+};
+
+#endif  // SOCIAL_FORCE_PLANNER_H
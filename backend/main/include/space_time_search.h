@@ -0,0 +1,66 @@
+#ifndef SPACE_TIME_SEARCH_H
+#define SPACE_TIME_SEARCH_H
+
+#include <optional>
+#include <stop_token>
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "flat_hash.h"
+#include "interval_catable.h"
+#include "point.h"
+#include "search_budget.h"
+#include "search_footprint.h"
+
+struct SpaceTimeOptions {
+    // Ends the search early, as the budget deadline does
+    std::stop_token stop;
+    // Of the routes arriving equally early, the ones through cells reserved
+    // for fewer ticks are preferred
+    bool congestion = false;
+    // A person with every move reserved still waits where it is. Without
+    // this such a node is a dead end, so found routes never cross the table.
+    bool forced_waits = true;
+};
+
+// A* of one person over cells and ticks around the reservations of a table,
+// guided by the distance field. Cells in <stops> are never entered. The
+// search only reads the table, so one table may serve several searches at
+// once.
+class SpaceTimeSearch {
+ public:
+    SpaceTimeSearch(const DistanceField& field, const IntervalCATable& table,
+                    const FlatHashSet<Point>& stops, const SearchBudget& budget,
+                    SpaceTimeOptions options = {});
+
+    // Cheapest route from <start> at <start_time> to a goal in at most
+    // <max_steps> expansions, which are added to <expansions>. A repair ends
+    // at the first of <rejoin_cells> from which the static route is free.
+    // <cut> is set when the stop or the deadline ended the search.
+    std::optional<std::vector<Action>> search_route(
+        const Point& start, int start_time, int max_steps,
+        const FlatHashSet<Point>* rejoin_cells, SearchFootprint& footprint,
+        int& expansions, bool& cut) const;
+    // Cells of the cheapest route to a goal ignoring the reservations
+    std::vector<Point> get_static_route(const Point& start) const;
+    // Index of the first step of <cells> that can not be made at its tick,
+    // -1 if the whole route is free
+    int find_conflict(const std::vector<Point>& cells, int start_time,
+                      SearchFootprint& footprint) const;
+
+ private:
+    bool is_past_horizon(const Point& cell, int time,
+                         FlatHashMap<Point, int>& horizons,
+                         SearchFootprint& footprint) const;
+    int get_static_horizon(const Point& cell, FlatHashMap<Point, int>& horizons,
+                           SearchFootprint& footprint) const;
+
+    const DistanceField& _field;
+    const IntervalCATable& _table;
+    const FlatHashSet<Point>& _stops;
+    const SearchBudget& _budget;
+    SpaceTimeOptions _options;
+};
+
+#endif  // SPACE_TIME_SEARCH_H
@@ -13,6 +13,8 @@ struct TimedNode {
     int time;
     int self_index;
     int parent_index;
+    // Breaks ties of f, lower first
+    int tie = 0;
 
     TimedNode(Point pos, int g_val, int h_val, int t, int ind, int p = -1)
         : position(pos),
@@ -26,7 +28,7 @@ struct TimedNode {
     struct Compare {
         bool operator()(const std::shared_ptr<TimedNode>& a,
                         const std::shared_ptr<TimedNode>& b) const {
-            return a->f > b->f;
+            return a->f > b->f || (a->f == b->f && a->tie > b->tie);
         }
     };
 };
@@ -0,0 +1,58 @@
+#ifndef WINDOWED_PLANNER_H
+#define WINDOWED_PLANNER_H
+
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "flat_hash.h"
+#include "interval_catable.h"
+#include "planner.h"
+
+struct WindowedOptions {
+    // Ticks reserved by every search, routes are replanned every window / 2
+    // ticks
+    int window = 16;
+};
+
+// Windowed cooperative A* (WHCA*): persons reserve only the next <window>
+// ticks, the static distance to the goals is used beyond the window, and
+// everybody replans every half window until all persons arrive.
+class WindowedPlanner : public Planner {
+ public:
+    WindowedPlanner(const std::vector<Person>& persons,
+                    const std::vector<Goal>& goals, Grid* grid,
+                    WindowedOptions options = {});
+
+    std::vector<std::vector<Action>> plan_all_routes() override;
+
+ private:
+    enum class AgentStatus { MOVING, ARRIVED, UNREACHABLE };
+
+    // Person after the last action added to its route
+    struct AgentState {
+        AgentStatus status;
+        Point previous;
+        Point position;
+        // The last action goes from <previous> at <move_start> to <position>
+        // at <ready_time>
+        int move_start;
+        int ready_time;
+        int planned_round;
+    };
+
+    std::vector<Point> plan_window(int agent_id, int round,
+                                   int commit_end, int window_end) const;
+    bool is_parked(const Point& cell, int agent_id, int round) const;
+    void reserve_current_moves(int round_start);
+    std::vector<int> get_round_order() const;
+
+    int _window;
+    DistanceField _field;
+    IntervalCATable _table;
+    // Cells of persons who have not planned in the current round yet
+    FlatHashMap<Point, int> _parked;
+    std::vector<AgentState> _agents;
+};
+
+#endif  // WINDOWED_PLANNER_H
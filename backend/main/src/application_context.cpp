@@ -1,16 +1,46 @@
 #include "application_context.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "actions.h"
+#include "catable.h"
+#include "ecbs_planner.h"
+#include "flow_field_planner.h"
+#include "flow_planner.h"
 #include "grid.h"
+#include "group_planner.h"
+#include "incremental_distance_field.h"
+#include "incremental_planner.h"
+#include "independence_planner.h"
+#include "lacam_planner.h"
+#include "lns_planner.h"
+#include "pbs_planner.h"
 #include "person.h"
+#include "pibt_planner.h"
 #include "point.h"
+#include "portfolio_planner.h"
 #include "prioritized_planner.h"
 #include "random_planner.h"
+#include "search_budget.h"
 #include "simple_planner.h"
+#include "social_force_planner.h"
+#include "windowed_planner.h"
 
 using Action::DOWN;
 using Action::LEFT;
@@ -94,9 +124,158 @@ Border to_border(const Convertor::Segment &s) {
     return Border(to_point(s.first), to_point(s.second));
 }
 
+// Integer field of the request, <fallback> if it is absent. Values out of
+// [min, max] are rejected before they reach a planner.
+std::int64_t get_integer(const json &input, const std::string &key,
+                         std::int64_t fallback, std::int64_t min,
+                         std::int64_t max) {
+    if (!input.contains(key)) {
+        return fallback;
+    }
+    const auto &value = input.at(key);
+    // Non-negative numbers are unsigned in json, the large ones would wrap
+    if (value.is_number_integer() &&
+        (!value.is_number_unsigned() ||
+         value.get<std::uint64_t>() <= std::uint64_t(max))) {
+        auto number = value.get<std::int64_t>();
+        if (number >= min && number <= max) {
+            return number;
+        }
+    }
+    throw RequestError(key + " must be an integer from " +
+                       std::to_string(min) + " to " + std::to_string(max));
+}
+
+// Number field of the request, <fallback> if it is absent. Values out of
+// [min, max], infinities and NaN are rejected.
+double get_number(const json &input, const std::string &key, double fallback,
+                  double min, double max) {
+    if (!input.contains(key)) {
+        return fallback;
+    }
+    const auto &value = input.at(key);
+    if (value.is_number()) {
+        auto number = value.get<double>();
+        if (std::isfinite(number) && number >= min && number <= max) {
+            return number;
+        }
+    }
+    std::ostringstream message;
+    message << key << " must be a number from " << min << " to " << max;
+    throw RequestError(message.str());
+}
+
+// Largest number of persons of a request, the created members included
+constexpr std::size_t MAX_PERSONS = 100000;
+
+void add_person(Convertor::Map &map, int id, const Convertor::Point &position) {
+    if (map.persons.size() >= MAX_PERSONS) {
+        throw RequestError("a request may have at most " +
+                           std::to_string(MAX_PERSONS) + " persons");
+    }
+    map.persons.push_back({id, position});
+}
+
+// Groups may come without their persons: members of <person_ids> missing
+// from the persons and the rest up to <total_count> are created at the start
+// of the group. Created members get the ids after the largest one in use,
+// group by group, and are added to <person_ids>.
+Convertor::Map parse_map(const json &input) {
+    auto map = input.template get<Convertor::Map>();
+    if (map.persons.size() > MAX_PERSONS) {
+        throw RequestError("a request may have at most " +
+                           std::to_string(MAX_PERSONS) + " persons");
+    }
+    std::unordered_set<int> known_ids;
+    // Counted in 64 bits, the id after INT_MAX does not fit into an int
+    std::int64_t next_id = 0;
+    for (const auto &person : map.persons) {
+        known_ids.insert(person.id);
+        next_id = std::max(next_id, std::int64_t(person.id) + 1);
+    }
+    for (const auto &group : map.groups) {
+        for (int person_id : group.person_ids) {
+            next_id = std::max(next_id, std::int64_t(person_id) + 1);
+        }
+    }
+    for (auto &group : map.groups) {
+        for (int person_id : group.person_ids) {
+            if (known_ids.insert(person_id).second) {
+                add_person(map, person_id, group.start_position);
+            }
+        }
+        while (int(group.person_ids.size()) < group.total_count) {
+            if (next_id > std::numeric_limits<int>::max()) {
+                throw RequestError("no free person id is left for group " +
+                                   std::to_string(group.id));
+            }
+            auto id = int(next_id++);
+            known_ids.insert(id);
+            add_person(map, id, group.start_position);
+            group.person_ids.push_back(id);
+        }
+    }
+    // Planners key their reservations by cell and tick
+    auto is_far = [](const Convertor::Point &point) {
+        return std::abs(point.x) > MAX_KEY_COORDINATE ||
+               std::abs(point.y) > MAX_KEY_COORDINATE;
+    };
+    bool has_far_points =
+        is_far(map.down_left_point) || is_far(map.up_right_point) ||
+        std::any_of(map.persons.begin(), map.persons.end(),
+                    [&is_far](const auto &person) {
+                        return is_far(person.position);
+                    }) ||
+        std::any_of(map.goals.begin(), map.goals.end(),
+                    [&is_far](const auto &goal) {
+                        return is_far(goal.position);
+                    });
+    if (has_far_points) {
+        throw RequestError("coordinates must be from " +
+                           std::to_string(-MAX_KEY_COORDINATE) + " to " +
+                           std::to_string(MAX_KEY_COORDINATE));
+    }
+    return map;
+}
+
+using RoutesById =
+    std::unordered_map<int, std::optional<std::vector<Action>>>;
+
+// Routes of an earlier answer by person id, nothing if there are none
+std::optional<RoutesById> to_routes_by_id(const json &input) {
+    if (!input.contains("previous_routes")) {
+        return std::nullopt;
+    }
+    RoutesById by_id;
+    for (const auto &result : input.at("previous_routes")) {
+        // A person without a route is written as null
+        const auto &route = result.at("route");
+        by_id[result.at("id").get<int>()] =
+            route.is_null() ? std::nullopt
+                            : std::optional(route.get<std::vector<Action>>());
+    }
+    return by_id;
+}
+
+// Previous routes in the order of the persons given to the planner, so they
+// follow the parsed and expanded map
+void set_previous_routes(PrioritizedOptions &options,
+                         const std::optional<RoutesById> &by_id,
+                         const std::vector<Person> &persons) {
+    if (!by_id) {
+        return;
+    }
+    options.previous_routes.clear();
+    for (const auto &person : persons) {
+        auto it = by_id->find(person.get_id());
+        options.previous_routes.push_back(it != by_id->end() ? it->second
+                                                             : std::nullopt);
+    }
+}
+
 json ApplicationContext::calculate_route(json input,
                                          PlannerFactory planner_factory) {
-    auto map = input.template get<Convertor::Map>();
+    auto map = parse_map(input);
     std::vector<Border> borders;
     for (const auto &segment : map.borders) {
         borders.push_back(to_border(segment));
@@ -111,21 +290,87 @@ json ApplicationContext::calculate_route(json input,
     for (const auto &goal_data : map.goals) {
         goals.emplace_back(goal_data.id, to_point(goal_data.position));
     }
+    // The clock of the deadline starts with the request
+    auto budget = std::make_shared<SearchBudget>(
+        std::chrono::milliseconds(input.value("deadline_ms", 0)),
+        input.value("max_expansions", SearchBudget::UNLIMITED));
     std::unique_ptr<Planner> planner = planner_factory(persons, goals, &grid);
+    planner->set_budget(budget);
     auto all_routes = planner->plan_all_routes();
     std::vector<Convertor::RouteResult> results;
     for (size_t i = 0; i < persons.size(); ++i) {
         results.push_back(
             Convertor::RouteResult(persons[i].get_id(), all_routes[i]));
     }
+    // The answer keeps its shape unless the client asks for the envelope,
+    // whether the budget was enough is only told there
+    if (input.value("with_stats", false)) {
+        return json{{"routes", results},
+                    {"partial", planner->is_partial()},
+                    {"stats", planner->get_stats()}};
+    }
     return static_cast<json>(results);
 }
 
 json ApplicationContext::calculate_route_dense(json input) {
-    return calculate_route(input, [](const std::vector<Person> &ps,
-                                     const std::vector<Goal> gs, Grid *g) {
-        return std::make_unique<PrioritizedPlanner>(ps, gs, g);
-    });
+    PrioritizedOptions options;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    options.lazy = input.value("lazy", options.lazy);
+    options.congestion = input.value("congestion", options.congestion);
+    // Every portfolio run has its own planner and reservation table
+    constexpr std::int64_t MAX_PORTFOLIO_RUNS = 64;
+    auto runs =
+        unsigned(get_integer(input, "portfolio", 1, 1, MAX_PORTFOLIO_RUNS));
+    if (input.value("independence", false)) {
+        // Every group is planned from scratch with the shortest first
+        // ordering, so previous routes and a portfolio would be ignored
+        if (input.contains("previous_routes") || runs > 1) {
+            throw RequestError(
+                "independence can not be combined with previous_routes or "
+                "portfolio");
+        }
+        // The groups share the hardware threads, so each one plans
+        // sequentially
+        IndependenceOptions independence;
+        independence.threads = options.threads;
+        independence.planner = options;
+        independence.planner.threads = 1;
+        return calculate_route(
+            input, [independence](const std::vector<Person> &ps,
+                                  const std::vector<Goal> gs, Grid *g) {
+                return std::make_unique<IndependencePlanner>(ps, gs, g,
+                                                             independence);
+            });
+    }
+    auto previous_routes = to_routes_by_id(input);
+    if (runs <= 1) {
+        return calculate_route(
+            input, [options, previous_routes](const std::vector<Person> &ps,
+                                              const std::vector<Goal> gs,
+                                              Grid *g) {
+                auto planner_options = options;
+                set_previous_routes(planner_options, previous_routes, ps);
+                return std::make_unique<PrioritizedPlanner>(ps, gs, g,
+                                                            planner_options);
+            });
+    }
+
+    // The runs share the hardware threads, so each one plans sequentially
+    PortfolioOptions portfolio;
+    portfolio.runs = runs;
+    portfolio.threads = options.threads;
+    portfolio.planner = options;
+    portfolio.planner.threads = 1;
+    return calculate_route(
+        input, [portfolio, previous_routes](const std::vector<Person> &ps,
+                                            const std::vector<Goal> gs,
+                                            Grid *g) {
+            auto portfolio_options = portfolio;
+            set_previous_routes(portfolio_options.planner, previous_routes,
+                                ps);
+            return std::make_unique<PortfolioPlanner>(ps, gs, g,
+                                                      portfolio_options);
+        });
 }
 
 json ApplicationContext::calculate_route_simple(json input) {
@@ -141,3 +386,194 @@ json ApplicationContext::calculate_route_random(json input) {
         return std::make_unique<RandomPlanner>(ps, gs, g);
     });
 }
+
+json ApplicationContext::calculate_route_windowed(json input) {
+    WindowedOptions options;
+    // A window must fit a diagonal move and its replanning, a wider one
+    // only costs time
+    constexpr std::int64_t MIN_WINDOW = 6;
+    constexpr std::int64_t MAX_WINDOW = 1024;
+    options.window = int(get_integer(input, "window", options.window,
+                                     MIN_WINDOW, MAX_WINDOW));
+    return calculate_route(
+        input, [options](const std::vector<Person> &ps,
+                         const std::vector<Goal> gs, Grid *g) {
+            return std::make_unique<WindowedPlanner>(ps, gs, g, options);
+        });
+}
+
+json ApplicationContext::calculate_route_pibt(json input) {
+    return calculate_route(input, [](const std::vector<Person> &ps,
+                                     const std::vector<Goal> gs, Grid *g) {
+        return std::make_unique<PibtPlanner>(ps, gs, g);
+    });
+}
+
+json ApplicationContext::calculate_route_lacam(json input) {
+    LacamOptions options;
+    options.refine = input.value("refine", options.refine);
+    return calculate_route(
+        input, [options](const std::vector<Person> &ps,
+                         const std::vector<Goal> gs, Grid *g) {
+            return std::make_unique<LacamPlanner>(ps, gs, g, options);
+        });
+}
+
+json ApplicationContext::calculate_route_ecbs(json input) {
+    EcbsOptions options;
+    // The bounds are costs times the suboptimality and must fit into an int
+    constexpr double MAX_SUBOPTIMALITY = 16.0;
+    options.suboptimality = get_number(input, "suboptimality",
+                                       options.suboptimality, 1.0,
+                                       MAX_SUBOPTIMALITY);
+    return calculate_route(
+        input, [options](const std::vector<Person> &ps,
+                         const std::vector<Goal> gs, Grid *g) {
+            return std::make_unique<EcbsPlanner>(ps, gs, g, options);
+        });
+}
+
+json ApplicationContext::calculate_route_pbs(json input) {
+    return calculate_route(input, [](const std::vector<Person> &ps,
+                                     const std::vector<Goal> gs, Grid *g) {
+        return std::make_unique<PbsPlanner>(ps, gs, g);
+    });
+}
+
+json ApplicationContext::calculate_route_lns(json input) {
+    LnsOptions options;
+    // Each neighborhood is planned person by person, so a large one is just
+    // a slow restart
+    constexpr std::int64_t MAX_NEIGHBORHOOD = 1024;
+    options.neighborhood = unsigned(get_integer(
+        input, "neighborhood", options.neighborhood, 1, MAX_NEIGHBORHOOD));
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string initial = input.value("initial", std::string("dense"));
+    if (initial != "dense" && initial != "random" && initial != "pibt") {
+        throw RequestError("unknown initial planner " + initial);
+    }
+    // The best solutions in the order they were found, answered with the
+    // stats
+    auto progress = std::make_shared<std::vector<LnsProgress>>();
+    options.on_improvement = [progress](const LnsProgress &best) {
+        progress->push_back(best);
+    };
+    auto result = calculate_route(
+        input, [options, initial](const std::vector<Person> &ps,
+                                  const std::vector<Goal> gs, Grid *g) {
+            std::unique_ptr<Planner> start;
+            if (initial == "random") {
+                start = std::make_unique<RandomPlanner>(ps, gs, g);
+            } else if (initial == "pibt") {
+                start = std::make_unique<PibtPlanner>(ps, gs, g);
+            } else {
+                PrioritizedOptions dense;
+                dense.threads = options.threads;
+                start = std::make_unique<PrioritizedPlanner>(ps, gs, g, dense);
+            }
+            return std::make_unique<LnsPlanner>(ps, gs, g, std::move(start),
+                                                options);
+        });
+    if (result.is_object()) {
+        result["progress"] = json::array();
+        for (const auto &best : *progress) {
+            result["progress"].push_back(
+                {{"iteration", best.iteration},
+                 {"failed_routes", best.failed_routes},
+                 {"sum_of_costs", best.sum_of_costs},
+                 {"makespan", best.makespan}});
+        }
+    }
+    return result;
+}
+
+json ApplicationContext::calculate_route_flow(json input) {
+    return calculate_route(input, [](const std::vector<Person> &ps,
+                                     const std::vector<Goal> gs, Grid *g) {
+        return std::make_unique<FlowPlanner>(ps, gs, g);
+    });
+}
+
+json ApplicationContext::calculate_route_flow_field(json input) {
+    return calculate_route(input, [](const std::vector<Person> &ps,
+                                     const std::vector<Goal> gs, Grid *g) {
+        return std::make_unique<FlowFieldPlanner>(ps, gs, g);
+    });
+}
+
+json ApplicationContext::calculate_route_social_force(json input) {
+    SocialForceOptions options;
+    // A person covers at most 1.5 * speed cells a tick, 0.75 cells a step of
+    // a quarter tick at the top speed, so it never jumps over a cell
+    constexpr double MIN_SPEED = 0.05;
+    constexpr double MAX_SPEED = 2.0;
+    options.speed =
+        get_number(input, "speed", options.speed, MIN_SPEED, MAX_SPEED);
+    return calculate_route(
+        input, [options](const std::vector<Person> &ps,
+                         const std::vector<Goal> gs, Grid *g) {
+            return std::make_unique<SocialForcePlanner>(ps, gs, g, options);
+        });
+}
+
+// Incremental planners keep their fields between requests, one per map id.
+// The fields of a map are forgotten when there are too many maps, so a
+// request for a forgotten map builds its field again.
+std::shared_ptr<IncrementalDistanceField> get_incremental_field(
+    const std::string &map_id) {
+    constexpr std::size_t MAX_MAPS = 16;
+    static std::mutex mutex;
+    static std::unordered_map<std::string,
+                              std::shared_ptr<IncrementalDistanceField>>
+        fields;
+    std::lock_guard lock(mutex);
+    if (fields.size() >= MAX_MAPS && !fields.contains(map_id)) {
+        fields.clear();
+    }
+    auto &field = fields[map_id];
+    if (!field) {
+        field = std::make_shared<IncrementalDistanceField>();
+    }
+    return field;
+}
+
+json ApplicationContext::calculate_route_incremental(json input) {
+    auto field = get_incremental_field(input.at("_id").get<std::string>());
+    return calculate_route(
+        input, [field](const std::vector<Person> &ps,
+                       const std::vector<Goal> gs, Grid *g) {
+            return std::make_unique<IncrementalPlanner>(ps, gs, g, field);
+        });
+}
+
+json ApplicationContext::calculate_route_group(json input) {
+    // Members are given by person ids, the planner takes their indices
+    std::vector<std::vector<int>> groups;
+    for (const auto &group : parse_map(input).groups) {
+        groups.push_back(group.person_ids);
+    }
+    return calculate_route(
+        input, [groups](const std::vector<Person> &ps,
+                        const std::vector<Goal> gs, Grid *g) {
+            std::unordered_map<int, int> index_by_id;
+            for (std::size_t i = 0; i < ps.size(); ++i) {
+                index_by_id.emplace(ps[i].get_id(), int(i));
+            }
+            GroupOptions options;
+            for (const auto &group : groups) {
+                std::vector<int> members;
+                for (int person_id : group) {
+                    // parse_map creates the missing members, so this only
+                    // fails if the two stop agreeing
+                    auto it = index_by_id.find(person_id);
+                    if (it == index_by_id.end()) {
+                        throw RequestError("unknown group member " +
+                                           std::to_string(person_id));
+                    }
+                    members.push_back(it->second);
+                }
+                options.groups.push_back(std::move(members));
+            }
+            return std::make_unique<GroupPlanner>(ps, gs, g, options);
+        });
+}
@@ -58,17 +58,17 @@ bool CATable::check_move(const Point& from, const Point& to,
 
 int CATable::last_visited(  // cppcheck-suppress unusedFunction
     const Point& point) const {
-    auto last_it =
+    const int* last =
         _last_visit_table.find(point);  // TODO(verbinna22): remove unused
-    if (last_it != _last_visit_table.end()) {
-        return last_it->second;
+    if (last != nullptr) {
+        return *last;
     }
     return -1;
 }
 
 bool CATable::is_cell_available(int x, int y, int t) const {
     TimePoint tp = {x, y, t};
-    return _pos_time_table.find(tp) == _pos_time_table.end();
+    return !_pos_time_table.contains(tp);
 }
 
 bool CATable::is_reverse_move_valid(const Point& from, const Point& to,
@@ -0,0 +1,205 @@
+#include "concurrent_catable.h"
+
+#include <algorithm>
+
+#include "actions.h"
+
+ConcurrentCATable::ConcurrentCATable(const Point& lower_left,
+                                     const Point& upper_right,
+                                     std::size_t reader_slots)
+    : _lower_left(lower_left),
+      _width(std::max(0, upper_right.get_x() - lower_left.get_x() + 1)),
+      _height(std::max(0, upper_right.get_y() - lower_left.get_y() + 1)),
+      _cells(std::make_unique<std::atomic<const Intervals*>[]>(
+          std::size_t(_width) * std::size_t(_height))),
+      _reader_epochs(
+          std::make_unique<std::atomic<std::uint64_t>[]>(reader_slots)),
+      _reader_count(reader_slots) {
+    for (std::size_t i = 0; i < _reader_count; ++i) {
+        _reader_epochs[i].store(IDLE);
+    }
+}
+
+ConcurrentCATable::~ConcurrentCATable() noexcept {
+    for (int cell : _used_cells) {
+        delete _cells[std::size_t(cell)].load();
+    }
+}
+
+void ConcurrentCATable::add_trajectory(int /*traj_id*/,
+                                       const std::vector<Point>& trajectory,
+                                       int start_time) {
+    if (trajectory.size() == 0) {
+        return;
+    }
+    std::lock_guard lock(_write_mutex);
+    int t = start_time;
+    Point stay_point = trajectory[0];
+    int stay_start = start_time;
+    for (std::size_t i = 1; i < trajectory.size(); ++i) {
+        const Point& coord = trajectory[i];
+        int move_cost = stay_point.get_move_cost(coord);
+        if (coord != stay_point) {
+            add_interval(stay_point.get_x(), stay_point.get_y(),
+                         {stay_start, t + move_cost - 1});
+            stay_point = coord;
+            stay_start = t + move_cost;
+        }
+        t += move_cost;
+    }
+    add_interval(stay_point.get_x(), stay_point.get_y(), {stay_start, t});
+    _epoch.store(_epoch.load() + 1);
+    reclaim();
+}
+
+void ConcurrentCATable::clear() {
+    std::lock_guard lock(_write_mutex);
+    for (int cell : _used_cells) {
+        delete _cells[std::size_t(cell)].exchange(nullptr);
+    }
+    _used_cells.clear();
+    _retired.clear();
+    _horizon.store(-1);
+    _epoch.store(_epoch.load() + 1);
+}
+
+ConcurrentCATable::ReadGuard ConcurrentCATable::pin(std::size_t reader) const {
+    auto& slot = _reader_epochs[reader];
+    slot.store(_epoch.load());
+    return ReadGuard(&slot);
+}
+
+int ConcurrentCATable::cell_id(int x, int y) const noexcept {
+    int local_x = x - _lower_left.get_x();
+    int local_y = y - _lower_left.get_y();
+    if (local_x < 0 || local_y < 0 || local_x >= _width ||
+        local_y >= _height) {
+        return -1;
+    }
+    return local_y * _width + local_x;
+}
+
+void ConcurrentCATable::add_interval(int x, int y, TimeInterval interval) {
+    int cell = cell_id(x, y);
+    if (cell < 0) {
+        return;
+    }
+    int horizon = _horizon.load();
+    if (interval.end > horizon) {
+        _horizon.store(interval.end);
+    }
+    auto& current = _cells[std::size_t(cell)];
+    const Intervals* old_intervals = current.load();
+    auto intervals = old_intervals == nullptr
+                         ? std::make_unique<Intervals>()
+                         : std::make_unique<Intervals>(*old_intervals);
+    // Keep intervals disjoint: absorb every interval that overlaps or touches
+    // the new one
+    auto first = std::lower_bound(
+        intervals->begin(), intervals->end(), interval.start - 1,
+        [](const TimeInterval& lhs, int t) { return lhs.end < t; });
+    auto last = first;
+    while (last != intervals->end() && last->start <= interval.end + 1) {
+        interval.start = std::min(interval.start, last->start);
+        interval.end = std::max(interval.end, last->end);
+        ++last;
+    }
+    if (first == last) {
+        intervals->insert(first, interval);
+    } else {
+        *first = interval;
+        intervals->erase(first + 1, last);
+    }
+
+    current.store(intervals.release());
+    if (old_intervals == nullptr) {
+        _used_cells.push_back(cell);
+    } else {
+        // Readers pinned before the end of this commit may still hold it
+        _retired.push_back({_epoch.load() + 1,
+                            std::unique_ptr<const Intervals>(old_intervals)});
+    }
+}
+
+void ConcurrentCATable::reclaim() {
+    std::uint64_t oldest = IDLE;
+    for (std::size_t i = 0; i < _reader_count; ++i) {
+        oldest = std::min(oldest, _reader_epochs[i].load());
+    }
+    std::erase_if(_retired, [oldest](const Retired& retired) {
+        return retired.epoch <= oldest;
+    });
+}
+
+bool ConcurrentCATable::is_range_available(int x, int y, int t_from,
+                                           int t_to) const {
+    if (t_from > t_to) {
+        return true;
+    }
+    int cell = cell_id(x, y);
+    if (cell < 0) {
+        return true;
+    }
+    const Intervals* intervals = _cells[std::size_t(cell)].load();
+    if (intervals == nullptr) {
+        return true;
+    }
+    auto it = std::lower_bound(
+        intervals->begin(), intervals->end(), t_from,
+        [](const TimeInterval& lhs, int t) { return lhs.end < t; });
+    return it == intervals->end() || it->start > t_to;
+}
+
+bool ConcurrentCATable::check_move(const Point& from, const Point& to,
+                                   int start_time) const {
+    if (from == to) {
+        return is_range_available(from.get_x(), from.get_y(), start_time + 1,
+                                  start_time + get_cost(Action::WAIT));
+    }
+    int new_time = start_time + from.get_move_cost(to);
+    if (!is_range_available(to.get_x(), to.get_y(), new_time, new_time)) {
+        return false;
+    }
+    if (!is_range_available(from.get_x(), from.get_y(), start_time + 1,
+                            new_time - 1)) {
+        return false;
+    }
+    // Same swap rule as in CATable: nobody goes from <to> to <from> while we
+    // go from <from> to <to>
+    bool someone_moving_from_to_to_from =
+        !is_range_available(from.get_x(), from.get_y(), new_time, new_time) &&
+        !is_range_available(to.get_x(), to.get_y(), new_time - 1,
+                            new_time - 1);
+    return !someone_moving_from_to_to_from;
+}
+
+int ConcurrentCATable::last_visited(const Point& point) const {
+    int cell = cell_id(point.get_x(), point.get_y());
+    if (cell < 0) {
+        return -1;
+    }
+    const Intervals* intervals = _cells[std::size_t(cell)].load();
+    if (intervals == nullptr || intervals->empty()) {
+        return -1;
+    }
+    return intervals->back().end;
+}
+
+std::vector<Point> ConcurrentCATable::get_neighbors_timestep(
+    const Point& point, int time) const {
+    auto neighbors = point.get_neighbors();
+    neighbors.push_back(point);
+
+    std::vector<Point> valid_neighbors;
+    for (const auto& neighbor : neighbors) {
+        if (check_move(point, neighbor, time)) {
+            valid_neighbors.push_back(  // cppcheck-suppress useStlAlgorithm
+                neighbor);
+        }
+    }
+    if (valid_neighbors.empty()) {
+        valid_neighbors.push_back(point);
+    }
+
+    return valid_neighbors;
+}
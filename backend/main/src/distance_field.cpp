@@ -0,0 +1,213 @@
+#include "distance_field.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+
+#include "actions.h"
+#include "border.h"
+#include "segment.h"
+
+namespace {
+// Same order as in Point::get_neighbors
+constexpr std::array<std::pair<int, int>, 8> DIRECTIONS = {{
+    {0, 1},
+    {1, 1},
+    {-1, 1},
+    {0, -1},
+    {1, -1},
+    {-1, -1},
+    {1, 0},
+    {-1, 0},
+}};
+
+// Each undirected move is stored once, from the cell with the smaller id
+constexpr std::array<int, 4> FORWARD_DIRECTIONS = {0, 1, 2, 6};
+
+constexpr std::array<int, 8> OPPOSITE = {3, 5, 4, 0, 2, 1, 7, 6};
+}  // namespace
+
+DistanceField::DistanceField(const Grid& grid, const std::vector<Point>& goals,
+                             bool with_diagonals)
+    : _lower_left(grid.get_lower_left()),
+      _width(std::max(0, grid.get_upper_right().get_x() -
+                             grid.get_lower_left().get_x() + 1)),
+      _height(std::max(0, grid.get_upper_right().get_y() -
+                              grid.get_lower_left().get_y() + 1)),
+      _distances(std::size_t(_width) * std::size_t(_height), UNREACHABLE),
+      _moves(_distances.size(), 0) {
+    for (int y = 0; y < _height; ++y) {
+        for (int x = 0; x < _width; ++x) {
+            std::size_t id = std::size_t(y * _width + x);
+            for (int direction : FORWARD_DIRECTIONS) {
+                auto [dx, dy] = DIRECTIONS[std::size_t(direction)];
+                if (x + dx < 0 || x + dx >= _width || y + dy >= _height) {
+                    continue;
+                }
+                std::size_t neighbor_id =
+                    std::size_t((y + dy) * _width + x + dx);
+                _moves[id] |= std::uint8_t(1 << direction);
+                _moves[neighbor_id] |=
+                    std::uint8_t(1 << OPPOSITE[std::size_t(direction)]);
+            }
+        }
+    }
+    for (const auto& border : grid.get_borders()) {
+        remove_crossed_moves(border);
+    }
+
+    std::array<int, DIRECTIONS.size()> offsets{};
+    std::array<int, DIRECTIONS.size()> costs{};
+    for (std::size_t direction = 0; direction < DIRECTIONS.size();
+         ++direction) {
+        auto [dx, dy] = DIRECTIONS[direction];
+        offsets[direction] = dy * _width + dx;
+        costs[direction] = dx != 0 && dy != 0 ? get_cost(Action::RIGHT_UP)
+                                              : get_cost(Action::RIGHT);
+    }
+    using QueueItem = std::pair<int, int>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>,
+                        std::greater<QueueItem>>
+        open;
+    for (const auto& goal : goals) {
+        int id = cell_id(goal);
+        if (id >= 0 && _distances[std::size_t(id)] != 0) {
+            _distances[std::size_t(id)] = 0;
+            open.emplace(0, id);
+        }
+    }
+    while (!open.empty()) {
+        auto [distance, id] = open.top();
+        open.pop();
+        if (distance != _distances[std::size_t(id)]) {
+            continue;
+        }
+        // Moves are symmetric, so the reverse search uses the same bitmask
+        std::uint8_t moves = _moves[std::size_t(id)];
+        for (std::size_t direction = 0; direction < DIRECTIONS.size();
+             ++direction) {
+            if ((moves & (1 << direction)) == 0 ||
+                (!with_diagonals &&
+                 costs[direction] != get_cost(Action::RIGHT))) {
+                continue;
+            }
+            std::size_t neighbor_id = std::size_t(id + offsets[direction]);
+            int new_distance = distance + costs[direction];
+            if (new_distance < _distances[neighbor_id]) {
+                _distances[neighbor_id] = new_distance;
+                open.emplace(new_distance, int(neighbor_id));
+            }
+        }
+    }
+}
+
+bool DistanceField::is_inside(const Point& cell) const noexcept {
+    return cell_id(cell) >= 0;
+}
+
+int DistanceField::get_distance(const Point& cell) const noexcept {
+    int id = cell_id(cell);
+    return id < 0 ? UNREACHABLE : _distances[std::size_t(id)];
+}
+
+bool DistanceField::is_valid_move(const Point& from,
+                                  const Point& to) const noexcept {
+    int id = cell_id(from);
+    if (id < 0) {
+        return false;
+    }
+    if (from == to) {
+        return true;
+    }
+    int direction = direction_index(from, to);
+    return direction >= 0 && (_moves[std::size_t(id)] & (1 << direction)) != 0;
+}
+
+std::optional<Point> DistanceField::get_next(const Point& cell) const {
+    int distance = get_distance(cell);
+    if (distance == 0 || distance == UNREACHABLE) {
+        return std::nullopt;
+    }
+    for (const auto& neighbor : cell.get_neighbors()) {
+        if (is_valid_move(cell, neighbor) &&
+            get_distance(neighbor) + cell.get_move_cost(neighbor) ==
+                distance) {
+            return neighbor;
+        }
+    }
+    return std::nullopt;
+}
+
+int DistanceField::cell_id(const Point& cell) const noexcept {
+    int local_x = cell.get_x() - _lower_left.get_x();
+    int local_y = cell.get_y() - _lower_left.get_y();
+    if (local_x < 0 || local_y < 0 || local_x >= _width ||
+        local_y >= _height) {
+        return -1;
+    }
+    return local_y * _width + local_x;
+}
+
+void DistanceField::remove_crossed_moves(const Border& border) {
+    // Border coordinates are cell corners: cell (x, y) is the square
+    // [x, x + 1] x [y, y + 1]. The forward moves of a cell stay inside the
+    // square [x - 1, x + 2] x [y - 1, y + 2], so only cells whose square
+    // touches the border are tested, column by column.
+    const Point& first = border.get_first();
+    const Point& second = border.get_second();
+    int min_x = std::min(first.get_x(), second.get_x());
+    int max_x = std::max(first.get_x(), second.get_x());
+    auto y_at = [&first, &second](double x) {
+        if (first.get_x() == second.get_x()) {
+            return double(first.get_y());
+        }
+        return first.get_y() + (x - first.get_x()) *
+                                   (second.get_y() - first.get_y()) /
+                                   (second.get_x() - first.get_x());
+    };
+    for (int x = min_x - 2; x <= max_x + 1; ++x) {
+        double from_x = std::max(x - 1, min_x);
+        double to_x = std::min(x + 2, max_x);
+        double low = std::min(y_at(from_x), y_at(to_x));
+        double high = std::max(y_at(from_x), y_at(to_x));
+        if (first.get_x() == second.get_x()) {
+            low = std::min(first.get_y(), second.get_y());
+            high = std::max(first.get_y(), second.get_y());
+        }
+        int from_y = static_cast<int>(std::floor(low)) - 2;
+        int to_y = static_cast<int>(std::ceil(high)) + 1;
+        for (int y = from_y; y <= to_y; ++y) {
+            Point cell(x, y);
+            int id = cell_id(cell);
+            if (id < 0) {
+                continue;
+            }
+            for (int direction : FORWARD_DIRECTIONS) {
+                auto [dx, dy] = DIRECTIONS[std::size_t(direction)];
+                Point neighbor(x + dx, y + dy);
+                if ((_moves[std::size_t(id)] & (1 << direction)) == 0 ||
+                    !border.is_intersecting(Segment(cell, neighbor))) {
+                    continue;
+                }
+                _moves[std::size_t(id)] &= std::uint8_t(~(1 << direction));
+                _moves[std::size_t(cell_id(neighbor))] &=
+                    std::uint8_t(~(1 << OPPOSITE[std::size_t(direction)]));
+            }
+        }
+    }
+}
+
+int DistanceField::direction_index(const Point& from,
+                                   const Point& to) noexcept {
+    // Index of (dx, dy) in DIRECTIONS by (dx + 1) * 3 + (dy + 1)
+    constexpr std::array<int, 9> INDICES = {5, 7, 2, 3, -1, 0, 4, 6, 1};
+    int dx = to.get_x() - from.get_x();
+    int dy = to.get_y() - from.get_y();
+    if (dx < -1 || dx > 1 || dy < -1 || dy > 1) {
+        return -1;
+    }
+    return INDICES[std::size_t((dx + 1) * 3 + (dy + 1))];
+}
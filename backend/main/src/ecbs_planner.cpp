@@ -0,0 +1,532 @@
+#include "ecbs_planner.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace {
+// Staying first, then every move next to the opposite one
+constexpr std::array MOVES = {
+    Action::WAIT,
+    Action::UP,
+    Action::DOWN,
+    Action::RIGHT,
+    Action::LEFT,
+    Action::RIGHT_UP,
+    Action::LEFT_DOWN,
+    Action::LEFT_UP,
+    Action::RIGHT_DOWN,
+};
+
+constexpr int opposite(int move) noexcept {
+    return move % 2 == 1 ? move + 1 : move - 1;
+}
+
+int move_index(Action action) noexcept {
+    return int(std::find(MOVES.begin(), MOVES.end(), action) - MOVES.begin());
+}
+
+// End of the stay of a person standing where it is
+constexpr int FOREVER = std::numeric_limits<int>::max();
+}  // namespace
+
+EcbsPlanner::EcbsPlanner(const std::vector<Person>& persons,
+                         const std::vector<Goal>& goals, Grid* grid,
+                         EcbsOptions options)
+    : Planner(persons, goals, grid),
+      _options(options),
+      _field(*grid, get_goal_positions()),
+      _lower_left(grid->get_lower_left()),
+      _width(std::max(0, grid->get_upper_right().get_x() -
+                             grid->get_lower_left().get_x() + 1)),
+      _height(std::max(0, grid->get_upper_right().get_y() -
+                              grid->get_lower_left().get_y() + 1)),
+      _focal_bound(0) {
+    _options.suboptimality = std::max(1.0, _options.suboptimality);
+}
+
+std::vector<std::vector<Action>> EcbsPlanner::plan_all_routes() {
+    _stats.clear();
+    _partial = false;
+    _nodes.clear();
+    _by_lower_bound.clear();
+    _by_cost.clear();
+    _focal.clear();
+    _starts.clear();
+    _blocked.assign(std::size_t(_width) * std::size_t(_height), 0);
+    std::vector<int> movers;
+    for (int i = 0; i < static_cast<int>(_persons.size()); ++i) {
+        auto position = _persons[std::size_t(i)].get_position();
+        int distance = _field.get_distance(position);
+        _starts.push_back(cell_id(position));
+        if (distance == DistanceField::UNREACHABLE) {
+            if (_starts.back() >= 0) {
+                _blocked[std::size_t(_starts.back())] = 1;
+            }
+        } else if (distance > 0) {
+            movers.push_back(i);
+        }
+    }
+
+    // A person without any route stands in the way of the others, so they
+    // are planned again around it
+    Paths paths;
+    for (bool is_blocked_more = true; is_blocked_more;) {
+        is_blocked_more = false;
+        paths.assign(_persons.size(), nullptr);
+        for (int agent : movers) {
+            auto start = std::size_t(_starts[std::size_t(agent)]);
+            if (_blocked[start]) {
+                continue;
+            }
+            paths[std::size_t(agent)] = plan_path(agent, paths, -1);
+            if (!paths[std::size_t(agent)]) {
+                _blocked[start] = 1;
+                is_blocked_more = true;
+            }
+        }
+    }
+    HighNode root{-1, {-1, -1, 0, 0}, std::move(paths), 0, 0, 0};
+    for (const auto& path : root.paths) {
+        if (path) {
+            root.cost += path->cost;
+            root.lower_bound += path->lower_bound;
+        }
+    }
+    root.conflicts =
+        static_cast<std::int64_t>(find_conflicts(root.paths).size());
+    _nodes.push_back(std::move(root));
+    _focal_bound = 0;
+    open_node(0);
+
+    Paths best = _nodes.front().paths;
+    std::int64_t best_conflicts = _nodes.front().conflicts;
+    std::int64_t lower_bound = 0;
+    int solution = -1;
+    while (!_by_lower_bound.empty()) {
+        if (_budget->is_exhausted()) {
+            _partial = true;
+            break;
+        }
+        if (_stats["high_level_nodes"] >= _options.max_nodes) {
+            break;
+        }
+        lower_bound = _by_lower_bound.begin()->first;
+        update_focal(lower_bound);
+        int index = std::get<2>(*_focal.begin());
+        close_node(index);
+        ++_stats["high_level_nodes"];
+        if (_nodes[std::size_t(index)].conflicts == 0) {
+            solution = index;
+            break;
+        }
+
+        auto conflicts = find_conflicts(_nodes[std::size_t(index)].paths);
+        auto conflict = *std::min_element(
+            conflicts.begin(), conflicts.end(),
+            [](const Conflict& lhs, const Conflict& rhs) {
+                return lhs.time < rhs.time;
+            });
+        // Either person keeps away, from the same cell or from the move in
+        // the other direction
+        std::array<Constraint, 2> constraints = {
+            Constraint{conflict.agent, conflict.cell, conflict.move,
+                       conflict.time},
+            Constraint{conflict.other, conflict.cell, 0, conflict.time}};
+        if (conflict.move > 0) {
+            auto to = to_point(conflict.cell) +
+                      MOVES[std::size_t(conflict.move)];
+            constraints[1] = {conflict.other, cell_id(to),
+                              opposite(conflict.move), conflict.time};
+        }
+        for (const auto& constraint : constraints) {
+            auto agent = std::size_t(constraint.agent);
+            if (!_nodes[std::size_t(index)].paths[agent]) {
+                continue;
+            }
+            _nodes.push_back({index, constraint,
+                              _nodes[std::size_t(index)].paths, 0, 0, 0});
+            auto& child = _nodes.back();
+            auto path = plan_path(constraint.agent, child.paths,
+                                  static_cast<int>(_nodes.size()) - 1);
+            if (!path) {
+                _nodes.pop_back();
+                continue;
+            }
+            const auto& parent = _nodes[std::size_t(index)];
+            child.cost = parent.cost - parent.paths[agent]->cost + path->cost;
+            child.lower_bound = parent.lower_bound -
+                                parent.paths[agent]->lower_bound +
+                                path->lower_bound;
+            child.paths[agent] = std::move(path);
+            child.conflicts =
+                static_cast<std::int64_t>(find_conflicts(child.paths).size());
+            if (child.conflicts < best_conflicts) {
+                best = child.paths;
+                best_conflicts = child.conflicts;
+            }
+            open_node(static_cast<int>(_nodes.size()) - 1);
+        }
+        // Only the nodes still open need their routes
+        Paths().swap(_nodes[std::size_t(index)].paths);
+    }
+
+    if (solution >= 0) {
+        paths = std::move(_nodes[std::size_t(solution)].paths);
+        const auto& node = _nodes[std::size_t(solution)];
+        _stats["sum_of_costs"] = node.cost;
+        _stats["lower_bound"] = lower_bound;
+        // Cost of the routes to the lower bound, in thousandths
+        _stats["bound_permille"] =
+            lower_bound > 0 ? (1000 * node.cost + lower_bound - 1) / lower_bound
+                            : 1000;
+    } else {
+        paths = drop_conflicting(std::move(best));
+    }
+
+    std::vector<std::vector<Action>> routes(_persons.size());
+    for (int agent : movers) {
+        const auto& path = paths[std::size_t(agent)];
+        if (!path) {
+            ++_stats["failed_routes"];
+            continue;
+        }
+        routes[std::size_t(agent)] = path->actions;
+    }
+    _stats["high_level_generated"] = static_cast<std::int64_t>(_nodes.size());
+    return routes;
+}
+
+std::map<std::string, std::int64_t> EcbsPlanner::get_stats() const {
+    return _stats;
+}
+
+std::shared_ptr<const EcbsPlanner::Path> EcbsPlanner::plan_path(
+    int agent, const Paths& paths, int node) {
+    FlatHashSet<std::uint64_t> forbidden;
+    // Past the horizon nothing constrains the person or collides with it
+    int horizon = 0;
+    for (int index = node; index >= 0;
+         index = _nodes[std::size_t(index)].parent) {
+        const auto& constraint = _nodes[std::size_t(index)].constraint;
+        if (constraint.agent == agent) {
+            forbidden.insert(
+                pack(constraint.cell, constraint.move, constraint.time));
+            horizon = std::max(horizon, constraint.time);
+        }
+    }
+    // Ticks and moves of the other persons, to collide with them as rarely
+    // as possible
+    FlatHashMap<std::uint64_t, int> others;
+    for (std::size_t other = 0; other < paths.size(); ++other) {
+        if (other == std::size_t(agent) || !paths[other]) {
+            continue;
+        }
+        const auto& visits = paths[other]->visits;
+        for (std::size_t k = 0; k < visits.size(); ++k) {
+            for (int time = visits[k].start; time <= visits[k].end; ++time) {
+                ++others[pack(visits[k].cell, 0, time)];
+            }
+            horizon = std::max(horizon, visits[k].end);
+            if (k + 1 < visits.size()) {
+                auto action = to_point(visits[k].cell)
+                                  .to_another(to_point(visits[k + 1].cell));
+                ++others[pack(visits[k].cell, move_index(action),
+                              visits[k + 1].start)];
+            }
+        }
+    }
+    auto count = [&others](std::uint64_t key) {
+        const int* found = others.find(key);
+        return found ? *found : 0;
+    };
+    auto is_free_way = [this](Point position) {
+        while (auto next = _field.get_next(position)) {
+            if (_blocked[std::size_t(cell_id(*next))]) {
+                return false;
+            }
+            position = *next;
+        }
+        return true;
+    };
+
+    // Every way to a cell at a tick costs the same, so a node is kept per
+    // cell and tick, with the fewest collisions found
+    std::vector<LowNode> nodes;
+    FlatHashMap<std::uint64_t, int> states;
+    std::set<std::pair<int, int>> open;
+    std::set<std::tuple<int, int, int, int>> focal;
+    int start = _starts[std::size_t(agent)];
+    int f_min = _field.get_distance(to_point(start));
+    int bound = int(double(f_min) * _options.suboptimality);
+    nodes.push_back({start, 0, -1, 0, 0, false});
+    states.insert(pack(start, 0, 0), 0);
+    open.insert({f_min, 0});
+    focal.insert({0, f_min, 0, 0});
+
+    const std::int64_t limit = _budget->get_share(1);
+    std::int64_t expansions = 0;
+    int found = -1;
+    while (!open.empty() && expansions < limit) {
+        if (open.begin()->first > f_min) {
+            f_min = open.begin()->first;
+            int next_bound = int(double(f_min) * _options.suboptimality);
+            for (auto it = open.upper_bound(
+                     {bound, std::numeric_limits<int>::max()});
+                 it != open.end() && it->first <= next_bound; ++it) {
+                const auto& added = nodes[std::size_t(it->second)];
+                focal.insert(
+                    {added.conflicts, it->first, -added.time, it->second});
+            }
+            bound = next_bound;
+        }
+        auto [conflicts, f, negative_time, index] = *focal.begin();
+        focal.erase(focal.begin());
+        open.erase({f, index});
+        nodes[std::size_t(index)].is_closed = true;
+        ++expansions;
+        const LowNode current = nodes[std::size_t(index)];
+        const Point from = to_point(current.cell);
+        if (_field.get_distance(from) == 0 ||
+            (current.time > horizon && is_free_way(from))) {
+            found = index;
+            break;
+        }
+
+        for (std::size_t move = 0; move < MOVES.size(); ++move) {
+            const Point to = from + MOVES[move];
+            if (move > 0 &&
+                (!_field.is_valid_move(from, to) ||
+                 _field.get_distance(to) == DistanceField::UNREACHABLE)) {
+                continue;
+            }
+            int cell = cell_id(to);
+            if (move > 0 && _blocked[std::size_t(cell)]) {
+                continue;
+            }
+            // The person stays in the cell it leaves until it arrives
+            int arrival = current.time + get_cost(MOVES[move]);
+            auto key = pack(cell, 0, arrival);
+            bool is_allowed =
+                !forbidden.contains(key) &&
+                !forbidden.contains(pack(current.cell, int(move), arrival));
+            int added = current.conflicts + count(key);
+            if (move > 0) {
+                added += count(pack(cell, opposite(int(move)), arrival));
+            }
+            for (int time = current.time + 1; time < arrival; ++time) {
+                auto stay = pack(current.cell, 0, time);
+                is_allowed = is_allowed && !forbidden.contains(stay);
+                added += count(stay);
+            }
+            if (!is_allowed) {
+                continue;
+            }
+            int next_f = arrival + _field.get_distance(to);
+            if (int* existing = states.find(key)) {
+                auto& seen = nodes[std::size_t(*existing)];
+                if (seen.is_closed || seen.conflicts <= added) {
+                    continue;
+                }
+                if (next_f <= bound) {
+                    focal.erase({seen.conflicts, next_f, -arrival, *existing});
+                    focal.insert({added, next_f, -arrival, *existing});
+                }
+                seen.parent = index;
+                seen.move = int(move);
+                seen.conflicts = added;
+                continue;
+            }
+            int next = static_cast<int>(nodes.size());
+            nodes.push_back({cell, arrival, index, int(move), added, false});
+            states.insert(key, next);
+            open.insert({next_f, next});
+            if (next_f <= bound) {
+                focal.insert({added, next_f, -arrival, next});
+            }
+        }
+    }
+    _budget->spend(expansions);
+    _stats["low_level_expansions"] += expansions;
+    if (found < 0) {
+        return nullptr;
+    }
+
+    std::vector<Action> actions;
+    for (int index = found; nodes[std::size_t(index)].parent >= 0;
+         index = nodes[std::size_t(index)].parent) {
+        actions.push_back(MOVES[std::size_t(nodes[std::size_t(index)].move)]);
+    }
+    std::reverse(actions.begin(), actions.end());
+    // Past the horizon the rest of the way follows the distance field
+    Point position = to_point(nodes[std::size_t(found)].cell);
+    while (auto next = _field.get_next(position)) {
+        actions.push_back(position.to_another(*next));
+        position = *next;
+    }
+    return std::make_shared<const Path>(
+        make_path(agent, std::move(actions), f_min));
+}
+
+void EcbsPlanner::open_node(int node) {
+    const auto& added = _nodes[std::size_t(node)];
+    _by_lower_bound.insert({added.lower_bound, node});
+    _by_cost.insert({added.cost, node});
+    if (added.cost <= _focal_bound) {
+        _focal.insert({added.conflicts, added.cost, node});
+    }
+}
+
+void EcbsPlanner::close_node(int node) {
+    const auto& removed = _nodes[std::size_t(node)];
+    _by_lower_bound.erase({removed.lower_bound, node});
+    _by_cost.erase({removed.cost, node});
+    _focal.erase({removed.conflicts, removed.cost, node});
+}
+
+void EcbsPlanner::update_focal(std::int64_t lower_bound) {
+    auto bound = static_cast<std::int64_t>(
+        std::floor(double(lower_bound) * _options.suboptimality));
+    auto first = _by_cost.upper_bound(
+        {std::min(bound, _focal_bound), std::numeric_limits<int>::max()});
+    auto last = _by_cost.upper_bound(
+        {std::max(bound, _focal_bound), std::numeric_limits<int>::max()});
+    for (auto it = first; it != last; ++it) {
+        const auto& node = _nodes[std::size_t(it->second)];
+        if (bound > _focal_bound) {
+            _focal.insert({node.conflicts, node.cost, it->second});
+        } else {
+            _focal.erase({node.conflicts, node.cost, it->second});
+        }
+    }
+    _focal_bound = bound;
+}
+
+std::vector<EcbsPlanner::Conflict> EcbsPlanner::find_conflicts(
+    const Paths& paths) const {
+    // Stays of all persons by cell, the ones standing where they are last
+    // the whole time
+    std::vector<std::tuple<int, int, int, int>> stays;
+    FlatHashMap<std::uint64_t, int> moves;
+    for (std::size_t agent = 0; agent < paths.size(); ++agent) {
+        if (!paths[agent]) {
+            if (_starts[agent] >= 0 &&
+                _field.get_distance(_persons[agent].get_position()) != 0) {
+                stays.emplace_back(_starts[agent], 0, FOREVER, int(agent));
+            }
+            continue;
+        }
+        const auto& visits = paths[agent]->visits;
+        for (std::size_t k = 0; k < visits.size(); ++k) {
+            stays.emplace_back(visits[k].cell, visits[k].start, visits[k].end,
+                               int(agent));
+            if (k + 1 < visits.size()) {
+                auto action = to_point(visits[k].cell)
+                                  .to_another(to_point(visits[k + 1].cell));
+                moves.insert(pack(visits[k].cell, move_index(action),
+                                  visits[k + 1].start),
+                             int(agent));
+            }
+        }
+    }
+    std::sort(stays.begin(), stays.end());
+
+    std::vector<Conflict> conflicts;
+    std::size_t first = 0;
+    for (std::size_t i = 0; i < stays.size(); ++i) {
+        auto [cell, start, end, agent] = stays[i];
+        if (std::get<0>(stays[first]) != cell) {
+            first = i;
+        }
+        for (std::size_t j = first; j < i; ++j) {
+            if (std::get<2>(stays[j]) >= start) {
+                conflicts.push_back(
+                    {std::get<3>(stays[j]), agent, cell, 0, start});
+            }
+        }
+    }
+    // Two persons swapping cells take the same moves in opposite directions
+    for (std::size_t agent = 0; agent < paths.size(); ++agent) {
+        if (!paths[agent]) {
+            continue;
+        }
+        const auto& visits = paths[agent]->visits;
+        for (std::size_t k = 0; k + 1 < visits.size(); ++k) {
+            auto action = to_point(visits[k].cell)
+                              .to_another(to_point(visits[k + 1].cell));
+            const int* other =
+                moves.find(pack(visits[k + 1].cell,
+                                opposite(move_index(action)),
+                                visits[k + 1].start));
+            if (other && *other > int(agent)) {
+                conflicts.push_back({int(agent), *other, visits[k].cell,
+                                     move_index(action),
+                                     visits[k + 1].start});
+            }
+        }
+    }
+    return conflicts;
+}
+
+EcbsPlanner::Paths EcbsPlanner::drop_conflicting(Paths paths) {
+    // Every round drops a path or ends, two persons without paths that
+    // conflict stand where they are and nothing can be dropped
+    for (bool has_dropped = true; has_dropped;) {
+        has_dropped = false;
+        for (const auto& conflict : find_conflicts(paths)) {
+            // A person left standing can only make the other one stand too
+            auto dropped = std::size_t(conflict.other);
+            if (!paths[dropped]) {
+                dropped = std::size_t(conflict.agent);
+            }
+            if (paths[dropped]) {
+                paths[dropped] = nullptr;
+                has_dropped = true;
+            }
+        }
+    }
+    return paths;
+}
+
+EcbsPlanner::Path EcbsPlanner::make_path(int agent, std::vector<Action> actions,
+                                         int lower_bound) const {
+    Path path{std::move(actions), {}, 0, lower_bound};
+    Point position = _persons[std::size_t(agent)].get_position();
+    int start = 0;
+    for (auto action : path.actions) {
+        int cost = get_cost(action);
+        if (action != Action::WAIT) {
+            path.visits.push_back(
+                {cell_id(position), start, path.cost + cost - 1});
+            position = position + action;
+            start = path.cost + cost;
+        }
+        path.cost += cost;
+    }
+    // The person leaves the map right after it arrives
+    path.visits.push_back({cell_id(position), start, path.cost});
+    return path;
+}
+
+int EcbsPlanner::cell_id(const Point& cell) const noexcept {
+    int local_x = cell.get_x() - _lower_left.get_x();
+    int local_y = cell.get_y() - _lower_left.get_y();
+    if (local_x < 0 || local_y < 0 || local_x >= _width ||
+        local_y >= _height) {
+        return -1;
+    }
+    return local_y * _width + local_x;
+}
+
+Point EcbsPlanner::to_point(int cell) const noexcept {
+    return Point(_lower_left.get_x() + cell % _width,
+                 _lower_left.get_y() + cell / _width);
+}
+
+std::uint64_t EcbsPlanner::pack(int cell, int move, int time) noexcept {
+    // Cells take 28 bits, moves 4 and ticks 32
+    return (std::uint64_t(static_cast<std::uint32_t>(cell)) << 36) |
+           (std::uint64_t(move) << 32) |
+           std::uint64_t(static_cast<std::uint32_t>(time));
+}
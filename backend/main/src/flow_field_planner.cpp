@@ -0,0 +1,189 @@
+#include "flow_field_planner.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+constexpr std::array MOVES = {
+    Action::UP,      Action::DOWN,     Action::LEFT,      Action::RIGHT,
+    Action::LEFT_UP, Action::RIGHT_UP, Action::LEFT_DOWN, Action::RIGHT_DOWN,
+};
+constexpr std::uint16_t NO_CHOICE = 0xF;
+// Ticks of the longest action, decisions are kept in that many buckets
+constexpr std::size_t BUCKETS = 4;
+// Without moves for that long every person has decided again with nothing
+// changed around it, so nobody will ever move
+constexpr int STUCK_TICKS = 6;
+}  // namespace
+
+FlowFieldPlanner::FlowFieldPlanner(const std::vector<Person>& persons,
+                                   const std::vector<Goal>& goals, Grid* grid)
+    : Planner(persons, goals, grid),
+      _field(*grid, get_goal_positions()),
+      _lower_left(grid->get_lower_left()),
+      _width(std::max(0, grid->get_upper_right().get_x() -
+                             grid->get_lower_left().get_x() + 1)),
+      _height(std::max(0, grid->get_upper_right().get_y() -
+                              grid->get_lower_left().get_y() + 1)) {
+    for (std::size_t k = 0; k < MOVES.size(); ++k) {
+        Point offset = Point(0, 0) + MOVES[k];
+        _offsets[k] = offset.get_y() * _width + offset.get_x();
+    }
+    std::size_t cell_count = std::size_t(_width) * std::size_t(_height);
+    _choices.assign(cell_count, NO_CHOICE);
+    std::vector<std::pair<int, std::uint16_t>> closer;
+    for (std::size_t cell = 0; cell < cell_count; ++cell) {
+        Point point = to_point(int(cell));
+        int distance = _field.get_distance(point);
+        if (distance == DistanceField::UNREACHABLE || distance == 0) {
+            continue;
+        }
+        closer.clear();
+        for (std::size_t k = 0; k < MOVES.size(); ++k) {
+            Point next = point + MOVES[k];
+            int next_distance = _field.get_distance(next);
+            if (next_distance < distance &&
+                _field.is_valid_move(point, next)) {
+                closer.emplace_back(get_cost(MOVES[k]) + next_distance,
+                                    std::uint16_t(k));
+            }
+        }
+        std::stable_sort(closer.begin(), closer.end(),
+                         [](const auto& lhs, const auto& rhs) {
+                             return lhs.first < rhs.first;
+                         });
+        std::uint16_t choices = 0;
+        for (std::size_t k = 0; k < MAX_CHOICES; ++k) {
+            auto choice = k < closer.size() ? closer[k].second : NO_CHOICE;
+            choices = std::uint16_t(choices | (choice << (4 * k)));
+            if (choice == NO_CHOICE) {
+                break;
+            }
+        }
+        _choices[cell] = choices;
+    }
+}
+
+std::vector<std::vector<Action>> FlowFieldPlanner::plan_all_routes() {
+    _stats.clear();
+    _partial = false;
+    std::vector<std::vector<Action>> routes(_persons.size());
+    std::vector<std::uint8_t> occupied(_choices.size(), 0);
+    // Cell of every person and the cell it is leaving, -1 if none
+    std::vector<int> cells(_persons.size(), -1);
+    std::vector<int> previous(_persons.size(), -1);
+    // Persons by the tick of their next decision modulo BUCKETS
+    std::array<std::vector<int>, BUCKETS> due;
+    std::vector<int> deciding;
+    std::int64_t walking = 0;
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        auto position = _persons[i].get_position();
+        int cell = cell_id(position);
+        int distance = _field.get_distance(position);
+        if (cell < 0 || distance == 0) {
+            continue;
+        }
+        // Persons that can not reach a goal stand in the way forever
+        occupied[std::size_t(cell)] = 1;
+        if (distance != DistanceField::UNREACHABLE) {
+            cells[i] = cell;
+            // Every action but waits brings the person closer by 2 or 3
+            routes[i].reserve(std::size_t(distance / get_cost(Action::UP)));
+            due[0].push_back(int(i));
+            ++walking;
+        }
+    }
+
+    int last_move = 0;
+    int tick = 0;
+    // The walk is one search and every tick of it is one expansion
+    for (; walking > 0 && tick < _budget->get_search_limit() &&
+           tick - last_move <= STUCK_TICKS;
+         ++tick) {
+        if (_budget->is_exhausted()) {
+            _partial = true;
+            break;
+        }
+        _budget->spend(1);
+        deciding.clear();
+        std::swap(deciding, due[std::size_t(tick) % BUCKETS]);
+
+        // Cells left by the moves ending now are free before anybody decides
+        for (int agent : deciding) {
+            auto index = std::size_t(agent);
+            if (previous[index] >= 0) {
+                occupied[std::size_t(previous[index])] = 0;
+                previous[index] = -1;
+            }
+            if (_choices[std::size_t(cells[index])] == NO_CHOICE) {
+                occupied[std::size_t(cells[index])] = 0;
+                cells[index] = -1;
+                --walking;
+            }
+        }
+        for (int agent : deciding) {
+            auto index = std::size_t(agent);
+            int cell = cells[index];
+            if (cell < 0) {
+                continue;
+            }
+            auto action = Action::WAIT;
+            auto choices = _choices[std::size_t(cell)];
+            for (std::size_t k = 0; k < MAX_CHOICES; ++k) {
+                auto move = std::size_t((choices >> (4 * k)) & NO_CHOICE);
+                if (move == NO_CHOICE) {
+                    break;
+                }
+                int next = cell + _offsets[move];
+                if (!occupied[std::size_t(next)]) {
+                    occupied[std::size_t(next)] = 1;
+                    previous[index] = cell;
+                    cells[index] = next;
+                    action = MOVES[move];
+                    last_move = tick;
+                    break;
+                }
+            }
+            routes[index].push_back(action);
+            due[std::size_t(tick + get_cost(action)) % BUCKETS].push_back(
+                agent);
+        }
+    }
+
+    _stats["ticks"] = tick;
+    _stats["unfinished_routes"] = walking;
+    for (auto& route : routes) {
+        // A stuck person stands at the end of its route anyway
+        while (!route.empty() && route.back() == Action::WAIT) {
+            route.pop_back();
+        }
+        std::int64_t cost = 0;
+        for (auto action : route) {
+            cost += get_cost(action);
+            if (action == Action::WAIT) {
+                ++_stats["waits"];
+            }
+        }
+        _stats["makespan"] = std::max(_stats["makespan"], cost);
+    }
+    return routes;
+}
+
+std::map<std::string, std::int64_t> FlowFieldPlanner::get_stats() const {
+    return _stats;
+}
+
+int FlowFieldPlanner::cell_id(const Point& cell) const noexcept {
+    int local_x = cell.get_x() - _lower_left.get_x();
+    int local_y = cell.get_y() - _lower_left.get_y();
+    if (local_x < 0 || local_y < 0 || local_x >= _width ||
+        local_y >= _height) {
+        return -1;
+    }
+    return local_y * _width + local_x;
+}
+
+Point FlowFieldPlanner::to_point(int cell) const noexcept {
+    return Point(_lower_left.get_x() + cell % _width,
+                 _lower_left.get_y() + cell / _width);
+}
@@ -0,0 +1,585 @@
+#include "flow_planner.h"
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <utility>
+
+namespace {
+// Cells copied for all steps of one network at most
+constexpr std::int64_t MAX_NETWORK_CELLS = std::int64_t(1) << 22;
+constexpr std::array STRAIGHT_MOVES = {
+    Action::UP,
+    Action::DOWN,
+    Action::LEFT,
+    Action::RIGHT,
+};
+
+// Unit capacity network for Dinic's algorithm. Every edge is stored next to
+// its reverse edge, forward edges have even indices.
+class FlowNetwork {
+ public:
+    explicit FlowNetwork(int vertices) : _vertex_count(vertices) {}
+
+    // Index of the first of <count> new vertices
+    int add_vertices(int count) {
+        int first = _vertex_count;
+        _vertex_count += count;
+        return first;
+    }
+
+    int get_vertex_count() const noexcept { return _vertex_count; }
+
+    void add_edge(int from, int to) {
+        _edges.push_back({to, 1});
+        _edges.push_back({from, 0});
+    }
+
+    // Groups the edges by vertex, no edges are added afterwards
+    void finish() {
+        _offsets.assign(std::size_t(_vertex_count) + 1, 0);
+        // The reverse edge leads back to the vertex an edge leaves
+        for (std::size_t e = 0; e < _edges.size(); ++e) {
+            ++_offsets[std::size_t(_edges[e ^ 1].to) + 1];
+        }
+        for (std::size_t v = 0; v < std::size_t(_vertex_count); ++v) {
+            _offsets[v + 1] += _offsets[v];
+        }
+        _incident.resize(_edges.size());
+        auto fill = _offsets;
+        for (std::size_t e = 0; e < _edges.size(); ++e) {
+            auto from = std::size_t(_edges[e ^ 1].to);
+            _incident[std::size_t(fill[from]++)] = int(e);
+        }
+    }
+
+    // Sends one unit along the free edge from <from> to <to>, false if there
+    // is none
+    bool send(int from, int to) {
+        for (int k = _offsets[std::size_t(from)];
+             k < _offsets[std::size_t(from) + 1]; ++k) {
+            auto e = std::size_t(_incident[std::size_t(k)]);
+            if (e % 2 == 0 && _edges[e].to == to && _edges[e].capacity > 0) {
+                --_edges[e].capacity;
+                ++_edges[e ^ 1].capacity;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Vertices the edges from <from> lead to
+    template <class Visitor>
+    void for_each_next(int from, Visitor visitor) const {
+        for (int k = _offsets[std::size_t(from)];
+             k < _offsets[std::size_t(from) + 1]; ++k) {
+            auto e = std::size_t(_incident[std::size_t(k)]);
+            if (e % 2 == 0) {
+                visitor(_edges[e].to);
+            }
+        }
+    }
+
+    // A unit goes along the edge from <from> to <to>. Only the few edges
+    // entering <to> are looked at, so the source may have many.
+    bool is_used(int from, int to) const {
+        for (int k = _offsets[std::size_t(to)];
+             k < _offsets[std::size_t(to) + 1]; ++k) {
+            auto e = std::size_t(_incident[std::size_t(k)]);
+            if (e % 2 == 1 && _edges[e].to == from && _edges[e].capacity > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Vertex the unit leaving <from> goes to, -1 if no unit leaves it
+    int get_next(int from) const {
+        for (int k = _offsets[std::size_t(from)];
+             k < _offsets[std::size_t(from) + 1]; ++k) {
+            auto e = std::size_t(_incident[std::size_t(k)]);
+            if (e % 2 == 0 && _edges[e].capacity == 0) {
+                return _edges[e].to;
+            }
+        }
+        return -1;
+    }
+
+    // Augments the flow until it is maximal or the budget runs out, returns
+    // the number of units added. Every vertex reached by a breadth-first
+    // search counts as an expansion.
+    int augment(int source, int sink, SearchBudget& budget,
+                std::int64_t& expansions, bool& cut) {
+        int flow = 0;
+        std::vector<int> level(static_cast<std::size_t>(_vertex_count));
+        std::vector<int> next(static_cast<std::size_t>(_vertex_count));
+        std::vector<int> queue;
+        std::vector<std::size_t> path;
+        while (true) {
+            if (budget.is_exhausted()) {
+                cut = true;
+                break;
+            }
+            std::fill(level.begin(), level.end(), -1);
+            level[std::size_t(source)] = 0;
+            queue.assign(1, source);
+            for (std::size_t head = 0;
+                 head < queue.size() && level[std::size_t(sink)] < 0; ++head) {
+                auto v = std::size_t(queue[head]);
+                for (int k = _offsets[v]; k < _offsets[v + 1]; ++k) {
+                    const auto& edge =
+                        _edges[std::size_t(_incident[std::size_t(k)])];
+                    if (edge.capacity > 0 && level[std::size_t(edge.to)] < 0) {
+                        level[std::size_t(edge.to)] = level[v] + 1;
+                        queue.push_back(edge.to);
+                    }
+                }
+            }
+            expansions += std::int64_t(queue.size());
+            budget.spend(std::int64_t(queue.size()));
+            if (level[std::size_t(sink)] < 0) {
+                break;
+            }
+
+            // Blocking flow along the levels, the depth-first search keeps
+            // its path on a stack since paths are as long as the horizon
+            std::copy(_offsets.begin(), _offsets.end() - 1, next.begin());
+            int v = source;
+            path.clear();
+            while (true) {
+                if (v == sink) {
+                    for (auto e : path) {
+                        --_edges[e].capacity;
+                        ++_edges[e ^ 1].capacity;
+                    }
+                    ++flow;
+                    path.clear();
+                    v = source;
+                    continue;
+                }
+                bool advanced = false;
+                auto& k = next[std::size_t(v)];
+                for (; k < _offsets[std::size_t(v) + 1]; ++k) {
+                    auto e = std::size_t(_incident[std::size_t(k)]);
+                    const auto& edge = _edges[e];
+                    if (edge.capacity > 0 && level[std::size_t(edge.to)] ==
+                                                 level[std::size_t(v)] + 1) {
+                        path.push_back(e);
+                        v = edge.to;
+                        advanced = true;
+                        break;
+                    }
+                }
+                if (!advanced) {
+                    if (v == source) {
+                        break;
+                    }
+                    level[std::size_t(v)] = -1;
+                    auto e = path.back();
+                    path.pop_back();
+                    v = _edges[e ^ 1].to;
+                    ++next[std::size_t(v)];
+                }
+            }
+        }
+        return flow;
+    }
+
+ private:
+    struct Edge {
+        int to;
+        int capacity;
+    };
+
+    int _vertex_count;
+    std::vector<Edge> _edges;
+    // Edges leaving vertex v are _incident[_offsets[v].._offsets[v + 1])
+    std::vector<int> _offsets;
+    std::vector<int> _incident;
+};
+}  // namespace
+
+FlowPlanner::FlowPlanner(const std::vector<Person>& persons,
+                         const std::vector<Goal>& goals, Grid* grid)
+    : Planner(persons, goals, grid),
+      _field(*grid, get_goal_positions(), false),
+      _lower_left(grid->get_lower_left()),
+      _width(std::max(0, grid->get_upper_right().get_x() -
+                             grid->get_lower_left().get_x() + 1)),
+      _height(std::max(0, grid->get_upper_right().get_y() -
+                              grid->get_lower_left().get_y() + 1)) {}
+
+std::vector<std::vector<Action>> FlowPlanner::plan_all_routes() {
+    std::size_t cell_count = std::size_t(_width) * std::size_t(_height);
+    const int step_cost = get_cost(Action::WAIT);
+    _to_goals.resize(cell_count);
+    for (std::size_t cell = 0; cell < cell_count; ++cell) {
+        int distance = _field.get_distance(to_point(int(cell)));
+        _to_goals[cell] = distance == DistanceField::UNREACHABLE
+                              ? DistanceField::UNREACHABLE
+                              : distance / step_cost;
+    }
+    _blocked.assign(cell_count, 0);
+    _movers.clear();
+    _delays.clear();
+    _stats.clear();
+    _partial = false;
+
+    std::vector<std::vector<Action>> routes(_persons.size());
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        auto position = _persons[i].get_position();
+        int distance = _field.get_distance(position);
+        if (distance == DistanceField::UNREACHABLE) {
+            // Stands in the way forever
+            int cell = cell_id(position);
+            if (cell >= 0) {
+                _blocked[std::size_t(cell)] = 1;
+            }
+        } else if (distance > 0) {
+            _movers.push_back(int(i));
+        }
+    }
+
+    // Nobody is anywhere earlier than its distance from the nearest start
+    _from_starts.assign(cell_count, DistanceField::UNREACHABLE);
+    std::vector<int> queue;
+    std::vector<int> queued(cell_count, 0);
+    int lower = 0;
+    for (int agent : _movers) {
+        int cell = cell_id(_persons[std::size_t(agent)].get_position());
+        _delays.push_back(queued[std::size_t(cell)]++);
+        _from_starts[std::size_t(cell)] = 0;
+        queue.push_back(cell);
+        lower = std::max(lower, _to_goals[std::size_t(cell)] + _delays.back());
+    }
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        int cell = queue[head];
+        Point point = to_point(cell);
+        for (auto move : STRAIGHT_MOVES) {
+            Point next = point + move;
+            int next_cell = cell_id(next);
+            if (next_cell < 0 || _blocked[std::size_t(next_cell)] ||
+                _from_starts[std::size_t(next_cell)] !=
+                    DistanceField::UNREACHABLE ||
+                !_field.is_valid_move(point, next)) {
+                continue;
+            }
+            _from_starts[std::size_t(next_cell)] =
+                _from_starts[std::size_t(cell)] + 1;
+            queue.push_back(next_cell);
+        }
+    }
+    _stats["lower_bound"] = std::int64_t(lower) * step_cost;
+    _stats["failed_routes"] = 0;
+    _stats["optimal"] = 0;
+    if (_movers.empty()) {
+        return routes;
+    }
+
+    // Persons crossing one narrow passage one by one take about one step
+    // each after the longest distance
+    const int max_horizon = 2 * lower + int(_movers.size());
+    Paths too_short_paths(_movers.size());
+    int too_short = lower - 1;
+    std::optional<Paths> found;
+    int found_horizon = 0;
+    bool cut = false;
+    for (int horizon = lower;;) {
+        auto result = solve(horizon, too_short_paths, false);
+        if (result.cut) {
+            cut = true;
+            break;
+        }
+        if (result.complete) {
+            found = std::move(result.paths);
+            found_horizon = horizon;
+            break;
+        }
+        too_short = horizon;
+        too_short_paths = std::move(result.paths);
+        if (horizon >= max_horizon) {
+            break;
+        }
+        horizon = std::min(max_horizon, lower + 2 * (horizon - lower) + 1);
+    }
+    while (found && !cut && found_horizon - too_short > 1) {
+        int middle = too_short + (found_horizon - too_short) / 2;
+        auto result = solve(middle, too_short_paths, false);
+        if (result.cut) {
+            cut = true;
+        } else if (result.complete) {
+            found = std::move(result.paths);
+            found_horizon = middle;
+        } else {
+            too_short = middle;
+            too_short_paths = std::move(result.paths);
+        }
+    }
+
+    Paths paths;
+    if (found) {
+        paths = std::move(*found);
+        _stats["horizon"] = std::int64_t(found_horizon) * step_cost;
+        _stats["optimal"] = found_horizon - too_short == 1;
+    } else if (too_short >= lower) {
+        // The persons that can not reach a goal in time stop anywhere, the
+        // last network is finished whatever the budget
+        _partial = cut;
+        paths = solve(too_short, too_short_paths, true).paths;
+        _stats["horizon"] = std::int64_t(too_short) * step_cost;
+    } else {
+        // Not even the first network was finished, nobody moves
+        _partial = true;
+        paths.resize(_movers.size());
+    }
+
+    for (std::size_t k = 0; k < _movers.size(); ++k) {
+        auto& route = routes[std::size_t(_movers[k])];
+        route = to_route(paths[k]);
+        int cost = 0;
+        for (auto action : route) {
+            cost += get_cost(action);
+            if (action == Action::WAIT) {
+                ++_stats["waits"];
+            }
+        }
+        if (paths[k].empty() ||
+            _to_goals[std::size_t(paths[k].back())] != 0) {
+            ++_stats["failed_routes"];
+        }
+        _stats["sum_of_costs"] += cost;
+        _stats["makespan"] = std::max<std::int64_t>(_stats["makespan"], cost);
+    }
+    return routes;
+}
+
+std::map<std::string, std::int64_t> FlowPlanner::get_stats() const {
+    return _stats;
+}
+
+FlowPlanner::FlowResult FlowPlanner::solve(int horizon, const Paths& seed,
+                                           bool with_stops) {
+    FlowResult result;
+    result.paths.resize(_movers.size());
+    ++_stats["networks"];
+
+    // Copies of a cell are numbered by step from the first step a person
+    // may be there to the last step it still reaches a goal in time
+    std::size_t cell_count = _to_goals.size();
+    std::vector<int> base(cell_count, -1);
+    std::vector<int> first(cell_count, 0);
+    std::vector<int> last(cell_count, -1);
+    std::vector<int> node_cells;
+    std::int64_t count = 0;
+    for (std::size_t cell = 0; cell < cell_count; ++cell) {
+        if (_blocked[cell] || _from_starts[cell] > horizon) {
+            continue;
+        }
+        int to_goal = _to_goals[cell];
+        if (!with_stops && to_goal > horizon) {
+            continue;
+        }
+        int low = _from_starts[cell];
+        int high = with_stops ? horizon : horizon - to_goal;
+        if (low > high) {
+            continue;
+        }
+        base[cell] = int(count);
+        first[cell] = low;
+        last[cell] = high;
+        count += high - low + 1;
+        if (count > MAX_NETWORK_CELLS) {
+            result.cut = true;
+            return result;
+        }
+        node_cells.insert(node_cells.end(), std::size_t(high - low + 1),
+                          int(cell));
+    }
+    auto node = [&](int cell, int step) {
+        auto index = std::size_t(cell);
+        return base[index] >= 0 && step >= first[index] && step <= last[index]
+                   ? base[index] + step - first[index]
+                   : -1;
+    };
+    auto is_goal = [this](int cell) {
+        return _to_goals[std::size_t(cell)] == 0;
+    };
+
+    // Every copy is an entry and an exit joined by an edge of capacity 1
+    const int source = 2 * int(count);
+    const int sink = source + 1;
+    FlowNetwork network(sink + 1);
+    for (std::size_t cell = 0; cell < cell_count; ++cell) {
+        if (base[cell] < 0) {
+            continue;
+        }
+        for (int step = first[cell]; step <= last[cell]; ++step) {
+            int id = node(int(cell), step);
+            network.add_edge(2 * id, 2 * id + 1);
+            if (is_goal(int(cell))) {
+                // The person vanishes
+                network.add_edge(2 * id + 1, sink);
+                continue;
+            }
+            int wait = node(int(cell), step + 1);
+            if (wait >= 0) {
+                network.add_edge(2 * id + 1, 2 * wait);
+            }
+            if (with_stops && step == horizon) {
+                network.add_edge(2 * id + 1, sink);
+            }
+        }
+        Point point = to_point(int(cell));
+        for (auto move : {Action::RIGHT, Action::UP}) {
+            Point next = point + move;
+            int other = cell_id(next);
+            if (other < 0 || base[std::size_t(other)] < 0 ||
+                !_field.is_valid_move(point, next)) {
+                continue;
+            }
+            int from_step = std::min(first[cell], first[std::size_t(other)]);
+            int to_step = std::min(horizon - 1,
+                                   std::max(last[cell], last[std::size_t(other)]));
+            for (int step = from_step; step <= to_step; ++step) {
+                int forward_from = node(int(cell), step);
+                int forward_to = node(other, step + 1);
+                int backward_from = node(other, step);
+                int backward_to = node(int(cell), step + 1);
+                bool forward = forward_from >= 0 && forward_to >= 0 &&
+                               !is_goal(int(cell));
+                bool backward = backward_from >= 0 && backward_to >= 0 &&
+                                !is_goal(other);
+                if (forward && backward) {
+                    // Only one of the two persons crosses the edge
+                    int gadget = network.add_vertices(2);
+                    network.add_edge(gadget, gadget + 1);
+                    network.add_edge(2 * forward_from + 1, gadget);
+                    network.add_edge(gadget + 1, 2 * forward_to);
+                    network.add_edge(2 * backward_from + 1, gadget);
+                    network.add_edge(gadget + 1, 2 * backward_to);
+                } else if (forward) {
+                    network.add_edge(2 * forward_from + 1, 2 * forward_to);
+                } else if (backward) {
+                    network.add_edge(2 * backward_from + 1, 2 * backward_to);
+                }
+            }
+        }
+    }
+    // A mover enters its start cell when the ones queued before have left,
+    // or not at all if it can not reach a goal in time from there
+    std::vector<int> starts;
+    for (std::size_t k = 0; k < _movers.size(); ++k) {
+        starts.push_back(node(
+            cell_id(_persons[std::size_t(_movers[k])].get_position()),
+            _delays[k]));
+        if (starts.back() >= 0) {
+            network.add_edge(source, 2 * starts.back());
+        }
+    }
+    network.finish();
+    _stats["largest_network"] = std::max<std::int64_t>(
+        _stats["largest_network"], network.get_vertex_count());
+
+    // The routes of a shorter horizon are a flow of this network too
+    auto send_move = [&network, sink](int from, int to) {
+        if (network.send(from, to)) {
+            return;
+        }
+        int gadget = -1;
+        network.for_each_next(from, [&network, &gadget, sink, to](int next) {
+            if (next <= sink) {
+                return;
+            }
+            bool leads_to = false;
+            network.for_each_next(next + 1, [&leads_to, to](int target) {
+                leads_to = leads_to || target == to;
+            });
+            if (leads_to) {
+                gadget = next;
+            }
+        });
+        network.send(from, gadget);
+        network.send(gadget, gadget + 1);
+        network.send(gadget + 1, to);
+    };
+    for (std::size_t k = 0; k < seed.size(); ++k) {
+        const auto& path = seed[k];
+        if (path.empty()) {
+            continue;
+        }
+        network.send(source, 2 * starts[k]);
+        for (auto step = std::size_t(_delays[k]); step < path.size(); ++step) {
+            int id = node(path[step], int(step));
+            network.send(2 * id, 2 * id + 1);
+            if (step + 1 < path.size()) {
+                send_move(2 * id + 1, 2 * node(path[step + 1], int(step) + 1));
+            } else {
+                network.send(2 * id + 1, sink);
+            }
+        }
+    }
+
+    std::int64_t expansions = 0;
+    // The last network must be finished even after the deadline
+    SearchBudget unlimited;
+    _stats["augmentations"] += network.augment(
+        source, sink, with_stops ? unlimited : *_budget, expansions,
+        result.cut);
+    _stats["expansions"] += expansions;
+    if (result.cut) {
+        return result;
+    }
+
+    // Copies hold one person each, so the units never meet and every one
+    // of them is the route of the person it started from. A queued person
+    // waits in its start cell until it enters.
+    result.complete = true;
+    for (std::size_t k = 0; k < _movers.size(); ++k) {
+        auto& path = result.paths[k];
+        int vertex = 2 * starts[k];
+        if (starts[k] < 0 || !network.is_used(source, vertex)) {
+            result.complete = false;
+            continue;
+        }
+        path.assign(std::size_t(_delays[k]),
+                    node_cells[std::size_t(starts[k])]);
+        while (vertex != sink) {
+            path.push_back(node_cells[std::size_t(vertex / 2)]);
+            int next = network.get_next(vertex + 1);
+            if (next > sink) {
+                next = network.get_next(network.get_next(next));
+            }
+            vertex = next;
+        }
+        result.complete = result.complete && is_goal(path.back());
+    }
+    return result;
+}
+
+std::vector<Action> FlowPlanner::to_route(const std::vector<int>& path) const {
+    std::vector<Action> route;
+    for (std::size_t step = 1; step < path.size(); ++step) {
+        route.push_back(
+            to_point(path[step - 1]).to_another(to_point(path[step])));
+    }
+    // A stopped person stands at the end of its route anyway
+    while (!route.empty() && route.back() == Action::WAIT) {
+        route.pop_back();
+    }
+    return route;
+}
+
+int FlowPlanner::cell_id(const Point& cell) const noexcept {
+    int local_x = cell.get_x() - _lower_left.get_x();
+    int local_y = cell.get_y() - _lower_left.get_y();
+    if (local_x < 0 || local_y < 0 || local_x >= _width ||
+        local_y >= _height) {
+        return -1;
+    }
+    return local_y * _width + local_x;
+}
+
+Point FlowPlanner::to_point(int cell) const noexcept {
+    return Point(_lower_left.get_x() + cell % _width,
+                 _lower_left.get_y() + cell / _width);
+}
@@ -28,3 +28,7 @@ bool Grid::is_incorrect_move(const Segment &route) const noexcept {
 Point Grid::get_lower_left() const noexcept { return _lower_left_point; }
 
 Point Grid::get_upper_right() const noexcept { return _upper_right_point; }
+
+const std::vector<Border> &Grid::get_borders() const noexcept {
+    return _borders;
+}
@@ -0,0 +1,412 @@
+#include "group_planner.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <queue>
+#include <tuple>
+
+#include "catable.h"
+#include "search_footprint.h"
+#include "space_time_search.h"
+
+namespace {
+constexpr std::array ACTIONS = {
+    Action::UP,      Action::DOWN,     Action::LEFT,      Action::RIGHT,
+    Action::LEFT_UP, Action::RIGHT_UP, Action::LEFT_DOWN, Action::RIGHT_DOWN,
+    Action::WAIT,
+};
+
+// The deadline is polled once per this many expansions
+constexpr int STOP_CHECK_PERIOD = 256;
+// Delays in waits a follower tries before it is searched for
+constexpr int MAX_STAGGER_WAITS = 8;
+
+Point shift(const Point& cell, const std::pair<int, int>& offset) {
+    return Point(cell.get_x() + offset.first, cell.get_y() + offset.second);
+}
+}  // namespace
+
+GroupPlanner::GroupPlanner(const std::vector<Person>& persons,
+                           const std::vector<Goal>& goals, Grid* grid,
+                           GroupOptions options)
+    : Planner(persons, goals, grid),
+      _options(std::move(options)),
+      _field(*grid, get_goal_positions()),
+      _table(grid->get_lower_left(), grid->get_upper_right()) {}
+
+std::vector<std::vector<Action>> GroupPlanner::plan_all_routes() {
+    _stats.clear();
+    _stats["group_searches"] = 0;
+    _stats["member_searches"] = 0;
+    _stats["staggered_routes"] = 0;
+    _stats["split_groups"] = 0;
+    _stats["failed_routes"] = 0;
+    _stats["sum_of_costs"] = 0;
+    _stats["makespan"] = 0;
+    _stops.clear();
+    _partial = false;
+    auto formations = make_formations();
+    std::vector<std::vector<Action>> routes;
+    for (bool has_new_stops = true; has_new_stops;) {
+        _table.clear();
+        routes.assign(_persons.size(), {});
+        for (std::size_t i = 0; i < formations.size(); ++i) {
+            if (_budget->is_exhausted()) {
+                _partial = true;
+                break;
+            }
+            plan_formation(formations[i], routes,
+                           std::int64_t(formations.size() - i));
+            commit_followers(formations[i], routes,
+                             std::int64_t(formations.size() - i));
+        }
+        has_new_stops = false;
+        for (std::size_t i = 0; i < _persons.size(); ++i) {
+            auto position = _persons[i].get_position();
+            if (routes[i].empty() && !is_reached_goal(position) &&
+                _stops.insert(position)) {
+                has_new_stops = true;
+            }
+        }
+        has_new_stops = has_new_stops && !_budget->is_exhausted();
+    }
+
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        std::int64_t cost = 0;
+        for (auto action : routes[i]) {
+            cost += get_cost(action);
+        }
+        _stats["sum_of_costs"] += cost;
+        _stats["makespan"] = std::max(_stats["makespan"], cost);
+        if (routes[i].empty() && !is_reached_goal(_persons[i].get_position())) {
+            ++_stats["failed_routes"];
+        }
+    }
+    return routes;
+}
+
+std::map<std::string, std::int64_t> GroupPlanner::get_stats() const {
+    return _stats;
+}
+
+std::vector<GroupPlanner::Formation> GroupPlanner::make_formations() const {
+    std::vector<std::vector<int>> groups;
+    std::vector<std::uint8_t> is_grouped(_persons.size(), 0);
+    for (const auto& group : _options.groups) {
+        std::vector<int> members;
+        for (int index : group) {
+            if (index >= 0 && std::size_t(index) < _persons.size() &&
+                !is_grouped[std::size_t(index)]) {
+                is_grouped[std::size_t(index)] = 1;
+                members.push_back(index);
+            }
+        }
+        if (!members.empty()) {
+            groups.push_back(std::move(members));
+        }
+    }
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        if (!is_grouped[i]) {
+            groups.push_back({int(i)});
+        }
+    }
+
+    auto distance = [this](int index) {
+        return _field.get_distance(_persons[std::size_t(index)].get_position());
+    };
+    std::vector<Formation> formations;
+    formations.reserve(groups.size());
+    for (auto& members : groups) {
+        std::stable_sort(members.begin(), members.end(),
+                         [&distance](int lhs, int rhs) {
+                             return distance(lhs) < distance(rhs);
+                         });
+        Formation formation;
+        auto leader = _persons[std::size_t(members[0])].get_position();
+        FlatHashMap<Point, std::size_t> member_in_cell;
+        for (int index : members) {
+            auto position = _persons[std::size_t(index)].get_position();
+            if (const auto* first = member_in_cell.find(position)) {
+                formation.followers[*first].push_back(index);
+                continue;
+            }
+            member_in_cell.insert(position, formation.members.size());
+            formation.members.push_back(index);
+            formation.offsets.emplace_back(
+                position.get_x() - leader.get_x(),
+                position.get_y() - leader.get_y());
+            formation.followers.emplace_back();
+        }
+        formations.push_back(std::move(formation));
+    }
+    std::stable_sort(formations.begin(), formations.end(),
+                     [&distance](const Formation& lhs, const Formation& rhs) {
+                         return distance(lhs.members[0]) <
+                                distance(rhs.members[0]);
+                     });
+    return formations;
+}
+
+void GroupPlanner::plan_formation(const Formation& formation,
+                                  std::vector<std::vector<Action>>& routes,
+                                  std::int64_t searches_left) {
+    bool has_stops = std::any_of(
+        formation.members.begin(), formation.members.end(), [this](int index) {
+            return _stops.contains(_persons[std::size_t(index)].get_position());
+        });
+    if (formation.members.size() == 1 || has_stops) {
+        plan_alone(formation, routes, searches_left);
+        return;
+    }
+
+    int expansions = 0;
+    ++_stats["group_searches"];
+    auto moves = search_formation(
+        formation, int(_budget->get_share(searches_left)), expansions);
+    std::size_t mark = _table.get_trajectory_count();
+    bool has_failed = !moves.has_value();
+    if (moves) {
+        int arrival = 0;
+        for (auto action : *moves) {
+            arrival += get_cost(action);
+        }
+        auto leader = _persons[std::size_t(formation.members[0])].get_position();
+        for (auto action : *moves) {
+            leader = leader + action;
+        }
+        // The members break up nearest first, the ones still waiting are in
+        // the way of the others
+        std::vector<std::size_t> order(formation.members.size());
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            order[k] = k;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&](std::size_t lhs, std::size_t rhs) {
+                             return _field.get_distance(shift(
+                                        leader, formation.offsets[lhs])) <
+                                    _field.get_distance(shift(
+                                        leader, formation.offsets[rhs]));
+                         });
+        for (std::size_t k = 0; k < order.size() && !has_failed; ++k) {
+            auto member = std::size_t(formation.members[order[k]]);
+            Point cell = shift(leader, formation.offsets[order[k]]);
+            auto route = *moves;
+            if (_field.get_distance(cell) != 0) {
+                FlatHashSet<Point> stops = _stops;
+                for (std::size_t rest = k + 1; rest < order.size(); ++rest) {
+                    stops.insert(shift(leader, formation.offsets[order[rest]]));
+                }
+                ++_stats["member_searches"];
+                auto tail = search_alone(
+                    cell, arrival, stops,
+                    int(_budget->get_share(std::int64_t(order.size() - k))),
+                    expansions);
+                has_failed = !tail.has_value();
+                if (tail) {
+                    route.insert(route.end(), tail->begin(), tail->end());
+                }
+            }
+            if (!has_failed) {
+                reserve(_persons[member].get_position(), route);
+                routes[member] = std::move(route);
+            }
+        }
+    }
+    _budget->spend(expansions);
+    if (has_failed) {
+        _table.rollback(mark);
+        for (int index : formation.members) {
+            routes[std::size_t(index)].clear();
+        }
+        ++_stats["split_groups"];
+        plan_alone(formation, routes, searches_left);
+    }
+}
+
+void GroupPlanner::plan_alone(const Formation& formation,
+                              std::vector<std::vector<Action>>& routes,
+                              std::int64_t searches_left) {
+    int expansions = 0;
+    for (int index : formation.members) {
+        auto start = _persons[std::size_t(index)].get_position();
+        if (_stops.contains(start) || is_reached_goal(start)) {
+            continue;
+        }
+        ++_stats["member_searches"];
+        auto route = search_alone(start, 0, _stops,
+                                  int(_budget->get_share(searches_left)),
+                                  expansions);
+        if (route) {
+            reserve(start, *route);
+            routes[std::size_t(index)] = std::move(*route);
+        }
+    }
+    _budget->spend(expansions);
+}
+
+void GroupPlanner::commit_followers(const Formation& formation,
+                                    std::vector<std::vector<Action>>& routes,
+                                    std::int64_t searches_left) {
+    SpaceTimeSearch search(_field, _table, _stops, *_budget);
+    int expansions = 0;
+    for (std::size_t k = 0; k < formation.members.size(); ++k) {
+        int previous = formation.members[k];
+        for (int follower : formation.followers[k]) {
+            auto start = _persons[std::size_t(follower)].get_position();
+            const auto& before = routes[std::size_t(previous)];
+            previous = follower;
+            // The queue only moves up behind a person that leaves
+            if (before.empty()) {
+                continue;
+            }
+            auto waits = std::size_t(
+                std::find_if(before.begin(), before.end(),
+                             [](Action action) {
+                                 return action != Action::WAIT;
+                             }) -
+                before.begin());
+            std::vector<Point> cells = {start};
+            for (auto it = before.begin() + std::ptrdiff_t(waits);
+                 it != before.end(); ++it) {
+                cells.push_back(cells.back() + *it);
+            }
+            std::vector<Action> route;
+            SearchFootprint footprint;
+            for (int delay = 1; delay <= MAX_STAGGER_WAITS && route.empty();
+                 ++delay) {
+                auto total_waits = waits + std::size_t(delay);
+                if (search.find_conflict(
+                        cells, int(total_waits) * get_cost(Action::WAIT),
+                        footprint) < 0) {
+                    route.assign(total_waits, Action::WAIT);
+                    route.insert(route.end(),
+                                 before.begin() + std::ptrdiff_t(waits),
+                                 before.end());
+                    ++_stats["staggered_routes"];
+                }
+            }
+            if (route.empty()) {
+                ++_stats["member_searches"];
+                route = search_alone(start, 0, _stops,
+                                     int(_budget->get_share(searches_left)),
+                                     expansions)
+                            .value_or(std::vector<Action>{});
+            }
+            if (!route.empty()) {
+                reserve(start, route);
+                routes[std::size_t(follower)] = std::move(route);
+            }
+        }
+    }
+    _budget->spend(expansions);
+}
+
+std::optional<std::vector<Action>> GroupPlanner::search_formation(
+    const Formation& formation, int max_steps, int& expansions) {
+    struct Node {
+        Point leader;
+        int time;
+        int parent;
+        Action action;
+    };
+    using QueueItem = std::tuple<int, int, int>;
+
+    Point start = _persons[std::size_t(formation.members[0])].get_position();
+    int start_distance = _field.get_distance(start);
+    if (start_distance == DistanceField::UNREACHABLE) {
+        return std::nullopt;
+    }
+    // Nothing is reserved after the horizon, so later nodes of one cell
+    // only differ in cost and the first one popped is the cheapest
+    int horizon = _table.get_horizon();
+    std::vector<Node> nodes = {{start, 0, -1, Action::WAIT}};
+    std::priority_queue<QueueItem, std::vector<QueueItem>,
+                        std::greater<QueueItem>>
+        open;
+    open.emplace(start_distance, start_distance, 0);
+    FlatHashSet<TimePoint> closed;
+    int steps = 0;
+    while (!open.empty() && steps < max_steps) {
+        if (steps % STOP_CHECK_PERIOD == 0 && _budget->is_expired()) {
+            _partial = true;
+            break;
+        }
+        auto [f, distance, index] = open.top();
+        open.pop();
+        Node node = nodes[std::size_t(index)];
+        if (!closed.insert({node.leader.get_x(), node.leader.get_y(),
+                            std::min(node.time, horizon + 1)})) {
+            continue;
+        }
+        ++steps;
+        if (distance == 0) {
+            std::vector<Action> moves;
+            for (int current = index; nodes[std::size_t(current)].parent >= 0;
+                 current = nodes[std::size_t(current)].parent) {
+                moves.push_back(nodes[std::size_t(current)].action);
+            }
+            std::reverse(moves.begin(), moves.end());
+            expansions += steps;
+            return moves;
+        }
+        for (auto action : ACTIONS) {
+            if ((action == Action::WAIT && node.time > horizon) ||
+                !can_move(formation, node.leader, action, node.time)) {
+                continue;
+            }
+            Point next = node.leader + action;
+            int next_distance = _field.get_distance(next);
+            if (next_distance == DistanceField::UNREACHABLE) {
+                continue;
+            }
+            int time = node.time + get_cost(action);
+            nodes.push_back({next, time, index, action});
+            open.emplace(time + next_distance, next_distance,
+                         int(nodes.size() - 1));
+        }
+    }
+    if (steps >= max_steps && max_steps < _budget->get_search_limit()) {
+        _partial = true;
+    }
+    expansions += steps;
+    return std::nullopt;
+}
+
+bool GroupPlanner::can_move(const Formation& formation, const Point& leader,
+                            Action action, int time) const {
+    return std::all_of(
+        formation.offsets.begin(), formation.offsets.end(),
+        [&](const std::pair<int, int>& offset) {
+            Point from = shift(leader, offset);
+            Point to = from + action;
+            return _field.is_valid_move(from, to) && !_stops.contains(to) &&
+                   _table.check_move(from, to, time);
+        });
+}
+
+std::optional<std::vector<Action>> GroupPlanner::search_alone(
+    const Point& start, int start_time, const FlatHashSet<Point>& stops,
+    int max_steps, int& expansions) {
+    SpaceTimeSearch search(_field, _table, stops, *_budget);
+    SearchFootprint footprint;
+    int steps = 0;
+    bool cut = false;
+    auto route = search.search_route(start, start_time, max_steps, nullptr,
+                                     footprint, steps, cut);
+    if (cut || (!route && steps >= max_steps &&
+                max_steps < _budget->get_search_limit())) {
+        _partial = true;
+    }
+    expansions += steps;
+    return route;
+}
+
+void GroupPlanner::reserve(const Point& start,
+                           const std::vector<Action>& route) {
+    std::vector<Point> trajectory = {start};
+    for (auto action : route) {
+        trajectory.push_back(trajectory.back() + action);
+    }
+    _table.add_trajectory(int(_table.get_trajectory_count()), trajectory);
+}
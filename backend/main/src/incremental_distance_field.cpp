@@ -0,0 +1,310 @@
+#include "incremental_distance_field.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "actions.h"
+#include "border.h"
+#include "segment.h"
+
+namespace {
+// Same order as in Point::get_neighbors and DistanceField
+constexpr std::array<std::pair<int, int>, 8> DIRECTIONS = {{
+    {0, 1},
+    {1, 1},
+    {-1, 1},
+    {0, -1},
+    {1, -1},
+    {-1, -1},
+    {1, 0},
+    {-1, 0},
+}};
+
+// Each undirected move is checked once, from the cell with the smaller id
+constexpr std::array<int, 4> FORWARD_DIRECTIONS = {0, 1, 2, 6};
+
+constexpr std::array<int, 8> OPPOSITE = {3, 5, 4, 0, 2, 1, 7, 6};
+
+// The budget is checked after that many queue entries
+constexpr std::int64_t REPAIR_BATCH = 256;
+
+int get_direction_cost(std::size_t direction) noexcept {
+    auto [dx, dy] = DIRECTIONS[direction];
+    return dx != 0 && dy != 0 ? get_cost(Action::RIGHT_UP)
+                              : get_cost(Action::RIGHT);
+}
+
+bool is_less(const Point& lhs, const Point& rhs) noexcept {
+    return lhs.get_x() != rhs.get_x() ? lhs.get_x() < rhs.get_x()
+                                      : lhs.get_y() < rhs.get_y();
+}
+}  // namespace
+
+void IncrementalDistanceField::update(const Grid& grid,
+                                      const std::vector<Point>& goals) {
+    std::vector<Point> sorted_goals = goals;
+    std::sort(sorted_goals.begin(), sorted_goals.end(), is_less);
+    sorted_goals.erase(std::unique(sorted_goals.begin(), sorted_goals.end()),
+                       sorted_goals.end());
+    // A border is the same whichever end comes first
+    Segments borders;
+    borders.reserve(grid.get_borders().size());
+    for (const auto& border : grid.get_borders()) {
+        Point first = border.get_first();
+        Point second = border.get_second();
+        if (is_less(second, first)) {
+            std::swap(first, second);
+        }
+        borders.push_back(
+            {first.get_x(), first.get_y(), second.get_x(), second.get_y()});
+    }
+    std::sort(borders.begin(), borders.end());
+
+    _changes = Changes{};
+    if (_g.empty() || grid.get_lower_left() != _lower_left ||
+        grid.get_upper_right() != _upper_right || sorted_goals != _goals) {
+        _goals = std::move(sorted_goals);
+        _borders = std::move(borders);
+        rebuild(grid, _goals);
+        return;
+    }
+    Segments changed;
+    std::set_symmetric_difference(_borders.begin(), _borders.end(),
+                                  borders.begin(), borders.end(),
+                                  std::back_inserter(changed));
+    _borders = std::move(borders);
+    _changes.borders = std::int64_t(changed.size());
+    for (const auto& border : changed) {
+        update_moves(border, _borders);
+    }
+}
+
+bool IncrementalDistanceField::repair(const std::vector<Point>& targets,
+                                      SearchBudget& budget) {
+    std::vector<int> ids;
+    for (const auto& target : targets) {
+        int id = cell_id(target);
+        if (id >= 0) {
+            ids.push_back(id);
+        }
+    }
+    // Largest key a target still waits for, recomputed when the queue gets
+    // there
+    int bound = 0;
+    std::int64_t popped = 0;
+    std::int64_t repaired = 0;
+    while (!_open.empty()) {
+        auto [key, id] = _open.top();
+        if (key >= bound) {
+            bound = 0;
+            for (int target : ids) {
+                auto index = std::size_t(target);
+                bound = std::max(bound, _g[index] == _rhs[index]
+                                            ? _g[index]
+                                            : UNREACHABLE);
+            }
+            // Unreachable targets are exact only when nothing is queued
+            if (bound != UNREACHABLE && key >= bound) {
+                break;
+            }
+        }
+        if (++popped % REPAIR_BATCH == 0) {
+            budget.spend(REPAIR_BATCH);
+            if (budget.is_exhausted()) {
+                _changes.repaired_cells += repaired;
+                return false;
+            }
+        }
+        _open.pop();
+        auto index = std::size_t(id);
+        if (key != get_key(id) || _g[index] == _rhs[index]) {
+            continue;
+        }
+        ++repaired;
+        std::uint8_t moves = _moves[index];
+        if (_g[index] > _rhs[index]) {
+            _g[index] = _rhs[index];
+        } else {
+            _g[index] = UNREACHABLE;
+            update_cell(id);
+        }
+        for (std::size_t direction = 0; direction < DIRECTIONS.size();
+             ++direction) {
+            if ((moves & (1 << direction)) != 0) {
+                update_cell(id + _offsets[direction]);
+            }
+        }
+    }
+    budget.spend(popped % REPAIR_BATCH);
+    _changes.repaired_cells += repaired;
+    return true;
+}
+
+int IncrementalDistanceField::get_distance(const Point& cell) const noexcept {
+    int id = cell_id(cell);
+    return id < 0 ? UNREACHABLE : _g[std::size_t(id)];
+}
+
+std::optional<Point> IncrementalDistanceField::get_next(
+    const Point& cell) const {
+    int id = cell_id(cell);
+    if (id < 0 || _g[std::size_t(id)] == 0 ||
+        _g[std::size_t(id)] == UNREACHABLE) {
+        return std::nullopt;
+    }
+    std::uint8_t moves = _moves[std::size_t(id)];
+    for (std::size_t direction = 0; direction < DIRECTIONS.size();
+         ++direction) {
+        auto neighbor = std::size_t(id + _offsets[direction]);
+        if ((moves & (1 << direction)) != 0 && _g[neighbor] != UNREACHABLE &&
+            _g[neighbor] + get_direction_cost(direction) ==
+                _g[std::size_t(id)]) {
+            auto [dx, dy] = DIRECTIONS[direction];
+            return Point(cell.get_x() + dx, cell.get_y() + dy);
+        }
+    }
+    return std::nullopt;
+}
+
+bool IncrementalDistanceField::is_exact(const Point& cell) const noexcept {
+    int id = cell_id(cell);
+    if (id < 0) {
+        return true;
+    }
+    auto index = std::size_t(id);
+    // Inconsistent cells are queued with their keys, so every cell closer
+    // than the first key in the queue has its final distance
+    return _g[index] == _rhs[index] &&
+           (_open.empty() ||
+            (_g[index] != UNREACHABLE && _open.top().first >= _g[index]));
+}
+
+int IncrementalDistanceField::cell_id(const Point& cell) const noexcept {
+    int local_x = cell.get_x() - _lower_left.get_x();
+    int local_y = cell.get_y() - _lower_left.get_y();
+    if (local_x < 0 || local_y < 0 || local_x >= _width ||
+        local_y >= _height) {
+        return -1;
+    }
+    return local_y * _width + local_x;
+}
+
+void IncrementalDistanceField::rebuild(const Grid& grid,
+                                       const std::vector<Point>& goals) {
+    DistanceField field(grid, goals);
+    _lower_left = grid.get_lower_left();
+    _upper_right = grid.get_upper_right();
+    _width = std::max(0, _upper_right.get_x() - _lower_left.get_x() + 1);
+    _height = std::max(0, _upper_right.get_y() - _lower_left.get_y() + 1);
+    for (std::size_t direction = 0; direction < DIRECTIONS.size();
+         ++direction) {
+        auto [dx, dy] = DIRECTIONS[direction];
+        _offsets[direction] = dy * _width + dx;
+    }
+    std::size_t cell_count = std::size_t(_width) * std::size_t(_height);
+    _g.assign(cell_count, UNREACHABLE);
+    _moves.assign(cell_count, 0);
+    _is_goal.assign(cell_count, 0);
+    for (std::size_t id = 0; id < cell_count; ++id) {
+        Point cell(_lower_left.get_x() + int(id) % _width,
+                   _lower_left.get_y() + int(id) / _width);
+        _g[id] = field.get_distance(cell);
+        for (std::size_t direction = 0; direction < DIRECTIONS.size();
+             ++direction) {
+            auto [dx, dy] = DIRECTIONS[direction];
+            if (field.is_valid_move(
+                    cell, Point(cell.get_x() + dx, cell.get_y() + dy))) {
+                _moves[id] |= std::uint8_t(1 << direction);
+            }
+        }
+    }
+    for (const auto& goal : goals) {
+        int id = cell_id(goal);
+        if (id >= 0) {
+            _is_goal[std::size_t(id)] = 1;
+        }
+    }
+    _rhs = _g;
+    _open = {};
+    _changes.rebuilt = true;
+}
+
+void IncrementalDistanceField::update_moves(const std::array<int, 4>& changed,
+                                            const Segments& borders) {
+    // Border coordinates are cell corners, see DistanceField. A forward move
+    // of cell (x, y) stays inside [x - 1, x + 1] x [y, y + 1], so the moves
+    // a border may cross start in its bounding box grown by one cell.
+    int min_x = std::min(changed[0], changed[2]) - 1;
+    int max_x = std::max(changed[0], changed[2]) + 1;
+    int min_y = std::min(changed[1], changed[3]) - 1;
+    int max_y = std::max(changed[1], changed[3]);
+    std::vector<Border> nearby;
+    for (const auto& border : borders) {
+        if (std::max(border[0], border[2]) >= min_x - 1 &&
+            std::min(border[0], border[2]) <= max_x + 1 &&
+            std::max(border[1], border[3]) >= min_y &&
+            std::min(border[1], border[3]) <= max_y + 1) {
+            nearby.emplace_back(Point(border[0], border[1]),
+                                Point(border[2], border[3]));
+        }
+    }
+    for (int y = min_y; y <= max_y; ++y) {
+        for (int x = min_x; x <= max_x; ++x) {
+            Point cell(x, y);
+            int id = cell_id(cell);
+            if (id < 0) {
+                continue;
+            }
+            for (int direction : FORWARD_DIRECTIONS) {
+                auto [dx, dy] = DIRECTIONS[std::size_t(direction)];
+                Point neighbor(x + dx, y + dy);
+                int neighbor_id = cell_id(neighbor);
+                if (neighbor_id < 0) {
+                    continue;
+                }
+                bool is_valid = std::none_of(
+                    nearby.begin(), nearby.end(),
+                    [&cell, &neighbor](const Border& border) {
+                        return border.is_intersecting(Segment(cell, neighbor));
+                    });
+                auto bit = std::uint8_t(1 << direction);
+                if (((_moves[std::size_t(id)] & bit) != 0) == is_valid) {
+                    continue;
+                }
+                auto opposite =
+                    std::uint8_t(1 << OPPOSITE[std::size_t(direction)]);
+                _moves[std::size_t(id)] ^= bit;
+                _moves[std::size_t(neighbor_id)] ^= opposite;
+                ++_changes.moves;
+                update_cell(id);
+                update_cell(neighbor_id);
+            }
+        }
+    }
+}
+
+void IncrementalDistanceField::update_cell(int id) {
+    auto index = std::size_t(id);
+    if (!_is_goal[index]) {
+        int best = UNREACHABLE;
+        std::uint8_t moves = _moves[index];
+        for (std::size_t direction = 0; direction < DIRECTIONS.size();
+             ++direction) {
+            int distance = (moves & (1 << direction)) != 0
+                               ? _g[std::size_t(id + _offsets[direction])]
+                               : UNREACHABLE;
+            if (distance != UNREACHABLE) {
+                best = std::min(best,
+                                distance + get_direction_cost(direction));
+            }
+        }
+        _rhs[index] = best;
+    }
+    if (_g[index] != _rhs[index]) {
+        _open.emplace(get_key(id), id);
+    }
+}
+
+int IncrementalDistanceField::get_key(int id) const noexcept {
+    return std::min(_g[std::size_t(id)], _rhs[std::size_t(id)]);
+}
@@ -0,0 +1,48 @@
+#include "incremental_planner.h"
+
+#include <mutex>
+#include <utility>
+
+IncrementalPlanner::IncrementalPlanner(
+    const std::vector<Person>& persons, const std::vector<Goal>& goals,
+    Grid* grid, std::shared_ptr<IncrementalDistanceField> field)
+    : Planner(persons, goals, grid), _field(std::move(field)) {}
+
+std::vector<std::vector<Action>> IncrementalPlanner::plan_all_routes() {
+    std::lock_guard lock(_field->get_mutex());
+    _stats.clear();
+    _field->update(*_grid, get_goal_positions());
+    std::vector<Point> starts;
+    starts.reserve(_persons.size());
+    for (const auto& person : _persons) {
+        starts.push_back(person.get_position());
+    }
+    // A cut repair is still exact near the goals, persons farther away get
+    // no routes
+    _partial = !_field->repair(starts, *_budget);
+
+    std::vector<std::vector<Action>> routes(_persons.size());
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        Point cell = starts[i];
+        if (!_field->is_exact(cell)) {
+            ++_stats["failed_routes"];
+            continue;
+        }
+        for (auto next = _field->get_next(cell); next;
+             next = _field->get_next(cell)) {
+            routes[i].push_back(cell.to_another(*next));
+            cell = *next;
+        }
+    }
+    const auto& changes = _field->get_changes();
+    _stats["rebuilt"] = changes.rebuilt ? 1 : 0;
+    _stats["changed_borders"] = changes.borders;
+    _stats["changed_moves"] = changes.moves;
+    _stats["repaired_cells"] = changes.repaired_cells;
+    _stats["failed_routes"] += 0;
+    return routes;
+}
+
+std::map<std::string, std::int64_t> IncrementalPlanner::get_stats() const {
+    return _stats;
+}
@@ -0,0 +1,243 @@
+#include "independence_planner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#include "actions.h"
+
+namespace {
+class DisjointSets {
+ public:
+    explicit DisjointSets(std::size_t count) : _parents(count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            _parents[i] = int(i);
+        }
+    }
+
+    int find(int item) {
+        while (_parents[std::size_t(item)] != item) {
+            auto& parent = _parents[std::size_t(item)];
+            parent = _parents[std::size_t(parent)];
+            item = parent;
+        }
+        return item;
+    }
+
+    // The smaller index becomes the root, so groups do not depend on the
+    // order of unions
+    void unite(int first, int second) {
+        first = find(first);
+        second = find(second);
+        if (first > second) {
+            std::swap(first, second);
+        }
+        _parents[std::size_t(second)] = first;
+    }
+
+ private:
+    std::vector<int> _parents;
+};
+
+// Stay of one person in one cell during the ticks [start, end]
+struct Visit {
+    Point cell;
+    int start;
+    int end;
+    int person;
+};
+
+constexpr int FOREVER = std::numeric_limits<int>::max();
+}  // namespace
+
+IndependencePlanner::IndependencePlanner(const std::vector<Person>& persons,
+                                         const std::vector<Goal>& goals,
+                                         Grid* grid,
+                                         IndependenceOptions options)
+    : Planner(persons, goals, grid), _options(options), _goal_list(goals) {
+    if (_options.threads == 0) {
+        _options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+std::vector<std::vector<Action>> IndependencePlanner::plan_all_routes() {
+    _stats.clear();
+    _partial = false;
+    std::size_t count = _persons.size();
+    auto field =
+        std::make_shared<const DistanceField>(*_grid, get_goal_positions());
+    std::vector<std::vector<Action>> routes(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        Point cell = _persons[i].get_position();
+        for (auto next = field->get_next(cell); next.has_value();
+             next = field->get_next(cell)) {
+            routes[i].push_back(cell.to_another(*next));
+            cell = *next;
+        }
+    }
+
+    DisjointSets groups(count);
+    std::vector<int> group_of(count);
+    std::int64_t rounds = 0;
+    while (true) {
+        for (std::size_t i = 0; i < count; ++i) {
+            group_of[i] = groups.find(int(i));
+        }
+        auto interactions = find_interactions(routes, group_of);
+        if (interactions.empty()) {
+            break;
+        }
+        for (const auto& [first, second] : interactions) {
+            groups.unite(first, second);
+        }
+        // Every group that took part in a merge is planned again, the rest
+        // keep their routes
+        std::vector<char> changed(count, 0);
+        for (const auto& interaction : interactions) {
+            changed[std::size_t(groups.find(interaction.first))] = 1;
+        }
+        std::vector<std::vector<int>> changed_groups;
+        std::vector<int> slot_of(count, -1);
+        for (std::size_t i = 0; i < count; ++i) {
+            int root = groups.find(int(i));
+            if (!changed[std::size_t(root)]) {
+                continue;
+            }
+            if (slot_of[std::size_t(root)] < 0) {
+                slot_of[std::size_t(root)] = int(changed_groups.size());
+                changed_groups.emplace_back();
+            }
+            changed_groups[std::size_t(slot_of[std::size_t(root)])].push_back(
+                int(i));
+        }
+
+        std::vector<GroupResult> results(changed_groups.size());
+        std::atomic<std::size_t> next(0);
+        {
+            std::vector<std::jthread> workers;
+            std::size_t workers_count =
+                std::min(changed_groups.size(), std::size_t(_options.threads));
+            for (std::size_t i = 0; i < workers_count; ++i) {
+                workers.emplace_back([&, this] {
+                    for (std::size_t k = next++; k < changed_groups.size();
+                         k = next++) {
+                        results[k] = plan_group(changed_groups[k], field);
+                    }
+                });
+            }
+        }
+
+        for (std::size_t k = 0; k < changed_groups.size(); ++k) {
+            const auto& members = changed_groups[k];
+            for (std::size_t j = 0; j < members.size(); ++j) {
+                routes[std::size_t(members[j])] =
+                    std::move(results[k].routes[j]);
+            }
+            _stats["expansions"] += results[k].stats["expansions"];
+            _partial = _partial || results[k].partial;
+        }
+        ++rounds;
+    }
+
+    std::map<int, std::int64_t> sizes;
+    for (std::size_t i = 0; i < count; ++i) {
+        ++sizes[groups.find(int(i))];
+        int cost = 0;
+        for (auto action : routes[i]) {
+            cost += get_cost(action);
+        }
+        _stats["makespan"] = std::max<std::int64_t>(_stats["makespan"], cost);
+        if (routes[i].empty() && !is_reached_goal(_persons[i].get_position())) {
+            ++_stats["failed_routes"];
+        }
+    }
+    _stats["id_rounds"] = rounds;
+    _stats["groups"] = static_cast<std::int64_t>(sizes.size());
+    for (const auto& [root, size] : sizes) {
+        ++_stats["group_size_" + std::to_string(size)];
+        _stats["largest_group"] = std::max(_stats["largest_group"], size);
+    }
+    return routes;
+}
+
+std::map<std::string, std::int64_t> IndependencePlanner::get_stats() const {
+    return _stats;
+}
+
+IndependencePlanner::GroupResult IndependencePlanner::plan_group(
+    const std::vector<int>& members,
+    std::shared_ptr<const DistanceField> field) const {
+    std::vector<Person> persons;
+    persons.reserve(members.size());
+    for (int member : members) {
+        persons.push_back(_persons[std::size_t(member)]);
+    }
+    PrioritizedPlanner planner(persons, _goal_list, _grid, std::move(field),
+                               _options.planner);
+    planner.set_budget(_budget);
+
+    GroupResult result;
+    result.routes = planner.plan_all_routes();
+    result.stats = planner.get_stats();
+    result.partial = planner.is_partial();
+    return result;
+}
+
+std::vector<std::pair<int, int>> IndependencePlanner::find_interactions(
+    const std::vector<std::vector<Action>>& routes,
+    const std::vector<int>& group_of) const {
+    std::vector<Visit> visits;
+    for (std::size_t i = 0; i < routes.size(); ++i) {
+        Point cell = _persons[i].get_position();
+        if (routes[i].empty()) {
+            visits.push_back({cell, 0, FOREVER, int(i)});
+            continue;
+        }
+        int t = 0;
+        int stay_start = 0;
+        for (auto action : routes[i]) {
+            Point next = cell + action;
+            int move_cost = get_cost(action);
+            if (next != cell) {
+                visits.push_back({cell, stay_start, t + move_cost - 1, int(i)});
+                cell = next;
+                stay_start = t + move_cost;
+            }
+            t += move_cost;
+        }
+        // The person leaves the map at the goal
+        visits.push_back({cell, stay_start, t, int(i)});
+    }
+    std::sort(visits.begin(), visits.end(),
+              [](const Visit& lhs, const Visit& rhs) {
+                  return std::make_tuple(lhs.cell.get_x(), lhs.cell.get_y(),
+                                         lhs.start) <
+                         std::make_tuple(rhs.cell.get_x(), rhs.cell.get_y(),
+                                         rhs.start);
+              });
+
+    // Every move the reservation table forbids puts two persons in one cell
+    // at most one tick apart, so checking stays of every cell is enough
+    std::vector<std::pair<int, int>> interactions;
+    std::vector<const Visit*> active;
+    for (std::size_t i = 0; i < visits.size(); ++i) {
+        const auto& visit = visits[i];
+        if (i == 0 || visits[i - 1].cell != visit.cell) {
+            active.clear();
+        }
+        std::erase_if(active, [&visit](const Visit* other) {
+            return other->end < visit.start - 1;
+        });
+        for (const auto* other : active) {
+            if (group_of[std::size_t(other->person)] !=
+                group_of[std::size_t(visit.person)]) {
+                interactions.emplace_back(other->person, visit.person);
+            }
+        }
+        active.push_back(&visit);
+    }
+    return interactions;
+}
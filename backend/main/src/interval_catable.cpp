@@ -0,0 +1,265 @@
+#include "interval_catable.h"
+
+#include <algorithm>
+
+#include "actions.h"
+
+IntervalCATable::IntervalCATable(const Point& lower_left,
+                                 const Point& upper_right)
+    : _lower_left(lower_left),
+      _upper_right(upper_right),
+      _index_lower_left(lower_left) {}
+
+void IntervalCATable::add_trajectory(int /*traj_id*/,
+                                     const std::vector<Point>& trajectory,
+                                     int start_time) {
+    if (trajectory.size() == 0) {
+        return;
+    }
+    _trajectory_marks.push_back(_undo_log.size());
+    int t = start_time;
+    Point stay_point = trajectory[0];
+    int stay_start = start_time;
+    for (std::size_t i = 1; i < trajectory.size(); ++i) {
+        const Point& coord = trajectory[i];
+        int move_cost = stay_point.get_move_cost(coord);
+        if (coord != stay_point) {
+            add_interval(stay_point.get_x(), stay_point.get_y(),
+                         {stay_start, t + move_cost - 1});
+            stay_point = coord;
+            stay_start = t + move_cost;
+        }
+        t += move_cost;
+    }
+    add_interval(stay_point.get_x(), stay_point.get_y(), {stay_start, t});
+}
+
+void IntervalCATable::clear() {
+    for (int cell : _slot_cells) {
+        _cell_slots[std::size_t(cell)] = 0;
+    }
+    _slot_cells.clear();
+    _intervals.clear();
+    _horizon = -1;
+    _undo_log.clear();
+    _undo_intervals.clear();
+    _trajectory_marks.clear();
+}
+
+void IntervalCATable::rollback(std::size_t trajectory_count) {
+    if (trajectory_count >= _trajectory_marks.size()) {
+        return;
+    }
+    std::size_t mark = _trajectory_marks[trajectory_count];
+    _trajectory_marks.resize(trajectory_count);
+    while (_undo_log.size() > mark) {
+        const auto& entry = _undo_log.back();
+        std::uint32_t& slot = _cell_slots[std::size_t(entry.cell)];
+        if (entry.new_slot) {
+            // Slots are created in log order, so this is the last one
+            slot = 0;
+            _slot_cells.pop_back();
+            _intervals.pop_back();
+        } else {
+            auto& intervals = _intervals[slot - 1];
+            auto position = intervals.begin() + entry.position;
+            auto absorbed = _undo_intervals.begin() + entry.absorbed_begin;
+            if (entry.absorbed_count == 0) {
+                intervals.erase(position);
+            } else {
+                *position = *absorbed;
+                intervals.insert(position + 1, absorbed + 1,
+                                 absorbed + entry.absorbed_count);
+            }
+            _undo_intervals.resize(entry.absorbed_begin);
+        }
+        _horizon = entry.previous_horizon;
+        _undo_log.pop_back();
+    }
+}
+
+int IntervalCATable::cell_id(int x, int y) const noexcept {
+    int local_x = x - _index_lower_left.get_x();
+    int local_y = y - _index_lower_left.get_y();
+    if (local_x < 0 || local_y < 0 || local_x >= _width ||
+        local_y >= _height) {
+        return -1;
+    }
+    return local_y * _width + local_x;
+}
+
+void IntervalCATable::grow_index(int x, int y) {
+    int min_x = x;
+    int min_y = y;
+    int max_x = x;
+    int max_y = y;
+    if (_width > 0) {
+        // At least double every side, so a route crossing the map costs a
+        // few rebuilds and not one per step
+        min_x = std::min(min_x, _index_lower_left.get_x() - _width);
+        min_y = std::min(min_y, _index_lower_left.get_y() - _height);
+        max_x = std::max(max_x, _index_lower_left.get_x() + 2 * _width - 1);
+        max_y = std::max(max_y, _index_lower_left.get_y() + 2 * _height - 1);
+    }
+    min_x = std::max(min_x, _lower_left.get_x());
+    min_y = std::max(min_y, _lower_left.get_y());
+    max_x = std::min(max_x, _upper_right.get_x());
+    max_y = std::min(max_y, _upper_right.get_y());
+
+    Point old_lower_left = _index_lower_left;
+    int old_width = _width;
+    _index_lower_left = Point(min_x, min_y);
+    _width = max_x - min_x + 1;
+    _height = max_y - min_y + 1;
+    auto move_cell = [&](int cell) {
+        return cell_id(old_lower_left.get_x() + cell % old_width,
+                       old_lower_left.get_y() + cell / old_width);
+    };
+    for (int& cell : _slot_cells) {
+        cell = move_cell(cell);
+    }
+    for (auto& entry : _undo_log) {
+        entry.cell = move_cell(entry.cell);
+    }
+    _cell_slots.assign(std::size_t(_width) * std::size_t(_height), 0);
+    for (std::size_t i = 0; i < _slot_cells.size(); ++i) {
+        _cell_slots[std::size_t(_slot_cells[i])] =
+            static_cast<std::uint32_t>(i + 1);
+    }
+}
+
+const std::vector<TimeInterval>* IntervalCATable::get_intervals(int x,
+                                                                int y) const {
+    int cell = cell_id(x, y);
+    if (cell < 0) {
+        return nullptr;
+    }
+    std::uint32_t slot = _cell_slots[std::size_t(cell)];
+    if (slot == 0) {
+        return nullptr;
+    }
+    return &_intervals[slot - 1];
+}
+
+void IntervalCATable::add_interval(int x, int y, TimeInterval interval) {
+    if (x < _lower_left.get_x() || y < _lower_left.get_y() ||
+        x > _upper_right.get_x() || y > _upper_right.get_y()) {
+        return;
+    }
+    int cell = cell_id(x, y);
+    if (cell < 0) {
+        grow_index(x, y);
+        cell = cell_id(x, y);
+    }
+    UndoEntry entry{cell, 0, std::uint32_t(_undo_intervals.size()), 0,
+                    false, _horizon};
+    _horizon = std::max(_horizon, interval.end);
+    std::uint32_t& slot = _cell_slots[std::size_t(cell)];
+    if (slot == 0) {
+        _intervals.emplace_back();
+        _slot_cells.push_back(cell);
+        slot = static_cast<std::uint32_t>(_intervals.size());
+        entry.new_slot = true;
+    }
+    auto& intervals = _intervals[slot - 1];
+    // Keep intervals disjoint: absorb every interval that overlaps or touches
+    // the new one
+    auto first = std::lower_bound(
+        intervals.begin(), intervals.end(), interval.start - 1,
+        [](const TimeInterval& lhs, int t) { return lhs.end < t; });
+    auto last = first;
+    while (last != intervals.end() && last->start <= interval.end + 1) {
+        interval.start = std::min(interval.start, last->start);
+        interval.end = std::max(interval.end, last->end);
+        ++last;
+    }
+    entry.position = std::uint32_t(first - intervals.begin());
+    if (!entry.new_slot) {
+        entry.absorbed_count = std::uint32_t(last - first);
+        _undo_intervals.insert(_undo_intervals.end(), first, last);
+    }
+    _undo_log.push_back(entry);
+    if (first == last) {
+        intervals.insert(first, interval);
+        return;
+    }
+    *first = interval;
+    intervals.erase(first + 1, last);
+}
+
+bool IntervalCATable::is_range_available(int x, int y, int t_from,
+                                         int t_to) const {
+    if (t_from > t_to) {
+        return true;
+    }
+    const auto* intervals = get_intervals(x, y);
+    if (intervals == nullptr) {
+        return true;
+    }
+    auto it = std::lower_bound(
+        intervals->begin(), intervals->end(), t_from,
+        [](const TimeInterval& lhs, int t) { return lhs.end < t; });
+    return it == intervals->end() || it->start > t_to;
+}
+
+bool IntervalCATable::check_move(const Point& from, const Point& to,
+                                 int start_time) const {
+    if (from == to) {
+        return is_range_available(from.get_x(), from.get_y(), start_time + 1,
+                                  start_time + get_cost(Action::WAIT));
+    }
+    int new_time = start_time + from.get_move_cost(to);
+    if (!is_range_available(to.get_x(), to.get_y(), new_time, new_time)) {
+        return false;
+    }
+    if (!is_range_available(from.get_x(), from.get_y(), start_time + 1,
+                            new_time - 1)) {
+        return false;
+    }
+    // Same swap rule as in CATable: nobody goes from <to> to <from> while we
+    // go from <from> to <to>
+    bool someone_moving_from_to_to_from =
+        !is_range_available(from.get_x(), from.get_y(), new_time, new_time) &&
+        !is_range_available(to.get_x(), to.get_y(), new_time - 1,
+                            new_time - 1);
+    return !someone_moving_from_to_to_from;
+}
+
+int IntervalCATable::last_visited(const Point& point) const {
+    const auto* intervals = get_intervals(point.get_x(), point.get_y());
+    if (intervals == nullptr || intervals->empty()) {
+        return -1;
+    }
+    return intervals->back().end;
+}
+
+int IntervalCATable::get_reserved_ticks(const Point& point) const {
+    const auto* intervals = get_intervals(point.get_x(), point.get_y());
+    if (intervals == nullptr) {
+        return 0;
+    }
+    int ticks = 0;
+    for (const auto& interval : *intervals) {
+        ticks += interval.end - interval.start + 1;
+    }
+    return ticks;
+}
+
+std::vector<Point> IntervalCATable::get_neighbors_timestep(const Point& point,
+                                                           int time) const {
+    auto neighbors = point.get_neighbors();
+    neighbors.push_back(point);
+
+    std::vector<Point> valid_neighbors;
+    for (const auto& neighbor : neighbors) {
+        if (check_move(point, neighbor, time)) {
+            valid_neighbors.push_back(  // cppcheck-suppress useStlAlgorithm
+                neighbor);
+        }
+    }
+    if (valid_neighbors.empty()) {
+        valid_neighbors.push_back(point);
+    }
+
+    return valid_neighbors;
+}
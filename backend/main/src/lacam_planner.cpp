@@ -0,0 +1,437 @@
+#include "lacam_planner.h"
+
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+#include "actions.h"
+
+namespace {
+constexpr int VANISHED = -1;
+constexpr int UNDECIDED = -2;
+constexpr int NOBODY = -1;
+// Configurations kept at once, counted in cells
+constexpr std::size_t MAX_STORED_CELLS = std::size_t(1) << 24;
+// One of that many visits of a known configuration during refinement
+// starts over from the first one, so other ways get explored too
+constexpr std::uint32_t RESTART_PERIOD = 1000;
+constexpr std::array STRAIGHT_MOVES = {
+    Action::UP,
+    Action::DOWN,
+    Action::LEFT,
+    Action::RIGHT,
+};
+
+std::uint64_t hash_cells(const std::vector<int>& cells) noexcept {
+    // FNV-1a over whole cells, the hash map mixes the bits once more
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (int cell : cells) {
+        hash ^= std::uint64_t(static_cast<std::uint32_t>(cell));
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+}  // namespace
+
+LacamPlanner::LacamPlanner(const std::vector<Person>& persons,
+                           const std::vector<Goal>& goals, Grid* grid,
+                           LacamOptions options)
+    : Planner(persons, goals, grid),
+      _options(options),
+      _field(*grid, get_goal_positions(), false),
+      _lower_left(grid->get_lower_left()),
+      _width(std::max(0, grid->get_upper_right().get_x() -
+                             grid->get_lower_left().get_x() + 1)),
+      _height(std::max(0, grid->get_upper_right().get_y() -
+                              grid->get_lower_left().get_y() + 1)),
+      _goal(-1),
+      _goal_cost(0) {}
+
+std::vector<std::vector<Action>> LacamPlanner::plan_all_routes() {
+    std::size_t cell_count = std::size_t(_width) * std::size_t(_height);
+    _distances.resize(cell_count);
+    for (std::size_t cell = 0; cell < cell_count; ++cell) {
+        _distances[cell] = _field.get_distance(to_point(int(cell)));
+    }
+    _blocked.assign(cell_count, 0);
+    _holders.assign(cell_count, NOBODY);
+    _next_holders.assign(cell_count, NOBODY);
+    _movers.clear();
+    _nodes.clear();
+    _explored.clear();
+    _stats.clear();
+    _goal = -1;
+    _goal_cost = 0;
+    _partial = false;
+    _generator.seed(_options.seed);
+
+    Configuration start;
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        auto position = _persons[i].get_position();
+        int distance = _field.get_distance(position);
+        if (distance == DistanceField::UNREACHABLE) {
+            // Stands in the way forever
+            int cell = cell_id(position);
+            if (cell >= 0) {
+                _blocked[std::size_t(cell)] = 1;
+            }
+        } else if (distance > 0) {
+            _movers.push_back(int(i));
+            start.push_back(cell_id(position));
+        }
+    }
+    std::vector<int> lengths(start.size());
+    _priority.resize(start.size());
+    for (std::size_t k = 0; k < start.size(); ++k) {
+        lengths[k] = _distances[std::size_t(start[k])];
+        _priority[k] = int(k);
+    }
+    std::stable_sort(_priority.begin(), _priority.end(),
+                     [&lengths](int lhs, int rhs) {
+                         return lengths[std::size_t(lhs)] >
+                                lengths[std::size_t(rhs)];
+                     });
+
+    const int root = add_node(std::move(start), -1);
+    int closest = root;
+    std::vector<int> open{root};
+    std::int64_t limit = _budget->get_share(1);
+    std::int64_t expansions = 0;
+    Configuration next;
+    while (!open.empty()) {
+        if (_budget->is_exhausted()) {
+            _partial = _goal < 0;
+            break;
+        }
+        if (expansions >= limit ||
+            _nodes.size() * _movers.size() >= MAX_STORED_CELLS) {
+            break;
+        }
+        int index = open.back();
+        if (_nodes[std::size_t(index)].estimate == 0) {
+            offer_goal(index);
+            if (!_options.refine) {
+                break;
+            }
+            open.pop_back();
+            continue;
+        }
+        auto& node = _nodes[std::size_t(index)];
+        if ((_goal >= 0 && node.cost + node.estimate >= _goal_cost) ||
+            node.next_constraint == node.constraints.size()) {
+            open.pop_back();
+            continue;
+        }
+        Constraint constraint =
+            std::move(node.constraints[node.next_constraint++]);
+        ++expansions;
+        _budget->spend(1);
+
+        // Every visit of the node forces one more person in the children
+        // of the constraint
+        auto order = get_order(node.cells);
+        if (constraint.who.size() < order.size()) {
+            int person = order[constraint.who.size()];
+            std::array<int, 5> moves;
+            std::size_t count =
+                get_moves(node.cells[std::size_t(person)], moves);
+            std::shuffle(moves.begin(),
+                         moves.begin() + std::ptrdiff_t(count), _generator);
+            for (std::size_t k = 0; k < count; ++k) {
+                Constraint child = constraint;
+                child.who.push_back(person);
+                child.where.push_back(moves[k]);
+                node.constraints.push_back(std::move(child));
+            }
+        }
+        if (!generate(node, constraint, next)) {
+            continue;
+        }
+
+        int known = find_node(next, hash_cells(next));
+        if (known >= 0) {
+            reconnect(index, known, open);
+            int revisit = _options.refine && _generator() % RESTART_PERIOD == 0
+                              ? root
+                              : known;
+            const auto& visited = _nodes[std::size_t(revisit)];
+            if (_goal < 0 || visited.cost + visited.estimate < _goal_cost) {
+                open.push_back(revisit);
+            }
+            continue;
+        }
+        int added = add_node(next, index);
+        const auto& node_added = _nodes[std::size_t(added)];
+        if (node_added.estimate < _nodes[std::size_t(closest)].estimate) {
+            closest = added;
+        }
+        if (_goal < 0 || node_added.cost + node_added.estimate < _goal_cost) {
+            open.push_back(added);
+        }
+    }
+
+    _stats["expansions"] = expansions;
+    _stats["configurations"] = static_cast<std::int64_t>(_nodes.size());
+    auto routes = extract_routes(_goal >= 0 ? _goal : closest);
+    if (_goal >= 0) {
+        _stats["sum_of_costs"] = _goal_cost;
+    }
+    for (std::size_t i = 0; i < routes.size(); ++i) {
+        int cost = 0;
+        for (auto action : routes[i]) {
+            cost += get_cost(action);
+            if (action == Action::WAIT) {
+                ++_stats["waits"];
+            }
+        }
+        _stats["makespan"] = std::max<std::int64_t>(_stats["makespan"], cost);
+    }
+    if (_goal < 0) {
+        const auto& cells = _nodes[std::size_t(closest)].cells;
+        _stats["unfinished_routes"] = std::count_if(
+            cells.begin(), cells.end(),
+            [this](int cell) { return is_present(cell); });
+    }
+    return routes;
+}
+
+std::map<std::string, std::int64_t> LacamPlanner::get_stats() const {
+    return _stats;
+}
+
+bool LacamPlanner::generate(const Node& node, const Constraint& constraint,
+                            Configuration& next) {
+    const auto& cells = node.cells;
+    next.assign(cells.size(), UNDECIDED);
+    for (std::size_t k = 0; k < cells.size(); ++k) {
+        if (is_present(cells[k])) {
+            _holders[std::size_t(cells[k])] = int(k);
+        } else {
+            next[k] = VANISHED;
+        }
+    }
+
+    auto is_generated = [&] {
+        for (std::size_t k = 0; k < constraint.who.size(); ++k) {
+            int person = constraint.who[k];
+            int cell = constraint.where[k];
+            int other = _holders[std::size_t(cell)];
+            if (_next_holders[std::size_t(cell)] != NOBODY ||
+                (other != NOBODY && other != person &&
+                 next[std::size_t(other)] == cells[std::size_t(person)])) {
+                return false;
+            }
+            next[std::size_t(person)] = cell;
+            _next_holders[std::size_t(cell)] = person;
+        }
+        for (int person : get_order(cells)) {
+            if (next[std::size_t(person)] == UNDECIDED &&
+                !push(person, cells, next)) {
+                return false;
+            }
+        }
+        return true;
+    }();
+
+    for (std::size_t k = 0; k < cells.size(); ++k) {
+        if (next[k] >= 0) {
+            _next_holders[std::size_t(next[k])] = NOBODY;
+        }
+        if (is_present(cells[k])) {
+            _holders[std::size_t(cells[k])] = NOBODY;
+        }
+    }
+    return is_generated;
+}
+
+bool LacamPlanner::push(int person, const Configuration& cells,
+                        Configuration& next) {
+    int from = cells[std::size_t(person)];
+    std::array<int, 5> moves;
+    std::size_t count = get_moves(from, moves);
+    // Closest to a goal first, staying or free cells before taken ones
+    auto key = [this, person](int cell) {
+        int holder = _holders[std::size_t(cell)];
+        return std::make_pair(_distances[std::size_t(cell)],
+                              holder != NOBODY && holder != person);
+    };
+    std::stable_sort(moves.begin(), moves.begin() + std::ptrdiff_t(count),
+                     [&key](int lhs, int rhs) { return key(lhs) < key(rhs); });
+
+    for (std::size_t k = 0; k < count; ++k) {
+        int to = moves[k];
+        int other = _holders[std::size_t(to)];
+        bool is_other = other != NOBODY && other != person;
+        // No two persons in one cell and no swaps
+        if (_next_holders[std::size_t(to)] != NOBODY ||
+            (is_other && next[std::size_t(other)] == from)) {
+            continue;
+        }
+        _next_holders[std::size_t(to)] = person;
+        next[std::size_t(person)] = to;
+        // The person standing there makes way first, if it can not, it
+        // takes the cell back
+        if (is_other && next[std::size_t(other)] == UNDECIDED &&
+            !push(other, cells, next)) {
+            continue;
+        }
+        return true;
+    }
+    _next_holders[std::size_t(from)] = person;
+    next[std::size_t(person)] = from;
+    return false;
+}
+
+int LacamPlanner::add_node(Configuration cells, int parent) {
+    std::uint64_t hash = hash_cells(cells);
+    Node node{std::move(cells), parent, 0, 0, 0, {Constraint{}}, 0, {}, -1};
+    for (int cell : node.cells) {
+        if (is_present(cell)) {
+            node.estimate += _distances[std::size_t(cell)];
+            node.step_cost += get_cost(Action::WAIT);
+        }
+    }
+    if (parent >= 0) {
+        const auto& parent_node = _nodes[std::size_t(parent)];
+        node.cost = parent_node.cost + parent_node.step_cost;
+    }
+    if (const int* head = _explored.find(hash)) {
+        node.next_same_hash = *head;
+    }
+    int index = int(_nodes.size());
+    _nodes.push_back(std::move(node));
+    _explored[hash] = index;
+    if (parent >= 0) {
+        _nodes[std::size_t(parent)].successors.push_back(index);
+    }
+    return index;
+}
+
+int LacamPlanner::find_node(const Configuration& cells,
+                            std::uint64_t hash) const {
+    const int* head = _explored.find(hash);
+    for (int index = head != nullptr ? *head : -1; index >= 0;
+         index = _nodes[std::size_t(index)].next_same_hash) {
+        if (_nodes[std::size_t(index)].cells == cells) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+void LacamPlanner::reconnect(int from, int to, std::vector<int>& open) {
+    auto& successors = _nodes[std::size_t(from)].successors;
+    if (std::find(successors.begin(), successors.end(), to) ==
+        successors.end()) {
+        successors.push_back(to);
+    }
+    // Costs only go down and every step costs something, so the parents
+    // never form a cycle
+    std::queue<int> queue;
+    queue.push(from);
+    while (!queue.empty()) {
+        int current = queue.front();
+        queue.pop();
+        const auto& node = _nodes[std::size_t(current)];
+        std::int64_t cost = node.cost + node.step_cost;
+        for (int successor : node.successors) {
+            auto& next = _nodes[std::size_t(successor)];
+            if (cost >= next.cost) {
+                continue;
+            }
+            next.cost = cost;
+            next.parent = current;
+            queue.push(successor);
+            if (next.estimate == 0) {
+                offer_goal(successor);
+            } else if (_goal >= 0 && next.cost + next.estimate < _goal_cost) {
+                open.push_back(successor);
+            }
+        }
+    }
+}
+
+void LacamPlanner::offer_goal(int node) {
+    std::int64_t cost = _nodes[std::size_t(node)].cost;
+    if (_goal >= 0 && cost >= _goal_cost) {
+        return;
+    }
+    if (_goal >= 0) {
+        ++_stats["refinements"];
+    }
+    _goal = node;
+    _goal_cost = cost;
+}
+
+std::vector<int> LacamPlanner::get_order(const Configuration& cells) const {
+    std::vector<int> order;
+    order.reserve(cells.size());
+    for (int person : _priority) {
+        if (is_present(cells[std::size_t(person)])) {
+            order.push_back(person);
+        }
+    }
+    return order;
+}
+
+std::size_t LacamPlanner::get_moves(int cell,
+                                    std::array<int, 5>& moves) const {
+    std::size_t count = 0;
+    moves[count++] = cell;
+    Point from = to_point(cell);
+    for (auto action : STRAIGHT_MOVES) {
+        Point to = from + action;
+        if (!_field.is_valid_move(from, to)) {
+            continue;
+        }
+        int id = cell_id(to);
+        if (_distances[std::size_t(id)] != DistanceField::UNREACHABLE &&
+            !_blocked[std::size_t(id)]) {
+            moves[count++] = id;
+        }
+    }
+    return count;
+}
+
+bool LacamPlanner::is_present(int cell) const noexcept {
+    // Persons at a goal vanish before the next step
+    return cell != VANISHED && _distances[std::size_t(cell)] != 0;
+}
+
+int LacamPlanner::cell_id(const Point& cell) const noexcept {
+    int local_x = cell.get_x() - _lower_left.get_x();
+    int local_y = cell.get_y() - _lower_left.get_y();
+    if (local_x < 0 || local_y < 0 || local_x >= _width ||
+        local_y >= _height) {
+        return -1;
+    }
+    return local_y * _width + local_x;
+}
+
+Point LacamPlanner::to_point(int cell) const noexcept {
+    return Point(_lower_left.get_x() + cell % _width,
+                 _lower_left.get_y() + cell / _width);
+}
+
+std::vector<std::vector<Action>> LacamPlanner::extract_routes(
+    int node) const {
+    std::vector<int> path;
+    for (int index = node; index >= 0;
+         index = _nodes[std::size_t(index)].parent) {
+        path.push_back(index);
+    }
+    std::reverse(path.begin(), path.end());
+
+    std::vector<std::vector<Action>> routes(_persons.size());
+    for (std::size_t step = 1; step < path.size(); ++step) {
+        const auto& before = _nodes[std::size_t(path[step - 1])].cells;
+        const auto& after = _nodes[std::size_t(path[step])].cells;
+        for (std::size_t k = 0; k < before.size(); ++k) {
+            if (is_present(before[k])) {
+                routes[std::size_t(_movers[k])].push_back(
+                    to_point(before[k]).to_another(to_point(after[k])));
+            }
+        }
+    }
+    return routes;
+}
@@ -0,0 +1,327 @@
+#include "lns_planner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#include "flat_hash.h"
+#include "search_footprint.h"
+#include "space_time_search.h"
+
+namespace {
+// Persons passing this close to the cell of a map neighborhood join it
+constexpr int MAP_RADIUS = 2;
+}  // namespace
+
+LnsPlanner::LnsPlanner(const std::vector<Person>& persons,
+                       const std::vector<Goal>& goals, Grid* grid,
+                       std::unique_ptr<Planner> initial, LnsOptions options)
+    : Planner(persons, goals, grid),
+      _initial(std::move(initial)),
+      _options(std::move(options)),
+      _field(*grid, get_goal_positions()) {
+    _options.neighborhood = std::max(1u, _options.neighborhood);
+    if (_options.threads == 0) {
+        _options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        int distance = _field.get_distance(_persons[i].get_position());
+        if (distance != DistanceField::UNREACHABLE && distance > 0) {
+            _movers.push_back(int(i));
+        }
+    }
+}
+
+std::vector<std::vector<Action>> LnsPlanner::plan_all_routes() {
+    _stats.clear();
+    _initial->set_budget(_budget);
+    auto best = evaluate(_initial->plan_all_routes());
+    _partial = _initial->is_partial();
+    _stats["initial_failed_routes"] = best.failed_count;
+    _stats["initial_sum_of_costs"] = best.sum_of_costs;
+    _stats["initial_makespan"] = best.makespan;
+    report(best, 0);
+
+    // Nobody can do better than bringing every person that can reach a goal
+    // in by its static distance
+    std::int64_t min_failed =
+        std::count_if(_persons.begin(), _persons.end(), [this](const auto& p) {
+            return _field.get_distance(p.get_position()) ==
+                   DistanceField::UNREACHABLE;
+        });
+    std::int64_t min_sum_of_costs = 0;
+    for (int agent : _movers) {
+        min_sum_of_costs +=
+            _field.get_distance(_persons[std::size_t(agent)].get_position());
+    }
+
+    // One table per worker for the whole search, clearing it only resets
+    // the cells the last repair touched
+    std::vector<IntervalCATable> tables(
+        _options.threads,
+        IntervalCATable(_grid->get_lower_left(), _grid->get_upper_right()));
+    const std::vector<std::pair<NeighborhoodKind, std::string>> KINDS = {
+        {NeighborhoodKind::RANDOM, "improved_random"},
+        {NeighborhoodKind::AGENT, "improved_agent"},
+        {NeighborhoodKind::MAP, "improved_map"}};
+    std::int64_t iteration = 0;
+    auto iterations = std::int64_t(_options.iterations);
+    while (iteration < iterations && !_movers.empty() &&
+           !_budget->is_exhausted() &&
+           std::tie(best.failed_count, best.sum_of_costs) >
+               std::tie(min_failed, min_sum_of_costs)) {
+        // Every worker repairs its own neighborhood of the same routes, the
+        // routes only change between rounds
+        auto count = std::size_t(std::min<std::int64_t>(
+            _options.threads, iterations - iteration));
+        std::vector<Repair> repairs(count);
+        std::atomic<std::size_t> next(0);
+        {
+            std::vector<std::jthread> workers;
+            for (std::size_t i = 0; i < count; ++i) {
+                workers.emplace_back([&, i, this] {
+                    for (std::size_t k = next++; k < count; k = next++) {
+                        auto number = std::uint64_t(iteration) + k;
+                        std::seed_seq seed{std::uint64_t(_options.seed),
+                                           number};
+                        std::mt19937 random(seed);
+                        auto kind = KINDS[number % KINDS.size()].first;
+                        repairs[k] = repair(
+                            best, choose_neighborhood(best, kind, random),
+                            random, tables[i]);
+                    }
+                });
+            }
+        }
+
+        std::optional<Solution> round_best;
+        std::size_t round_best_index = 0;
+        for (std::size_t k = 0; k < count; ++k) {
+            _stats["expansions"] += repairs[k].expansions;
+            if (!repairs[k].complete) {
+                continue;
+            }
+            auto routes = best.routes;
+            for (std::size_t j = 0; j < repairs[k].members.size(); ++j) {
+                routes[std::size_t(repairs[k].members[j])] =
+                    std::move(repairs[k].routes[j]);
+            }
+            auto candidate = evaluate(std::move(routes));
+            if (is_better(candidate, round_best ? *round_best : best)) {
+                round_best = std::move(candidate);
+                round_best_index = k;
+            }
+        }
+        iteration += std::int64_t(count);
+        if (round_best) {
+            best = std::move(*round_best);
+            auto number = std::uint64_t(iteration) - count + round_best_index;
+            ++_stats["lns_improvements"];
+            ++_stats[KINDS[number % KINDS.size()].second];
+            report(best, iteration);
+        }
+    }
+
+    _stats["lns_iterations"] = iteration;
+    _stats["failed_routes"] = best.failed_count;
+    _stats["sum_of_costs"] = best.sum_of_costs;
+    _stats["makespan"] = best.makespan;
+    return std::move(best.routes);
+}
+
+std::map<std::string, std::int64_t> LnsPlanner::get_stats() const {
+    return _stats;
+}
+
+LnsPlanner::Solution LnsPlanner::evaluate(
+    std::vector<std::vector<Action>> routes) const {
+    Solution solution;
+    solution.routes = std::move(routes);
+    solution.routes.resize(_persons.size());
+    solution.costs.assign(_persons.size(), 0);
+    solution.failed.assign(_persons.size(), 0);
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        // Routes of some initial planners end before a goal
+        Point cell = _persons[i].get_position();
+        for (auto action : solution.routes[i]) {
+            solution.costs[i] += get_cost(action);
+            cell = cell + action;
+        }
+        if (!is_reached_goal(cell)) {
+            solution.failed[i] = 1;
+            ++solution.failed_count;
+        }
+        solution.sum_of_costs += solution.costs[i];
+        solution.makespan =
+            std::max<std::int64_t>(solution.makespan, solution.costs[i]);
+    }
+    return solution;
+}
+
+std::vector<int> LnsPlanner::choose_neighborhood(const Solution& solution,
+                                                 NeighborhoodKind kind,
+                                                 std::mt19937& random) const {
+    std::size_t size = std::min<std::size_t>(_options.neighborhood,
+                                             _movers.size());
+    std::vector<int> members;
+    std::vector<int> candidates;
+    if (kind == NeighborhoodKind::AGENT) {
+        // A delayed person and the persons on its shortest route, which are
+        // the ones that could have delayed it
+        std::vector<int> delayed;
+        for (int agent : _movers) {
+            auto position = _persons[std::size_t(agent)].get_position();
+            if (solution.failed[std::size_t(agent)] ||
+                solution.costs[std::size_t(agent)] >
+                    _field.get_distance(position)) {
+                delayed.push_back(agent);
+            }
+        }
+        if (!delayed.empty()) {
+            std::uniform_int_distribution<std::size_t> pick(
+                0, delayed.size() - 1);
+            int agent = delayed[pick(random)];
+            members.push_back(agent);
+            FlatHashSet<Point> cells;
+            std::optional<Point> cell =
+                _persons[std::size_t(agent)].get_position();
+            for (; cell.has_value(); cell = _field.get_next(*cell)) {
+                cells.insert(*cell);
+            }
+            for (int other : _movers) {
+                const auto& route = solution.routes[std::size_t(other)];
+                auto trajectory = to_trajectory(other, route);
+                if (other != agent &&
+                    std::any_of(trajectory.begin(), trajectory.end(),
+                                [&cells](const Point& point) {
+                                    return cells.contains(point);
+                                })) {
+                    candidates.push_back(other);
+                }
+            }
+        }
+    } else if (kind == NeighborhoodKind::MAP) {
+        // The persons passing near one cell of some route
+        std::uniform_int_distribution<std::size_t> pick(0, _movers.size() - 1);
+        int agent = _movers[pick(random)];
+        auto trajectory =
+            to_trajectory(agent, solution.routes[std::size_t(agent)]);
+        std::uniform_int_distribution<std::size_t> pick_cell(
+            0, trajectory.size() - 1);
+        Point center = trajectory[pick_cell(random)];
+        for (int other : _movers) {
+            auto other_trajectory =
+                to_trajectory(other, solution.routes[std::size_t(other)]);
+            if (std::any_of(other_trajectory.begin(), other_trajectory.end(),
+                            [&center](const Point& point) {
+                                auto offset = point - center;
+                                return std::abs(offset.get_x()) <=
+                                           MAP_RADIUS &&
+                                       std::abs(offset.get_y()) <= MAP_RADIUS;
+                            })) {
+                candidates.push_back(other);
+            }
+        }
+    }
+
+    std::shuffle(candidates.begin(), candidates.end(), random);
+    for (std::size_t i = 0; i < candidates.size() && members.size() < size;
+         ++i) {
+        members.push_back(candidates[i]);
+    }
+    // Small neighborhoods are filled up with random persons
+    if (members.size() < size) {
+        std::vector<char> is_member(_persons.size(), 0);
+        for (int member : members) {
+            is_member[std::size_t(member)] = 1;
+        }
+        std::vector<int> rest;
+        for (int agent : _movers) {
+            if (!is_member[std::size_t(agent)]) {
+                rest.push_back(agent);
+            }
+        }
+        std::sample(rest.begin(), rest.end(), std::back_inserter(members),
+                    size - members.size(), random);
+    }
+    return members;
+}
+
+LnsPlanner::Repair LnsPlanner::repair(const Solution& solution,
+                                      std::vector<int> members,
+                                      std::mt19937& random,
+                                      IntervalCATable& table) const {
+    std::shuffle(members.begin(), members.end(), random);
+    std::vector<char> is_member(_persons.size(), 0);
+    for (int member : members) {
+        is_member[std::size_t(member)] = 1;
+    }
+    // A person that does not reach a goal stands at the end of its route
+    // forever
+    table.clear();
+    FlatHashSet<Point> stops;
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        if (is_member[i]) {
+            continue;
+        }
+        auto trajectory = to_trajectory(int(i), solution.routes[i]);
+        if (solution.failed[i]) {
+            stops.insert(trajectory.back());
+        }
+        if (trajectory.size() > 1) {
+            table.add_trajectory(int(i), trajectory);
+        }
+    }
+
+    Repair result;
+    result.members = members;
+    SpaceTimeOptions options;
+    options.forced_waits = false;
+    SpaceTimeSearch search(_field, table, stops, *_budget, options);
+    for (std::size_t k = 0; k < members.size(); ++k) {
+        const auto& person = _persons[std::size_t(members[k])];
+        SearchFootprint footprint;
+        int expansions = 0;
+        bool cut = false;
+        auto route = search.search_route(
+            person.get_position(), 0,
+            int(_budget->get_share(std::int64_t(members.size() - k))),
+            nullptr, footprint, expansions, cut);
+        _budget->spend(expansions);
+        result.expansions += expansions;
+        if (!route) {
+            return result;
+        }
+        table.add_trajectory(members[k], to_trajectory(members[k], *route));
+        result.routes.push_back(std::move(*route));
+    }
+    result.complete = true;
+    return result;
+}
+
+std::vector<Point> LnsPlanner::to_trajectory(
+    int agent, const std::vector<Action>& route) const {
+    std::vector<Point> trajectory{_persons[std::size_t(agent)].get_position()};
+    for (auto action : route) {
+        trajectory.push_back(trajectory.back() + action);
+    }
+    return trajectory;
+}
+
+bool LnsPlanner::is_better(const Solution& lhs, const Solution& rhs) {
+    return std::tie(lhs.failed_count, lhs.sum_of_costs, lhs.makespan) <
+           std::tie(rhs.failed_count, rhs.sum_of_costs, rhs.makespan);
+}
+
+void LnsPlanner::report(const Solution& solution,
+                        std::int64_t iteration) const {
+    if (_options.on_improvement) {
+        _options.on_improvement({iteration, solution.failed_count,
+                                 solution.sum_of_costs, solution.makespan});
+    }
+}
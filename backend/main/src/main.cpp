@@ -23,6 +23,32 @@ int main(int /*argc*/, const char** /*argv*/) {
                     result = ApplicationContext::calculate_route_dense(input);
                 } else if (algorithm_name == "random") {
                     result = ApplicationContext::calculate_route_random(input);
+                } else if (algorithm_name == "windowed") {
+                    result =
+                        ApplicationContext::calculate_route_windowed(input);
+                } else if (algorithm_name == "pibt") {
+                    result = ApplicationContext::calculate_route_pibt(input);
+                } else if (algorithm_name == "lacam") {
+                    result = ApplicationContext::calculate_route_lacam(input);
+                } else if (algorithm_name == "ecbs") {
+                    result = ApplicationContext::calculate_route_ecbs(input);
+                } else if (algorithm_name == "pbs") {
+                    result = ApplicationContext::calculate_route_pbs(input);
+                } else if (algorithm_name == "lns") {
+                    result = ApplicationContext::calculate_route_lns(input);
+                } else if (algorithm_name == "flow") {
+                    result = ApplicationContext::calculate_route_flow(input);
+                } else if (algorithm_name == "flow_field") {
+                    result =
+                        ApplicationContext::calculate_route_flow_field(input);
+                } else if (algorithm_name == "social_force") {
+                    result =
+                        ApplicationContext::calculate_route_social_force(input);
+                } else if (algorithm_name == "incremental") {
+                    result =
+                        ApplicationContext::calculate_route_incremental(input);
+                } else if (algorithm_name == "group") {
+                    result = ApplicationContext::calculate_route_group(input);
                 } else {
                     return crow::response(crow::status::BAD_REQUEST,
                                           "Unsupported algorithm");
@@ -30,6 +56,8 @@ int main(int /*argc*/, const char** /*argv*/) {
                 std::stringstream s;
                 s << result;
                 return crow::response(s.str());
+            } catch (const RequestError& error) {
+                return crow::response(crow::status::BAD_REQUEST, error.what());
             } catch (const nlohmann::json::parse_error& error) {
                 return crow::response(crow::status::BAD_REQUEST, "Not json");
             } catch (const nlohmann::json::out_of_range& error) {
@@ -0,0 +1,365 @@
+#include "pbs_planner.h"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+#include "catable.h"
+#include "search_footprint.h"
+
+namespace {
+// End of the stay of a person standing where it is
+constexpr int FOREVER = std::numeric_limits<int>::max();
+}  // namespace
+
+PbsPlanner::PbsPlanner(const std::vector<Person>& persons,
+                       const std::vector<Goal>& goals, Grid* grid,
+                       PbsOptions options)
+    : Planner(persons, goals, grid),
+      _options(options),
+      _field(*grid, get_goal_positions()),
+      _table(grid->get_lower_left(), grid->get_upper_right()) {}
+
+std::vector<std::vector<Action>> PbsPlanner::plan_all_routes() {
+    _stats.clear();
+    _stops.clear();
+    _partial = false;
+    std::vector<int> movers;
+    for (int i = 0; i < static_cast<int>(_persons.size()); ++i) {
+        auto position = _persons[std::size_t(i)].get_position();
+        int distance = _field.get_distance(position);
+        if (distance == DistanceField::UNREACHABLE) {
+            _stops.insert(position);
+        } else if (distance > 0) {
+            movers.push_back(i);
+        }
+    }
+
+    // A person without any route stands in the way of the others, so they
+    // are planned again around it
+    Node root{Routes(_persons.size()), {}, 0};
+    root.lower.resize(_persons.size());
+    for (bool is_stopped_more = true; is_stopped_more;) {
+        is_stopped_more = false;
+        root.routes.assign(_persons.size(), nullptr);
+        _table.clear();
+        for (int agent : movers) {
+            auto position = _persons[std::size_t(agent)].get_position();
+            if (_stops.contains(position)) {
+                continue;
+            }
+            root.routes[std::size_t(agent)] = plan_route(agent);
+            if (!root.routes[std::size_t(agent)]) {
+                _stops.insert(position);
+                is_stopped_more = true;
+            }
+        }
+    }
+    for (const auto& route : root.routes) {
+        root.cost += route ? route->cost : 0;
+    }
+
+    Routes best = root.routes;
+    auto best_collisions = std::numeric_limits<std::size_t>::max();
+    bool is_solved = false;
+    std::vector<Node> stack;
+    stack.push_back(std::move(root));
+    Node node;
+    while (!stack.empty()) {
+        if (_budget->is_exhausted()) {
+            _partial = true;
+            break;
+        }
+        if (_stats["high_level_nodes"] >= _options.max_nodes) {
+            break;
+        }
+        node = std::move(stack.back());
+        stack.pop_back();
+        ++_stats["high_level_nodes"];
+        auto collisions = find_collisions(node.routes);
+        if (collisions.empty()) {
+            is_solved = true;
+            break;
+        }
+        if (collisions.size() < best_collisions) {
+            best = node.routes;
+            best_collisions = collisions.size();
+        }
+
+        auto collision = *std::min_element(
+            collisions.begin(), collisions.end(),
+            [](const Collision& lhs, const Collision& rhs) {
+                return lhs.time < rhs.time;
+            });
+        if (!node.routes[std::size_t(collision.first)] ||
+            !node.routes[std::size_t(collision.second)]) {
+            continue;
+        }
+        std::vector<Node> children;
+        for (auto [higher, lower] :
+             {std::make_pair(collision.first, collision.second),
+              std::make_pair(collision.second, collision.first)}) {
+            // The order of the two may already follow from other priorities
+            if (is_above(node, lower, higher)) {
+                continue;
+            }
+            Node child = node;
+            child.lower[std::size_t(higher)].push_back(lower);
+            if (replan(child, lower)) {
+                children.push_back(std::move(child));
+            }
+        }
+        // The cheaper child is explored first
+        std::sort(children.begin(), children.end(),
+                  [](const Node& lhs, const Node& rhs) {
+                      return lhs.cost > rhs.cost;
+                  });
+        for (auto& child : children) {
+            stack.push_back(std::move(child));
+        }
+    }
+
+    Routes routes;
+    if (is_solved) {
+        routes = std::move(node.routes);
+        for (const auto& lower : node.lower) {
+            _stats["priority_pairs"] +=
+                static_cast<std::int64_t>(lower.size());
+        }
+    } else {
+        routes = drop_colliding(std::move(best));
+    }
+
+    std::vector<std::vector<Action>> results(_persons.size());
+    for (int agent : movers) {
+        const auto& route = routes[std::size_t(agent)];
+        if (!route) {
+            ++_stats["failed_routes"];
+            continue;
+        }
+        _stats["sum_of_costs"] += route->cost;
+        _stats["makespan"] =
+            std::max<std::int64_t>(_stats["makespan"], route->cost);
+        results[std::size_t(agent)] = route->actions;
+    }
+    return results;
+}
+
+std::map<std::string, std::int64_t> PbsPlanner::get_stats() const {
+    return _stats;
+}
+
+bool PbsPlanner::replan(Node& node, int agent) {
+    // Persons below <agent>, every one after all persons above it
+    std::vector<int> order;
+    std::vector<char> is_visited(_persons.size(), 0);
+    auto visit = [&](auto&& self, int current) -> void {
+        is_visited[std::size_t(current)] = 1;
+        for (int next : node.lower[std::size_t(current)]) {
+            if (!is_visited[std::size_t(next)]) {
+                self(self, next);
+            }
+        }
+        order.push_back(current);
+    };
+    visit(visit, agent);
+    std::reverse(order.begin(), order.end());
+
+    std::vector<std::vector<int>> upper(_persons.size());
+    for (std::size_t i = 0; i < node.lower.size(); ++i) {
+        for (int next : node.lower[i]) {
+            upper[std::size_t(next)].push_back(int(i));
+        }
+    }
+    for (int current : order) {
+        // Routes of every person above this one are reserved
+        _table.clear();
+        std::vector<int> above{current};
+        std::vector<char> is_above(_persons.size(), 0);
+        for (std::size_t k = 0; k < above.size(); ++k) {
+            for (int next : upper[std::size_t(above[k])]) {
+                if (is_above[std::size_t(next)]) {
+                    continue;
+                }
+                is_above[std::size_t(next)] = 1;
+                above.push_back(next);
+                if (node.routes[std::size_t(next)]) {
+                    _table.add_trajectory(
+                        next, node.routes[std::size_t(next)]->trajectory);
+                }
+            }
+        }
+        auto& route = node.routes[std::size_t(current)];
+        if (current != agent) {
+            auto search = make_search();
+            SearchFootprint footprint;
+            if (search.find_conflict(route->trajectory, 0, footprint) < 0) {
+                continue;
+            }
+        }
+        auto new_route = plan_route(current);
+        if (!new_route) {
+            return false;
+        }
+        node.cost += new_route->cost - route->cost;
+        route = std::move(new_route);
+    }
+    return true;
+}
+
+std::shared_ptr<const PbsPlanner::Route> PbsPlanner::plan_route(int agent) {
+    auto search = make_search();
+    SearchFootprint footprint;
+    int expansions = 0;
+    bool cut = false;
+    auto actions = search.search_route(
+        _persons[std::size_t(agent)].get_position(), 0,
+        int(_budget->get_share(1)), nullptr, footprint, expansions, cut);
+    _budget->spend(expansions);
+    _stats["expansions"] += expansions;
+    ++_stats["searched_routes"];
+    if (!actions) {
+        return nullptr;
+    }
+    return std::make_shared<const Route>(
+        make_route(agent, std::move(*actions)));
+}
+
+SpaceTimeSearch PbsPlanner::make_search() const {
+    // A person that waits inside a reserved cell would collide with the same
+    // person above it after every replan
+    SpaceTimeOptions options;
+    options.forced_waits = false;
+    return SpaceTimeSearch(_field, _table, _stops, *_budget, options);
+}
+
+bool PbsPlanner::is_above(const Node& node, int agent, int other) const {
+    std::vector<int> below{agent};
+    std::vector<char> is_visited(_persons.size(), 0);
+    for (std::size_t k = 0; k < below.size(); ++k) {
+        for (int next : node.lower[std::size_t(below[k])]) {
+            if (next == other) {
+                return true;
+            }
+            if (!is_visited[std::size_t(next)]) {
+                is_visited[std::size_t(next)] = 1;
+                below.push_back(next);
+            }
+        }
+    }
+    return false;
+}
+
+std::vector<PbsPlanner::Collision> PbsPlanner::find_collisions(
+    const Routes& routes) const {
+    // Stays of all persons by cell, the ones standing where they are last
+    // the whole time
+    std::vector<std::tuple<int, int, int, int, int>> stays;
+    // Person arriving at and person leaving every cell by the tick of the
+    // arrival
+    FlatHashMap<TimePoint, int> arrivals;
+    FlatHashMap<TimePoint, int> departures;
+    for (std::size_t agent = 0; agent < routes.size(); ++agent) {
+        const auto& route = routes[agent];
+        auto position = _persons[agent].get_position();
+        if (!route) {
+            if (_field.get_distance(position) != 0) {
+                stays.emplace_back(position.get_x(), position.get_y(), 0,
+                                   FOREVER, int(agent));
+            }
+            continue;
+        }
+        for (std::size_t k = 0; k < route->stays.size(); ++k) {
+            const auto& stay = route->stays[k];
+            stays.emplace_back(stay.cell.get_x(), stay.cell.get_y(),
+                               stay.start, stay.end, int(agent));
+            if (k > 0) {
+                const auto& from = route->stays[k - 1].cell;
+                arrivals.insert(
+                    {stay.cell.get_x(), stay.cell.get_y(), stay.start},
+                    int(agent));
+                departures.insert({from.get_x(), from.get_y(), stay.start},
+                                  int(agent));
+            }
+        }
+    }
+    std::sort(stays.begin(), stays.end());
+
+    std::vector<Collision> collisions;
+    std::size_t first = 0;
+    for (std::size_t i = 0; i < stays.size(); ++i) {
+        auto [x, y, start, end, agent] = stays[i];
+        if (std::get<0>(stays[first]) != x || std::get<1>(stays[first]) != y) {
+            first = i;
+        }
+        for (std::size_t j = first; j < i; ++j) {
+            if (std::get<3>(stays[j]) >= start) {
+                collisions.push_back({std::get<4>(stays[j]), agent, start});
+            }
+        }
+    }
+    // A person swapping cells with another one arrives where the other one
+    // left at the same tick
+    for (std::size_t agent = 0; agent < routes.size(); ++agent) {
+        if (!routes[agent]) {
+            continue;
+        }
+        const auto& route_stays = routes[agent]->stays;
+        for (std::size_t k = 1; k < route_stays.size(); ++k) {
+            const auto& from = route_stays[k - 1].cell;
+            const auto& to = route_stays[k].cell;
+            int time = route_stays[k].start;
+            const int* arriving =
+                arrivals.find({from.get_x(), from.get_y(), time});
+            const int* leaving =
+                departures.find({to.get_x(), to.get_y(), time});
+            if (arriving && leaving && *arriving == *leaving &&
+                *arriving > int(agent)) {
+                collisions.push_back({int(agent), *arriving, time});
+            }
+        }
+    }
+    return collisions;
+}
+
+PbsPlanner::Routes PbsPlanner::drop_colliding(Routes routes) const {
+    // Every round drops a route or ends, two persons without routes that
+    // collide stand where they are and nothing can be dropped
+    for (bool has_dropped = true; has_dropped;) {
+        has_dropped = false;
+        for (const auto& collision : find_collisions(routes)) {
+            // Of a standing and a moving person the moving one gives way
+            auto dropped = std::size_t(collision.second);
+            if (!routes[dropped]) {
+                dropped = std::size_t(collision.first);
+            }
+            if (routes[dropped]) {
+                routes[dropped] = nullptr;
+                has_dropped = true;
+            }
+        }
+    }
+    return routes;
+}
+
+PbsPlanner::Route PbsPlanner::make_route(int agent,
+                                         std::vector<Action> actions) const {
+    Route route{std::move(actions), {}, {}, 0};
+    Point position = _persons[std::size_t(agent)].get_position();
+    route.trajectory.push_back(position);
+    int start = 0;
+    for (auto action : route.actions) {
+        int cost = get_cost(action);
+        if (action != Action::WAIT) {
+            route.stays.push_back({position, start, route.cost + cost - 1});
+            position = position + action;
+            start = route.cost + cost;
+        }
+        route.cost += cost;
+        route.trajectory.push_back(position);
+    }
+    // The person leaves the map right after it arrives
+    route.stays.push_back({position, start, route.cost});
+    return route;
+}
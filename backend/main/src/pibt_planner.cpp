@@ -0,0 +1,243 @@
+#include "pibt_planner.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+namespace {
+// Persons ready at any tick of one round decide together. Actions take 2
+// or 3 ticks, so persons deciding one tick apart can still make way for
+// each other
+constexpr int ROUND_TICKS = 2;
+// Staying first, so it wins the ties
+constexpr std::array ACTIONS = {
+    Action::WAIT,
+    Action::UP,
+    Action::RIGHT_UP,
+    Action::LEFT_UP,
+    Action::DOWN,
+    Action::RIGHT_DOWN,
+    Action::LEFT_DOWN,
+    Action::RIGHT,
+    Action::LEFT,
+};
+// Simulated ticks after which the persons still on the way are given up
+constexpr int MAX_TIME = 50000;
+// Ticks without anybody coming closer to a goal than ever before after
+// which the persons still on the way are given up
+constexpr int MAX_STALLED_TICKS = 1024;
+}  // namespace
+
+PibtPlanner::PibtPlanner(const std::vector<Person>& persons,
+                         const std::vector<Goal>& goals, Grid* grid)
+    : Planner(persons, goals, grid),
+      _field(*grid, get_goal_positions()),
+      _lower_left(grid->get_lower_left()),
+      _width(std::max(0, grid->get_upper_right().get_x() -
+                             grid->get_lower_left().get_x() + 1)),
+      _height(std::max(0, grid->get_upper_right().get_y() -
+                              grid->get_lower_left().get_y() + 1)) {}
+
+std::vector<std::vector<Action>> PibtPlanner::plan_all_routes() {
+    std::size_t cells = std::size_t(_width) * std::size_t(_height);
+    _holders.assign(cells, -1);
+    _free_from.assign(cells, 0);
+    _routes.assign(_persons.size(), {});
+    _agents.clear();
+    _ready.clear();
+    _stats.clear();
+    _partial = false;
+    for (int i = 0; i < static_cast<int>(_persons.size()); ++i) {
+        auto position = _persons[std::size_t(i)].get_position();
+        int distance = _field.get_distance(position);
+        auto status = distance == 0 ? AgentStatus::ARRIVED
+                      : distance == DistanceField::UNREACHABLE
+                          ? AgentStatus::UNREACHABLE
+                          : AgentStatus::MOVING;
+        // Only the persons on the way are ever ready to decide
+        int ready_time = status == AgentStatus::MOVING ? 0 : -1;
+        _agents.push_back({status, position, ready_time, 0, -1, distance});
+        int cell = cell_id(position);
+        if (status == AgentStatus::MOVING) {
+            _ready[0].push_back(i);
+        }
+        // Persons at a goal are gone after the first tick, unreachable ones
+        // stand in the way forever
+        if (cell >= 0 && status == AgentStatus::ARRIVED) {
+            _free_from[std::size_t(cell)] = 1;
+        } else if (cell >= 0) {
+            _holders[std::size_t(cell)] = i;
+        }
+    }
+
+    int last_progress = 0;
+    while (!_ready.empty()) {
+        auto [round, deciding] = *_ready.begin();
+        _ready.erase(_ready.begin());
+        int time = round * ROUND_TICKS;
+        if (time >= MAX_TIME || time - last_progress > MAX_STALLED_TICKS) {
+            break;
+        }
+        if (_budget->is_exhausted()) {
+            _partial = true;
+            break;
+        }
+        std::sort(deciding.begin(), deciding.end(),
+                  [this](int lhs, int rhs) { return is_older(lhs, rhs); });
+        for (int agent_id : deciding) {
+            if (_agents[std::size_t(agent_id)].decided_round != round) {
+                decide(agent_id, round, -1, std::numeric_limits<int>::max());
+            }
+        }
+        // Every decision is one expansion
+        _budget->spend(static_cast<std::int64_t>(deciding.size()));
+        _stats["expansions"] += static_cast<std::int64_t>(deciding.size());
+        _stats["rounds"] = round;
+        for (int agent_id : deciding) {
+            auto& agent = _agents[std::size_t(agent_id)];
+            int distance = _field.get_distance(agent.position);
+            if (distance < agent.best_distance) {
+                agent.best_distance = distance;
+                last_progress = time;
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < _agents.size(); ++i) {
+        if (_agents[i].status == AgentStatus::MOVING) {
+            ++_stats["unfinished_routes"];
+        }
+        int cost = 0;
+        for (auto action : _routes[i]) {
+            cost += get_cost(action);
+            if (action == Action::WAIT) {
+                ++_stats["waits"];
+            }
+        }
+        _stats["makespan"] = std::max<std::int64_t>(_stats["makespan"], cost);
+    }
+    return std::move(_routes);
+}
+
+std::map<std::string, std::int64_t> PibtPlanner::get_stats() const {
+    return _stats;
+}
+
+bool PibtPlanner::is_older(int agent_id, int other_id) const {
+    // Ties go to the person farther from the goals, then to the first one
+    const auto& agent = _agents[std::size_t(agent_id)];
+    const auto& other = _agents[std::size_t(other_id)];
+    return std::make_tuple(-agent.age, -agent.best_distance, agent_id) <
+           std::make_tuple(-other.age, -other.best_distance, other_id);
+}
+
+bool PibtPlanner::decide(int agent_id, int round, int pusher, int deadline) {
+    auto& agent = _agents[std::size_t(agent_id)];
+    agent.decided_round = round;
+    const Point from = agent.position;
+    const int time = agent.ready_time;
+
+    // Cheapest way to a goal first, staying or free cells before taken ones
+    std::array<std::pair<int, Action>, ACTIONS.size()> candidates;
+    std::size_t count = 0;
+    for (auto action : ACTIONS) {
+        Point to = from + action;
+        if (action != Action::WAIT &&
+            (!_field.is_valid_move(from, to) ||
+             _field.get_distance(to) == DistanceField::UNREACHABLE)) {
+            continue;
+        }
+        int holder = _holders[std::size_t(cell_id(to))];
+        bool is_taken = holder >= 0 && holder != agent_id;
+        int way = get_cost(action) + _field.get_distance(to);
+        candidates[count++] = {2 * way + int(is_taken), action};
+    }
+    std::stable_sort(candidates.begin(),
+                     candidates.begin() + std::ptrdiff_t(count),
+                     [](const auto& lhs, const auto& rhs) {
+                         return lhs.first < rhs.first;
+                     });
+
+    for (std::size_t k = 0; k < count; ++k) {
+        auto action = candidates[k].second;
+        Point to = from + action;
+        if (to == from) {
+            // A person asked to step aside may not stay
+            if (pusher < 0) {
+                commit(agent_id, from);
+                return true;
+            }
+            continue;
+        }
+        int arrival = time + get_cost(action);
+        int id = cell_id(to);
+        if (arrival > deadline || arrival < _free_from[std::size_t(id)] ||
+            (pusher >= 0 && to == _agents[std::size_t(pusher)].position)) {
+            continue;
+        }
+        int holder = _holders[std::size_t(id)];
+        if (holder < 0) {
+            commit(agent_id, to);
+            return true;
+        }
+        // Only a person deciding in this round can make way
+        const auto& other = _agents[std::size_t(holder)];
+        if (other.status != AgentStatus::MOVING ||
+            other.ready_time / ROUND_TICKS != round ||
+            other.decided_round == round) {
+            continue;
+        }
+        if (other.ready_time + get_cost(Action::WAIT) <= arrival) {
+            // It has to be gone from the cell by the time this one arrives
+            if (decide(holder, round, agent_id, arrival)) {
+                commit(agent_id, to);
+                return true;
+            }
+        } else if (pusher < 0 &&
+                   decide(holder, round, agent_id,
+                          std::numeric_limits<int>::max())) {
+            // It decides a tick later and can not be gone in time, so this
+            // one waits and takes the cell in the next round
+            commit(agent_id, from);
+            return true;
+        }
+    }
+    commit(agent_id, from);
+    return false;
+}
+
+void PibtPlanner::commit(int agent_id, const Point& to) {
+    auto& agent = _agents[std::size_t(agent_id)];
+    auto action = agent.position.to_another(to);
+    agent.ready_time += get_cost(action);
+    ++agent.age;
+    _routes[std::size_t(agent_id)].push_back(action);
+    if (to != agent.position) {
+        auto from = std::size_t(cell_id(agent.position));
+        _holders[from] = -1;
+        _free_from[from] = std::max(_free_from[from], agent.ready_time);
+        _holders[std::size_t(cell_id(to))] = agent_id;
+        agent.position = to;
+    }
+    if (_field.get_distance(to) == 0) {
+        // The person leaves the map right after it arrives
+        agent.status = AgentStatus::ARRIVED;
+        auto cell = std::size_t(cell_id(to));
+        _holders[cell] = -1;
+        _free_from[cell] = std::max(_free_from[cell], agent.ready_time + 1);
+        return;
+    }
+    _ready[agent.ready_time / ROUND_TICKS].push_back(agent_id);
+}
+
+int PibtPlanner::cell_id(const Point& cell) const noexcept {
+    int local_x = cell.get_x() - _lower_left.get_x();
+    int local_y = cell.get_y() - _lower_left.get_y();
+    if (local_x < 0 || local_y < 0 || local_x >= _width ||
+        local_y >= _height) {
+        return -1;
+    }
+    return local_y * _width + local_x;
+}
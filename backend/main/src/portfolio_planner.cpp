@@ -0,0 +1,120 @@
+#include "portfolio_planner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#include "actions.h"
+#include "distance_field.h"
+
+PortfolioPlanner::PortfolioPlanner(const std::vector<Person>& persons,
+                                   const std::vector<Goal>& goals, Grid* grid,
+                                   PortfolioOptions options)
+    : Planner(persons, goals, grid),
+      _options(options),
+      _goal_list(goals) {
+    _options.runs = std::max(1u, _options.runs);
+    if (_options.threads == 0) {
+        _options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+std::vector<std::vector<Action>> PortfolioPlanner::plan_all_routes() {
+    // Nobody can do better than leaving only the unreachable persons behind
+    // and bringing the farthest one in by its static distance
+    DistanceField field(*_grid, get_goal_positions());
+    int min_failed = 0;
+    int min_makespan = 0;
+    for (const auto& person : _persons) {
+        int distance = field.get_distance(person.get_position());
+        if (distance == DistanceField::UNREACHABLE) {
+            ++min_failed;
+        } else {
+            min_makespan = std::max(min_makespan, distance);
+        }
+    }
+
+    std::vector<RunResult> results(_options.runs);
+    std::vector<std::stop_source> stops(_options.runs);
+    std::mutex mutex;
+    std::atomic<unsigned> next(0);
+    {
+        std::vector<std::jthread> workers;
+        unsigned workers_count = std::min(_options.runs, _options.threads);
+        for (unsigned i = 0; i < workers_count; ++i) {
+            workers.emplace_back([&, this] {
+                for (unsigned k = next++; k < _options.runs; k = next++) {
+                    auto result = run(k, stops[k].get_token());
+                    std::lock_guard lock(mutex);
+                    if (result.finished && !result.partial &&
+                        result.failed == min_failed &&
+                        result.makespan == min_makespan) {
+                        for (auto& stop : stops) {
+                            stop.request_stop();
+                        }
+                    }
+                    results[k] = std::move(result);
+                }
+            });
+        }
+    }
+
+    std::size_t best = 0;
+    for (std::size_t k = 1; k < results.size(); ++k) {
+        const auto& result = results[k];
+        if (!result.finished) {
+            continue;
+        }
+        const auto& best_result = results[best];
+        if (!best_result.finished ||
+            std::tie(result.partial, result.failed, result.makespan) <
+                std::tie(best_result.partial, best_result.failed,
+                         best_result.makespan)) {
+            best = k;
+        }
+    }
+
+    _partial = results[best].partial;
+    _stats = results[best].stats;
+    _stats["portfolio_runs"] = _options.runs;
+    _stats["portfolio_best_run"] = static_cast<std::int64_t>(best);
+    _stats["portfolio_finished_runs"] = std::count_if(
+        results.begin(), results.end(),
+        [](const RunResult& result) { return result.finished; });
+    _stats["makespan"] = results[best].makespan;
+    return std::move(results[best].routes);
+}
+
+std::map<std::string, std::int64_t> PortfolioPlanner::get_stats() const {
+    return _stats;
+}
+
+PortfolioPlanner::RunResult PortfolioPlanner::run(unsigned index,
+                                                  std::stop_token stop) const {
+    PrioritizedOptions options = _options.planner;
+    options.seed = index;
+    options.stop = std::move(stop);
+    PrioritizedPlanner planner(_persons, _goal_list, _grid, options);
+    planner.set_budget(_budget);
+
+    RunResult result;
+    result.routes = planner.plan_all_routes();
+    result.finished = !planner.is_cancelled();
+    result.partial = planner.is_partial();
+    result.stats = planner.get_stats();
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        const auto& route = result.routes[i];
+        if (route.empty() && !is_reached_goal(_persons[i].get_position())) {
+            ++result.failed;
+        }
+        int cost = 0;
+        for (auto action : route) {
+            cost += get_cost(action);
+        }
+        result.makespan = std::max(result.makespan, cost);
+    }
+    return result;
+}
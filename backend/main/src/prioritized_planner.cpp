@@ -1,22 +1,52 @@
 #include "prioritized_planner.h"
 
 #include <algorithm>
-#include <queue>
-#include <unordered_set>
+#include <atomic>
+#include <cstddef>
+#include <random>
+#include <thread>
+#include <utility>
 
-#include "catable.h"
-#include "timed_node.h"
+#include "flat_hash.h"
+
+namespace {
+// Delays in waits a follower tries before it is searched for
+constexpr int MAX_STAGGER_WAITS = 8;
+}  // namespace
 
 PrioritizedPlanner::PrioritizedPlanner(const std::vector<Person>& persons,
                                        const std::vector<Goal>& goals,
-                                       Grid* grid)
-    : Planner(persons, goals, grid) {}
+                                       Grid* grid, PrioritizedOptions options)
+    : Planner(persons, goals, grid),
+      _options(options),
+      ca_table(grid->get_lower_left(), grid->get_upper_right()) {
+    _field = std::make_shared<const DistanceField>(*_grid,
+                                                   get_goal_positions());
+}
+
+PrioritizedPlanner::PrioritizedPlanner(
+    const std::vector<Person>& persons, const std::vector<Goal>& goals,
+    Grid* grid, std::shared_ptr<const DistanceField> field,
+    PrioritizedOptions options)
+    : Planner(persons, goals, grid),
+      _options(options),
+      _field(std::move(field)),
+      ca_table(grid->get_lower_left(), grid->get_upper_right()) {}
 
 std::vector<int> PrioritizedPlanner::get_priorities_shortest_first() const {
-    std::vector<std::pair<int, int>> data;
+    // Relative spread of the distances in perturbed orders
+    const double ORDER_NOISE = 0.3;
+    std::mt19937 generator(_options.seed);
+    std::uniform_real_distribution<double> noise(1.0 - ORDER_NOISE,
+                                                 1.0 + ORDER_NOISE);
+    std::vector<std::pair<double, int>> data;
 
     for (int i = 0; i < static_cast<int>(_persons.size()); ++i) {
-        int distance = h(_persons[static_cast<std::size_t>(i)].get_position());
+        double distance =
+            h(_persons[static_cast<std::size_t>(i)].get_position());
+        if (_options.seed != 0) {
+            distance *= noise(generator);
+        }
         data.push_back({distance, i});
     }
 
@@ -31,132 +61,513 @@ std::vector<int> PrioritizedPlanner::get_priorities_shortest_first() const {
     return indices;
 }
 
+void PrioritizedPlanner::take_followers(std::vector<int>& indices) {
+    _followers.assign(_persons.size(), {});
+    _is_follower.assign(_persons.size(), 0);
+    FlatHashMap<Point, int> first_in_cell;
+    std::vector<int> firsts;
+    firsts.reserve(indices.size());
+    for (int agent_id : indices) {
+        auto position = _persons[std::size_t(agent_id)].get_position();
+        if (const int* first = first_in_cell.find(position)) {
+            _followers[std::size_t(*first)].push_back(agent_id);
+            _is_follower[std::size_t(agent_id)] = 1;
+            continue;
+        }
+        first_in_cell.insert(position, agent_id);
+        firsts.push_back(agent_id);
+    }
+    indices = std::move(firsts);
+}
+
 std::vector<std::vector<Action>> PrioritizedPlanner::plan_all_routes() {
     auto indices = get_priorities_shortest_first();
+    take_followers(indices);
     stops.clear();
-    std::vector<std::vector<Action>> results(_persons.size());
-    bool changed = true;
-    while (changed) {
-        ca_table = CATable();
-        fill(results.begin(), results.end(), std::vector<Action>());
-        for (int priority = 0; priority < static_cast<int>(_persons.size());
-             ++priority) {
-            int agent_id = indices[std::size_t(priority)];
-            auto route = calculate_route(_persons[std::size_t(agent_id)]);
-
-            if (route) {
-                results[std::size_t(agent_id)] = *route;
-
-                std::vector<Point> trajectory;
-                Point current = _persons[std::size_t(agent_id)].get_position();
-                trajectory.push_back(current);
-
-                for (const auto& action : *route) {
-                    current = current + action;
-                    trajectory.push_back(current);
-                }
+    ca_table.clear();
+    _stats.clear();
+    _cancelled = false;
+    _partial = false;
+    std::vector<AgentPlan> plans(_persons.size());
+    if (_options.previous_routes.empty()) {
+        plan_pass(indices, plans, nullptr);
+    } else {
+        FlatHashSet<Point> changed_area;
+        indices = keep_previous_routes(indices, plans, changed_area);
+        plan_pass(indices, plans, &changed_area);
+    }
 
-                ca_table.add_trajectory(agent_id, trajectory);
-            }
+    // Every new stop used to restart planning from scratch. A search that
+    // never came near a changed cell replays to the same route, so only
+    // such agents are replanned and the rest just reserve their old routes.
+    // The table keeps the routes before the first replanned agent.
+    for (auto new_stops = validate_results(plans);
+         !new_stops.empty() && !_cancelled && !_budget->is_exhausted();
+         new_stops = validate_results(plans)) {
+        FlatHashSet<Point> changed_area;
+        for (const auto& stop : new_stops) {
+            SearchFootprint::mark_changed(changed_area, stop);
         }
-        changed = validate_results(results);
+        plan_pass(indices, plans, &changed_area);
     }
 
+    std::vector<std::vector<Action>> results;
+    results.reserve(plans.size());
+    for (std::size_t i = 0; i < plans.size(); ++i) {
+        count_route(plans[i], _persons[i]);
+        results.push_back(std::move(plans[i].route));
+    }
     return results;
 }
 
-bool PrioritizedPlanner::validate_results(
-    std::vector<std::vector<Action>>&
-        results) {  // cppcheck-suppress constParameterReference
-    bool changed = false;
-    for (int agent_id = 0; agent_id < static_cast<int>(results.size());
-         ++agent_id) {
-        if (results[std::size_t(agent_id)].size() == 0) {
-            auto position = _persons[std::size_t(agent_id)].get_position();
-            if (stops.find(position) == stops.end()) {
-                stops.insert(position);  // cppcheck-suppress stlFindInsert
-                changed = true;
+std::map<std::string, std::int64_t> PrioritizedPlanner::get_stats() const {
+    return _stats;
+}
+
+bool PrioritizedPlanner::is_cancelled() const noexcept { return _cancelled; }
+
+void PrioritizedPlanner::count_route(const AgentPlan& plan,
+                                     const Person& person) {
+    int cost = 0;
+    for (auto action : plan.route) {
+        cost += get_cost(action);
+        if (action == Action::WAIT) {
+            ++_stats["waits"];
+        }
+    }
+    _stats["makespan"] = std::max<std::int64_t>(_stats["makespan"], cost);
+    if (plan.route.empty() && !is_reached_goal(person.get_position())) {
+        ++_stats["failed_routes"];
+        return;
+    }
+    switch (plan.stats.kind) {
+        case RouteKind::STATIC:
+            ++_stats["static_routes"];
+            break;
+        case RouteKind::REPAIRED:
+            ++_stats["repaired_routes"];
+            break;
+        case RouteKind::SEARCHED:
+            ++_stats["searched_routes"];
+            break;
+        case RouteKind::KEPT:
+            ++_stats["kept_routes"];
+            break;
+        case RouteKind::STAGGERED:
+            ++_stats["staggered_routes"];
+            break;
+    }
+}
+
+void PrioritizedPlanner::plan_pass(const std::vector<int>& indices,
+                                   std::vector<AgentPlan>& plans,
+                                   FlatHashSet<Point>* changed_area) {
+    auto needs_search = [this, &plans, changed_area](int agent_id) {
+        return changed_area == nullptr ||
+               is_affected(agent_id, plans, *changed_area);
+    };
+    std::size_t window = _options.window != 0
+                             ? std::size_t(_options.window)
+                             : 2 * std::size_t(_options.threads);
+    std::size_t position = 0;
+    if (changed_area != nullptr) {
+        // Agents before the first one to replan commit the same routes in
+        // the same order, so the table is rolled back to them
+        std::size_t kept = 0;
+        for (; position < indices.size() && !needs_search(indices[position]);
+             ++position) {
+            const auto& plan = plans[std::size_t(indices[position])];
+            if (!plan.trajectory.empty()) {
+                kept += 1 + plan.committed_followers;
             }
         }
+        ca_table.rollback(kept);
+    }
+    // The rest of the budget is shared evenly by the searches of the pass
+    std::int64_t searches_left = std::count_if(
+        indices.begin() + std::ptrdiff_t(position), indices.end(),
+        needs_search);
+    while (position < indices.size()) {
+        // Agents of the window are planned concurrently against the current
+        // table and committed in priority order. A speculative route is kept
+        // only if nothing committed after the snapshot is near its
+        // footprint, otherwise the agent is planned again, so the result is
+        // the same as with sequential planning.
+        std::vector<int> batch;
+        std::size_t end = position;
+        for (; end < indices.size() && batch.size() < window; ++end) {
+            if (needs_search(indices[end])) {
+                batch.push_back(indices[end]);
+            }
+        }
+        auto speculative = speculate(batch, searches_left);
+        std::size_t next_speculative = 0;
+        FlatHashSet<Point> committed_area;
+
+        for (; position < end; ++position) {
+            int agent_id = indices[position];
+            auto& plan = plans[std::size_t(agent_id)];
+            if (needs_search(agent_id)) {
+                // A speculative search given another share of the budget
+                // could end differently
+                int max_steps = int(_budget->get_share(searches_left--));
+                AgentPlan new_plan;
+                if (next_speculative < speculative.size() &&
+                    batch[next_speculative] == agent_id &&
+                    speculative[next_speculative].stats.max_steps ==
+                        max_steps &&
+                    !speculative[next_speculative].footprint.is_affected_by(
+                        committed_area)) {
+                    new_plan = std::move(speculative[next_speculative]);
+                } else {
+                    new_plan = plan_agent(agent_id, max_steps);
+                }
+                if (next_speculative < batch.size() &&
+                    batch[next_speculative] == agent_id) {
+                    ++next_speculative;
+                }
+                // A search cut by the stop looks like a failed one
+                if (_options.stop.stop_requested()) {
+                    _cancelled = true;
+                    return;
+                }
+                // Expansions of every pass are counted, the kinds of the
+                // final routes only. Discarded speculative searches are not
+                // charged, so the result does not depend on the threads.
+                _stats["expansions"] += new_plan.stats.expansions;
+                _budget->spend(new_plan.stats.expansions);
+                _partial = _partial || new_plan.stats.cut;
+                if (changed_area != nullptr &&
+                    new_plan.trajectory != plan.trajectory) {
+                    for (const auto& cell : plan.trajectory) {
+                        SearchFootprint::mark_changed(*changed_area, cell);
+                    }
+                    for (const auto& cell : new_plan.trajectory) {
+                        SearchFootprint::mark_changed(*changed_area, cell);
+                    }
+                }
+                plan = std::move(new_plan);
+            }
+            if (!plan.trajectory.empty()) {
+                ca_table.add_trajectory(agent_id, plan.trajectory);
+                if (!speculative.empty()) {
+                    for (const auto& cell : plan.trajectory) {
+                        SearchFootprint::mark_changed(committed_area, cell);
+                    }
+                }
+            }
+            commit_followers(agent_id, plans, changed_area,
+                             speculative.empty() ? nullptr : &committed_area);
+        }
     }
-    return changed;
 }
 
-std::optional<std::vector<Action>> PrioritizedPlanner::calculate_route(
-    const Person& person) const {
-    if (is_reached_goal(person.get_position())) {
-        return std::vector<Action>();
+void PrioritizedPlanner::commit_followers(int agent_id,
+                                          std::vector<AgentPlan>& plans,
+                                          FlatHashSet<Point>* changed_area,
+                                          FlatHashSet<Point>* committed_area) {
+    const auto& followers = _followers[std::size_t(agent_id)];
+    plans[std::size_t(agent_id)].committed_followers = 0;
+    auto search = make_search();
+    int previous = agent_id;
+    for (std::size_t k = 0; k < followers.size(); ++k) {
+        int follower = followers[k];
+        const auto& before = plans[std::size_t(previous)];
+        AgentPlan new_plan;
+        // The queue only moves up behind a person that leaves
+        if (!before.trajectory.empty()) {
+            std::size_t waits = std::size_t(
+                std::find_if(before.route.begin(), before.route.end(),
+                             [](Action action) {
+                                 return action != Action::WAIT;
+                             }) -
+                before.route.begin());
+            std::vector<Point> cells(
+                before.trajectory.begin() + std::ptrdiff_t(waits),
+                before.trajectory.end());
+            for (int delay = 1; delay <= MAX_STAGGER_WAITS; ++delay) {
+                if (search.find_conflict(
+                        cells,
+                        int(waits + std::size_t(delay)) *
+                            get_cost(Action::WAIT),
+                        new_plan.footprint) < 0) {
+                    new_plan.route.assign(waits + std::size_t(delay),
+                                          Action::WAIT);
+                    new_plan.route.insert(
+                        new_plan.route.end(),
+                        before.route.begin() + std::ptrdiff_t(waits),
+                        before.route.end());
+                    new_plan.stats.kind = RouteKind::STAGGERED;
+                    break;
+                }
+            }
+            new_plan.footprint.seal();
+            if (new_plan.route.empty()) {
+                new_plan = plan_agent(
+                    follower, int(_budget->get_share(
+                                  std::int64_t(followers.size() - k))));
+                _stats["expansions"] += new_plan.stats.expansions;
+                _budget->spend(new_plan.stats.expansions);
+                _partial = _partial || new_plan.stats.cut;
+            } else {
+                new_plan.trajectory = to_trajectory(
+                    _persons[std::size_t(follower)], new_plan.route);
+            }
+        }
+        auto& plan = plans[std::size_t(follower)];
+        if (changed_area != nullptr && new_plan.trajectory != plan.trajectory) {
+            for (const auto& cell : plan.trajectory) {
+                SearchFootprint::mark_changed(*changed_area, cell);
+            }
+            for (const auto& cell : new_plan.trajectory) {
+                SearchFootprint::mark_changed(*changed_area, cell);
+            }
+        }
+        plan = std::move(new_plan);
+        previous = follower;
+        if (plan.trajectory.empty()) {
+            continue;
+        }
+        ca_table.add_trajectory(follower, plan.trajectory);
+        ++plans[std::size_t(agent_id)].committed_followers;
+        if (committed_area != nullptr) {
+            for (const auto& cell : plan.trajectory) {
+                SearchFootprint::mark_changed(*committed_area, cell);
+            }
+        }
     }
+}
 
-    auto start_position = person.get_position();
+bool PrioritizedPlanner::is_affected(
+    int agent_id, const std::vector<AgentPlan>& plans,
+    const FlatHashSet<Point>& changed_area) const {
+    if (plans[std::size_t(agent_id)].footprint.is_affected_by(changed_area)) {
+        return true;
+    }
+    const auto& followers = _followers[std::size_t(agent_id)];
+    return std::any_of(followers.begin(), followers.end(),
+                       [&plans, &changed_area](int follower) {
+                           return plans[std::size_t(follower)]
+                               .footprint.is_affected_by(changed_area);
+                       });
+}
 
-    const int MAX_TIME = 50000;
+std::vector<PrioritizedPlanner::AgentPlan> PrioritizedPlanner::speculate(
+    const std::vector<int>& agents, std::int64_t searches_left) const {
+    std::vector<AgentPlan> plans;
+    if (_options.threads <= 1 || agents.size() <= 1) {
+        return plans;
+    }
+    plans.resize(agents.size());
+    // Shares as if the agents before did not spend anything
+    std::vector<int> shares;
+    for (std::size_t k = 0; k < agents.size(); ++k) {
+        shares.push_back(int(_budget->get_share(
+            searches_left - static_cast<std::int64_t>(k))));
+    }
+    std::atomic<std::size_t> next(0);
+    {
+        std::vector<std::jthread> workers;
+        std::size_t workers_count =
+            std::min(agents.size(), std::size_t(_options.threads));
+        for (std::size_t i = 0; i < workers_count; ++i) {
+            workers.emplace_back([this, &agents, &plans, &shares, &next] {
+                for (std::size_t k = next++; k < agents.size(); k = next++) {
+                    plans[k] = plan_agent(agents[k], shares[k]);
+                }
+            });
+        }
+    }
+    return plans;
+}
 
-    using NodeQueue =
-        std::priority_queue<std::shared_ptr<TimedNode>,
-                            std::vector<std::shared_ptr<TimedNode>>,
-                            TimedNode::Compare>;
-    NodeQueue open;
-    std::unordered_set<TimePoint, TimePointHash> visited;
-    std::vector<std::shared_ptr<TimedNode>> time_nodes;
+PrioritizedPlanner::AgentPlan PrioritizedPlanner::plan_agent(
+    int agent_id, int max_steps) const {
+    const auto& person = _persons[std::size_t(agent_id)];
+    AgentPlan plan;
+    plan.stats.max_steps = max_steps;
+    auto route = calculate_route(person, plan.footprint, plan.stats);
+    if (route) {
+        plan.trajectory = to_trajectory(person, *route);
+        plan.route = std::move(*route);
+    }
+    return plan;
+}
 
-    auto start_node = std::make_shared<TimedNode>(
-        start_position, 0, h(person.get_position()), 0, 0);
-    time_nodes.push_back(start_node);
-    open.push(start_node);
-    visited.insert({start_position.get_x(), start_position.get_y(), 0});
+std::vector<Point> PrioritizedPlanner::to_trajectory(
+    const Person& person, const std::vector<Action>& route) const {
+    std::vector<Point> trajectory;
+    trajectory.reserve(route.size() + 1);
+    Point current = person.get_position();
+    trajectory.push_back(current);
+    for (const auto& action : route) {
+        current = current + action;
+        trajectory.push_back(current);
+    }
+    return trajectory;
+}
 
-    int steps = 0;
-    while (!open.empty() && steps < MAX_TIME) {
-        auto current = open.top();
-        open.pop();
+std::vector<Point> PrioritizedPlanner::validate_results(
+    const std::vector<AgentPlan>& plans) {
+    std::vector<Point> new_stops;
+    for (int agent_id = 0; agent_id < static_cast<int>(plans.size());
+         ++agent_id) {
+        // A queue is held up by its first person only
+        if (plans[std::size_t(agent_id)].route.size() == 0 &&
+            !_is_follower[std::size_t(agent_id)]) {
+            auto position = _persons[std::size_t(agent_id)].get_position();
+            if (stops.insert(position)) {
+                new_stops.push_back(position);
+            }
+        }
+    }
+    return new_stops;
+}
 
-        if (stops.find(current->position) != stops.end()) {
+std::vector<int> PrioritizedPlanner::keep_previous_routes(
+    const std::vector<int>& indices, std::vector<AgentPlan>& plans,
+    FlatHashSet<Point>& changed_area) {
+    // A kept route replays like a search that expanded its own cells only,
+    // so the usual repair replans it when something changes next to it
+    auto search = make_search();
+    std::vector<int> kept;
+    std::vector<int> rest;
+    // Persons that never move are stops from the start, as the routes were
+    // planned around them
+    for (int agent_id : indices) {
+        auto position = _persons[std::size_t(agent_id)].get_position();
+        if (is_reached_goal(position) ||
+            _field->get_distance(position) == DistanceField::UNREACHABLE) {
+            plans[std::size_t(agent_id)].stats.kind = RouteKind::STATIC;
+            stops.insert(position);
+            kept.push_back(agent_id);
+        }
+    }
+    for (int agent_id : indices) {
+        const auto& person = _persons[std::size_t(agent_id)];
+        auto& plan = plans[std::size_t(agent_id)];
+        if (stops.contains(person.get_position())) {
             continue;
         }
-
-        if (is_reached_goal(current->position)) {
-            std::vector<Action> path;
-            auto node = current;
-            while (node->parent_index != -1) {
-                auto parent_node = time_nodes[std::size_t(node->parent_index)];
-                path.push_back(
-                    parent_node->position.to_another(node->position));
-                node = parent_node;
+        const std::vector<Action>* previous = nullptr;
+        if (std::size_t(agent_id) < _options.previous_routes.size() &&
+            _options.previous_routes[std::size_t(agent_id)]) {
+            previous = &*_options.previous_routes[std::size_t(agent_id)];
+        }
+        if (previous != nullptr && is_valid_route(person, *previous)) {
+            auto trajectory = to_trajectory(person, *previous);
+            if (search.find_conflict(trajectory, 0, plan.footprint) < 0) {
+                plan.footprint.seal();
+                ca_table.add_trajectory(agent_id, trajectory);
+                plan.route = *previous;
+                plan.trajectory = std::move(trajectory);
+                plan.stats.kind = RouteKind::KEPT;
+                commit_followers(agent_id, plans, nullptr, nullptr);
+                kept.push_back(agent_id);
+                continue;
             }
-            std::reverse(path.begin(), path.end());
-            return path;
+            plan.footprint = SearchFootprint();
+        }
+        plan.footprint.add(person.get_position());
+        SearchFootprint::mark_changed(changed_area, person.get_position());
+        rest.push_back(agent_id);
+    }
+    kept.insert(kept.end(), rest.begin(), rest.end());
+    return kept;
+}
+
+bool PrioritizedPlanner::is_valid_route(
+    const Person& person, const std::vector<Action>& route) const {
+    // The walls or the start may have moved since the route was planned
+    Point current = person.get_position();
+    for (auto action : route) {
+        Point next = current + action;
+        if (!_field->is_valid_move(current, next)) {
+            return false;
         }
+        current = next;
+    }
+    return _field->get_distance(current) == 0;
+}
 
-        auto neighbors =
-            ca_table.get_neighbors_timestep(current->position, current->time);
+std::optional<std::vector<Action>> PrioritizedPlanner::calculate_route(
+    const Person& person) const {
+    SearchFootprint footprint;
+    SearchStats stats;
+    stats.max_steps = int(_budget->get_share(1));
+    return calculate_route(person, footprint, stats);
+}
 
-        for (const auto& neighbor : neighbors) {
-            if (_grid->is_incorrect_move(
-                    Segment(current->position, neighbor))) {
-                continue;
-            }
+std::optional<std::vector<Action>> PrioritizedPlanner::calculate_route(
+    const Person& person, SearchFootprint& footprint,
+    SearchStats& stats) const {
+    if (is_reached_goal(person.get_position())) {
+        stats.kind = RouteKind::STATIC;
+        return std::vector<Action>();
+    }
 
-            int move_cost = current->position.get_move_cost(neighbor);
-            int new_g = current->g + move_cost;
-            int new_time = current->time + move_cost;
-            TimePoint new_tp = {neighbor.get_x(), neighbor.get_y(), new_time};
+    auto start_position = person.get_position();
+    if (_field->get_distance(start_position) == DistanceField::UNREACHABLE) {
+        footprint.add(start_position);
+        footprint.seal();
+        return std::nullopt;
+    }
 
-            if (visited.find(new_tp) != visited.end()) {
-                continue;
-            }
+    auto search = make_search();
+
+    if (_options.lazy) {
+        // Most persons never meet anybody: check the static route in one
+        // pass and search only around its first conflict
+        const std::size_t REPAIR_BACKTRACK = 2;
+        const int REPAIR_STEPS = 512;
 
-            int new_h = h(neighbor);
-            auto new_node = std::make_shared<TimedNode>(
-                neighbor, new_g, new_h, new_time, time_nodes.size(),
-                current->self_index);
-            time_nodes.push_back(new_node);
-            open.push(new_node);
-            visited.insert(new_tp);
+        auto cells = search.get_static_route(start_position);
+        int conflict = search.find_conflict(cells, 0, footprint);
+        std::vector<Action> prefix;
+        int time = 0;
+        std::size_t repair_start = cells.size() - 1;
+        if (conflict >= 0) {
+            repair_start = std::size_t(conflict) -
+                           std::min(std::size_t(conflict), REPAIR_BACKTRACK);
+        }
+        for (std::size_t i = 0; i < repair_start; ++i) {
+            prefix.push_back(cells[i].to_another(cells[i + 1]));
+            time += cells[i].get_move_cost(cells[i + 1]);
         }
+        if (conflict < 0) {
+            stats.kind = RouteKind::STATIC;
+            footprint.seal();
+            return prefix;
+        }
+
+        FlatHashSet<Point> rejoin_cells;
+        for (std::size_t i = std::size_t(conflict) + 1; i < cells.size(); ++i) {
+            rejoin_cells.insert(cells[i]);
+        }
+        auto detour = search.search_route(
+            cells[repair_start], time, std::min(REPAIR_STEPS, stats.max_steps),
+            &rejoin_cells, footprint, stats.expansions, stats.cut);
+        if (detour) {
+            stats.kind = RouteKind::REPAIRED;
+            prefix.insert(prefix.end(), detour->begin(), detour->end());
+            footprint.seal();
+            return prefix;
+        }
+    }
 
-        steps++;
+    stats.kind = RouteKind::SEARCHED;
+    int steps_left = std::max(0, stats.max_steps - stats.expansions);
+    auto route = search.search_route(start_position, 0, steps_left, nullptr,
+                                     footprint, stats.expansions, stats.cut);
+    if (!route && stats.expansions >= stats.max_steps &&
+        stats.max_steps < _budget->get_search_limit()) {
+        stats.cut = true;
     }
+    footprint.seal();
+    return route;
+}
 
-    return std::nullopt;
+SpaceTimeSearch PrioritizedPlanner::make_search() const {
+    return SpaceTimeSearch(*_field, ca_table, stops, *_budget,
+                           {_options.stop, _options.congestion});
 }
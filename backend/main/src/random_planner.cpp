@@ -1,6 +1,7 @@
 #include "random_planner.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <iterator>
 #include <numeric>
@@ -8,9 +9,11 @@
 #include <random>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "actions.h"
+#include "flat_hash.h"
 #include "point.h"
 
 RandomPlanner::RandomPlanner(const std::vector<Person>& persons,
@@ -21,9 +24,8 @@ std::vector<std::vector<Action>> RandomPlanner::plan_all_routes() {
     std::vector<std::vector<Action>> routes(_persons.size());
     std::vector<Point> current_positions;
     current_positions.reserve(_persons.size());
-    std::unordered_set<Point> busy_positions;
-    std::unordered_set<Point> next_busy_positions;
-    constexpr int MAX_ITERATION_NUMBER = 50000;
+    FlatHashSet<Point> busy_positions;
+    FlatHashSet<Point> next_busy_positions;
     std::unordered_set<int> moving_positions;
     std::unordered_map<int, int> next_time_to_move;
     for (int i = 0; i < static_cast<int>(_persons.size()); ++i) {
@@ -32,10 +34,17 @@ std::vector<std::vector<Action>> RandomPlanner::plan_all_routes() {
         current_positions.push_back(_persons[std::size_t(i)].get_position());
         busy_positions.insert(_persons[std::size_t(i)].get_position());
     }
-    for (int t = 0; t < MAX_ITERATION_NUMBER; ++t) {
+    _partial = false;
+    // The walk is one search and every tick of it is one expansion
+    for (int t = 0; t < _budget->get_search_limit(); ++t) {
         if (moving_positions.empty()) {
             break;
         }
+        if (_budget->is_exhausted()) {
+            _partial = true;
+            break;
+        }
+        _budget->spend(1);
         std::unordered_set<int> current_moving_positions = moving_positions;
         for (int ind : current_moving_positions) {
             if (next_time_to_move[ind] != t) {
@@ -70,7 +79,7 @@ std::vector<std::vector<Action>> RandomPlanner::plan_all_routes() {
                 moving_positions.erase(ind);
             }
         }
-        busy_positions = std::move(next_busy_positions);
+        std::swap(busy_positions, next_busy_positions);
         next_busy_positions.clear();
     }
     return routes;
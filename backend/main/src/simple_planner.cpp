@@ -1,9 +1,12 @@
 #include "simple_planner.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <map>
 #include <unordered_map>
 
+#include "flat_hash.h"
+
 SimplePlanner::SimplePlanner(const std::vector<Person>& persons,
                              const std::vector<Goal>& goals, Grid* grid)
     : Planner(persons, goals, grid) {}
@@ -11,7 +14,23 @@ SimplePlanner::SimplePlanner(const std::vector<Person>& persons,
 std::vector<std::vector<Action>> SimplePlanner::plan_all_routes() {
     std::vector<std::vector<Action>> routes;
     routes.reserve(_persons.size());
-    for (auto person : _persons) {
+    _partial = false;
+    // Routes ignore the other persons, so persons starting in one cell, as
+    // the members of a group, share the search of the first of them
+    FlatHashMap<Point, std::size_t> first_in_cell;
+    for (const auto& person : _persons) {
+        if (const auto* first = first_in_cell.find(person.get_position())) {
+            routes.push_back(routes[*first]);
+            continue;
+        }
+        // A search on the plain grid is cheap, so the budget is checked
+        // between persons only
+        if (_budget->is_exhausted()) {
+            _partial = true;
+            routes.push_back(std::vector<Action>{});
+            continue;
+        }
+        first_in_cell.insert(person.get_position(), routes.size());
         auto route = calculate_route(person);
         if (route) {
             routes.push_back(route.value());
@@ -37,7 +56,9 @@ std::optional<std::vector<Action>> SimplePlanner::calculate_route(
     point_to_iterator[start_position] = iterator;
     point_to_g[start_position] = 0;
     std::optional<Point> goal;
+    std::int64_t expansions = 0;
     while (!f_to_point.empty()) {
+        ++expansions;
         auto first_node = f_to_point.begin();
         Point current_position = first_node->second;
         f_to_point.erase(first_node);
@@ -65,6 +86,7 @@ std::optional<std::vector<Action>> SimplePlanner::calculate_route(
             }
         }
     }
+    _budget->spend(expansions);
     if (!goal || !previous_in_route.contains(*goal)) {
         return std::nullopt;
     }
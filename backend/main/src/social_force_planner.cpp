@@ -0,0 +1,463 @@
+#include "social_force_planner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <utility>
+
+namespace {
+// Lengths are in cells and times in ticks
+constexpr double RADIUS = 0.3;
+// Ticks a person takes to reach its preferred velocity
+constexpr double RELAXATION = 1.0;
+constexpr double PERSON_STRENGTH = 0.8;
+constexpr double PERSON_RANGE = 0.15;
+constexpr double WALL_STRENGTH = 2.0;
+constexpr double WALL_RANGE = 0.1;
+// Side of a bin, forces of anything farther are neglected
+constexpr double CUTOFF = 1.5;
+constexpr double MAX_SPEED_FACTOR = 1.5;
+// Ticks without anybody changing cell after which the crowd is stuck
+constexpr double STUCK_TICKS = 100;
+// Tiles per thread, so threads that finish early take more
+constexpr int TILES_PER_THREAD = 4;
+
+double cross(double ax, double ay, double bx, double by) noexcept {
+    return ax * by - ay * bx;
+}
+
+// The step from (x1, y1) to (x2, y2) crosses or touches the segment
+bool is_crossing(double x1, double y1, double x2, double y2, double wx1,
+                 double wy1, double wx2, double wy2) noexcept {
+    double d1 = cross(wx2 - wx1, wy2 - wy1, x1 - wx1, y1 - wy1);
+    double d2 = cross(wx2 - wx1, wy2 - wy1, x2 - wx1, y2 - wy1);
+    double d3 = cross(x2 - x1, y2 - y1, wx1 - x1, wy1 - y1);
+    double d4 = cross(x2 - x1, y2 - y1, wx2 - x1, wy2 - y1);
+    return d1 * d2 <= 0 && d3 * d4 <= 0;
+}
+
+// Threads kept for a whole run. Every call of run goes over the tiles of one
+// phase of a step with the calling thread taking part, so a step does not
+// start threads anew.
+class TilePool {
+ public:
+    TilePool(unsigned threads, int tiles)
+        : _tiles(tiles), _sync(std::ptrdiff_t(threads)) {
+        for (unsigned i = 1; i < threads; ++i) {
+            _workers.emplace_back([this] {
+                while (true) {
+                    _sync.arrive_and_wait();
+                    if (_work == nullptr) {
+                        return;
+                    }
+                    take_tiles();
+                    _sync.arrive_and_wait();
+                }
+            });
+        }
+    }
+    TilePool(const TilePool&) = delete;
+    TilePool& operator=(const TilePool&) = delete;
+
+    ~TilePool() {
+        // Wakes the workers without work, so they leave
+        _work = nullptr;
+        _sync.arrive_and_wait();
+    }
+
+    // Runs <work> for every tile and returns when all are done
+    void run(const std::function<void(int)>& work) {
+        _work = &work;
+        _next = 0;
+        _sync.arrive_and_wait();
+        take_tiles();
+        _sync.arrive_and_wait();
+    }
+
+ private:
+    void take_tiles() {
+        for (int tile = _next++; tile < _tiles; tile = _next++) {
+            (*_work)(tile);
+        }
+    }
+
+    int _tiles;
+    const std::function<void(int)>* _work = nullptr;
+    std::atomic<int> _next = 0;
+    std::barrier<> _sync;
+    // Joined before the rest is destroyed
+    std::vector<std::jthread> _workers;
+};
+}  // namespace
+
+SocialForcePlanner::SocialForcePlanner(const std::vector<Person>& persons,
+                                       const std::vector<Goal>& goals,
+                                       Grid* grid, SocialForceOptions options)
+    : Planner(persons, goals, grid),
+      _options(options),
+      _field(*grid, get_goal_positions()),
+      _min_x(grid->get_lower_left().get_x()),
+      _min_y(grid->get_lower_left().get_y()),
+      _max_x(grid->get_upper_right().get_x() + 1),
+      _max_y(grid->get_upper_right().get_y() + 1),
+      _bin_columns(std::max(1, int(std::ceil((_max_x - _min_x) / CUTOFF)))),
+      _bin_rows(std::max(1, int(std::ceil((_max_y - _min_y) / CUTOFF)))) {
+    if (_options.threads == 0) {
+        _options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // A border goes to every bin its box reaches with the cutoff around it,
+    // so the bin of a person lists every border pushing it
+    auto bin_count = std::size_t(_bin_columns) * std::size_t(_bin_rows);
+    std::vector<std::vector<int>> walls(bin_count);
+    const auto& borders = grid->get_borders();
+    for (std::size_t w = 0; w < borders.size(); ++w) {
+        const auto& first = borders[w].get_first();
+        const auto& second = borders[w].get_second();
+        _wall_x1.push_back(first.get_x());
+        _wall_y1.push_back(first.get_y());
+        _wall_x2.push_back(second.get_x());
+        _wall_y2.push_back(second.get_y());
+        int low = bin_of(std::min(first.get_x(), second.get_x()) - CUTOFF,
+                         std::min(first.get_y(), second.get_y()) - CUTOFF);
+        int high = bin_of(std::max(first.get_x(), second.get_x()) + CUTOFF,
+                          std::max(first.get_y(), second.get_y()) + CUTOFF);
+        for (int row = low / _bin_columns; row <= high / _bin_columns; ++row) {
+            for (int column = low % _bin_columns;
+                 column <= high % _bin_columns; ++column) {
+                walls[std::size_t(row * _bin_columns + column)].push_back(
+                    int(w));
+            }
+        }
+    }
+    _wall_starts.push_back(0);
+    for (const auto& bin : walls) {
+        _wall_indices.insert(_wall_indices.end(), bin.begin(), bin.end());
+        _wall_starts.push_back(int(_wall_indices.size()));
+    }
+}
+
+std::vector<std::vector<Action>> SocialForcePlanner::plan_all_routes() {
+    _stats.clear();
+    _partial = false;
+    std::vector<std::vector<Action>> routes(_persons.size());
+    // Cell of the last action of every person and the tick it ends
+    std::vector<Point> cells;
+    std::vector<double> ends(_persons.size(), 0);
+    Crowd crowd;
+    std::int64_t walking = 0;
+    for (std::size_t i = 0; i < _persons.size(); ++i) {
+        auto position = _persons[i].get_position();
+        cells.push_back(position);
+        int distance = _field.get_distance(position);
+        if (distance == 0) {
+            continue;
+        }
+        // Persons that can not reach a goal stand in the way forever. Cell
+        // (x, y) is the unit square above and right of the point (x, y), the
+        // same as for the borders of the grid, a person starts in its centre.
+        bool is_fixed = distance == DistanceField::UNREACHABLE;
+        crowd.x.push_back(position.get_x() + 0.5);
+        crowd.y.push_back(position.get_y() + 0.5);
+        crowd.agent.push_back(is_fixed ? -1 : int(i));
+        walking += is_fixed ? 0 : 1;
+    }
+    crowd.vx.assign(crowd.x.size(), 0);
+    crowd.vy.assign(crowd.x.size(), 0);
+    crowd.ax.assign(crowd.x.size(), 0);
+    crowd.ay.assign(crowd.x.size(), 0);
+
+    int tiles = std::min(_bin_rows, int(_options.threads) * TILES_PER_THREAD);
+    int rows_per_tile = (_bin_rows + tiles - 1) / tiles;
+    auto tile_rows = [this, rows_per_tile](int tile) {
+        return std::make_pair(tile * rows_per_tile,
+                              std::min(_bin_rows, (tile + 1) * rows_per_tile));
+    };
+    std::function<void(int)> forces = [&](int tile) {
+        auto [first_row, last_row] = tile_rows(tile);
+        compute_forces(crowd, first_row, last_row);
+    };
+    std::function<void(int)> moves = [&](int tile) {
+        auto [first_row, last_row] = tile_rows(tile);
+        move(crowd, first_row, last_row);
+    };
+    TilePool pool(_options.threads, tiles);
+
+    std::int64_t steps = 0;
+    double last_change = 0;
+    // Every step of the simulation is one expansion
+    while (walking > 0 && steps < _budget->get_search_limit()) {
+        if (_budget->is_exhausted()) {
+            _partial = true;
+            break;
+        }
+        _budget->spend(1);
+        sort_into_bins(crowd);
+        pool.run(forces);
+        pool.run(moves);
+        ++steps;
+
+        // A person moves to its cell when it changes, the move ending now;
+        // diagonals around a corner go by a straight cell
+        double now = double(steps) * _options.step;
+        std::size_t kept = 0;
+        for (std::size_t k = 0; k < crowd.x.size(); ++k) {
+            int agent = crowd.agent[k];
+            if (agent >= 0) {
+                auto index = std::size_t(agent);
+                Point& cell = cells[index];
+                Point target = cell_of(crowd.x[k], crowd.y[k]);
+                Point offset = target - cell;
+                std::vector<Point> path;
+                if (std::max(std::abs(offset.get_x()),
+                             std::abs(offset.get_y())) == 1) {
+                    Point by_x(target.get_x(), cell.get_y());
+                    Point by_y(cell.get_x(), target.get_y());
+                    if (_field.is_valid_move(cell, target)) {
+                        path = {target};
+                    } else if (_field.is_valid_move(cell, by_x) &&
+                               _field.is_valid_move(by_x, target)) {
+                        path = {by_x, target};
+                    } else if (_field.is_valid_move(cell, by_y) &&
+                               _field.is_valid_move(by_y, target)) {
+                        path = {by_y, target};
+                    }
+                }
+                int cost = 0;
+                Point from = cell;
+                for (const auto& next : path) {
+                    cost += from.get_move_cost(next);
+                    from = next;
+                }
+                while (!path.empty() &&
+                       ends[index] + get_cost(Action::WAIT) <= now - cost) {
+                    routes[index].push_back(Action::WAIT);
+                    ends[index] += get_cost(Action::WAIT);
+                }
+                for (const auto& next : path) {
+                    auto action = cell.to_another(next);
+                    routes[index].push_back(action);
+                    ends[index] += get_cost(action);
+                    cell = next;
+                    last_change = now;
+                }
+                if (_field.get_distance(cell) == 0) {
+                    --walking;
+                    continue;
+                }
+            }
+            crowd.x[kept] = crowd.x[k];
+            crowd.y[kept] = crowd.y[k];
+            crowd.vx[kept] = crowd.vx[k];
+            crowd.vy[kept] = crowd.vy[k];
+            crowd.agent[kept] = crowd.agent[k];
+            ++kept;
+        }
+        for (auto* values :
+             {&crowd.x, &crowd.y, &crowd.vx, &crowd.vy, &crowd.ax, &crowd.ay}) {
+            values->resize(kept);
+        }
+        crowd.agent.resize(kept);
+        if (now - last_change >= STUCK_TICKS) {
+            // Nobody gets anywhere any more, the rest stay where they are
+            break;
+        }
+    }
+
+    _stats["steps"] = steps;
+    _stats["unfinished_routes"] = walking;
+    for (const auto& route : routes) {
+        std::int64_t cost = 0;
+        for (auto action : route) {
+            cost += get_cost(action);
+            if (action == Action::WAIT) {
+                ++_stats["waits"];
+            }
+        }
+        _stats["makespan"] = std::max(_stats["makespan"], cost);
+    }
+    return routes;
+}
+
+std::map<std::string, std::int64_t> SocialForcePlanner::get_stats() const {
+    return _stats;
+}
+
+void SocialForcePlanner::sort_into_bins(Crowd& crowd) {
+    std::size_t count = crowd.x.size();
+    std::vector<int> bins(count);
+    _bin_starts.assign(std::size_t(_bin_columns) * std::size_t(_bin_rows) + 1,
+                       0);
+    for (std::size_t k = 0; k < count; ++k) {
+        bins[k] = bin_of(crowd.x[k], crowd.y[k]);
+        ++_bin_starts[std::size_t(bins[k]) + 1];
+    }
+    for (std::size_t b = 1; b < _bin_starts.size(); ++b) {
+        _bin_starts[b] += _bin_starts[b - 1];
+    }
+    auto fill = _bin_starts;
+    Crowd sorted;
+    for (auto* values : {&sorted.x, &sorted.y, &sorted.vx, &sorted.vy,
+                         &sorted.ax, &sorted.ay}) {
+        values->resize(count);
+    }
+    sorted.agent.resize(count);
+    for (std::size_t k = 0; k < count; ++k) {
+        auto to = std::size_t(fill[std::size_t(bins[k])]++);
+        sorted.x[to] = crowd.x[k];
+        sorted.y[to] = crowd.y[k];
+        sorted.vx[to] = crowd.vx[k];
+        sorted.vy[to] = crowd.vy[k];
+        sorted.agent[to] = crowd.agent[k];
+    }
+    crowd = std::move(sorted);
+}
+
+void SocialForcePlanner::compute_forces(Crowd& crowd, int first_row,
+                                        int last_row) const {
+    for (int row = first_row; row < last_row; ++row) {
+        for (int column = 0; column < _bin_columns; ++column) {
+            auto bin = std::size_t(row * _bin_columns + column);
+            for (int k = _bin_starts[bin]; k < _bin_starts[bin + 1]; ++k) {
+                auto i = std::size_t(k);
+                crowd.ax[i] = 0;
+                crowd.ay[i] = 0;
+                if (crowd.agent[i] < 0) {
+                    continue;
+                }
+                double x = crowd.x[i];
+                double y = crowd.y[i];
+
+                // Toward the next cell of the cheapest route
+                Point cell = cell_of(x, y);
+                double ex = 0;
+                double ey = 0;
+                if (_field.get_distance(cell) != DistanceField::UNREACHABLE) {
+                    Point next = _field.get_next(cell).value_or(cell);
+                    ex = next.get_x() + 0.5 - x;
+                    ey = next.get_y() + 0.5 - y;
+                    double length = std::hypot(ex, ey);
+                    if (length > 0) {
+                        ex /= length;
+                        ey /= length;
+                    }
+                }
+                double ax =
+                    (_options.speed * ex - crowd.vx[i]) / RELAXATION;
+                double ay =
+                    (_options.speed * ey - crowd.vy[i]) / RELAXATION;
+
+                // Persons of the bins around, each bin is a contiguous range
+                for (int r = std::max(0, row - 1);
+                     r <= std::min(_bin_rows - 1, row + 1); ++r) {
+                    for (int c = std::max(0, column - 1);
+                         c <= std::min(_bin_columns - 1, column + 1); ++c) {
+                        auto other = std::size_t(r * _bin_columns + c);
+                        auto begin = std::size_t(_bin_starts[other]);
+                        auto end = std::size_t(_bin_starts[other + 1]);
+                        for (std::size_t j = begin; j < end; ++j) {
+                            double dx = x - crowd.x[j];
+                            double dy = y - crowd.y[j];
+                            double distance = std::sqrt(dx * dx + dy * dy);
+                            if (distance < CUTOFF && distance > 1e-9) {
+                                double force =
+                                    PERSON_STRENGTH *
+                                    std::exp((2 * RADIUS - distance) /
+                                             PERSON_RANGE) /
+                                    distance;
+                                ax += force * dx;
+                                ay += force * dy;
+                            }
+                        }
+                    }
+                }
+
+                // Borders push from their nearest point
+                for (int w = _wall_starts[bin]; w < _wall_starts[bin + 1];
+                     ++w) {
+                    auto index = std::size_t(_wall_indices[std::size_t(w)]);
+                    double wx = _wall_x2[index] - _wall_x1[index];
+                    double wy = _wall_y2[index] - _wall_y1[index];
+                    double length2 = wx * wx + wy * wy;
+                    double t =
+                        length2 > 0
+                            ? std::clamp(((x - _wall_x1[index]) * wx +
+                                          (y - _wall_y1[index]) * wy) /
+                                             length2,
+                                         0.0, 1.0)
+                            : 0.0;
+                    double dx = x - (_wall_x1[index] + t * wx);
+                    double dy = y - (_wall_y1[index] + t * wy);
+                    double distance = std::sqrt(dx * dx + dy * dy);
+                    if (distance < CUTOFF && distance > 1e-9) {
+                        double force =
+                            WALL_STRENGTH *
+                            std::exp((RADIUS - distance) / WALL_RANGE) /
+                            distance;
+                        ax += force * dx;
+                        ay += force * dy;
+                    }
+                }
+                crowd.ax[i] = ax;
+                crowd.ay[i] = ay;
+            }
+        }
+    }
+}
+
+void SocialForcePlanner::move(Crowd& crowd, int first_row,
+                              int last_row) const {
+    const double max_speed = _options.speed * MAX_SPEED_FACTOR;
+    const double step = _options.step;
+    auto begin = std::size_t(_bin_starts[std::size_t(first_row * _bin_columns)]);
+    auto end = std::size_t(_bin_starts[std::size_t(last_row * _bin_columns)]);
+    for (std::size_t i = begin; i < end; ++i) {
+        if (crowd.agent[i] < 0) {
+            continue;
+        }
+        double vx = crowd.vx[i] + crowd.ax[i] * step;
+        double vy = crowd.vy[i] + crowd.ay[i] * step;
+        double speed = std::hypot(vx, vy);
+        if (speed > max_speed) {
+            vx *= max_speed / speed;
+            vy *= max_speed / speed;
+        }
+        double x = std::clamp(crowd.x[i] + vx * step, _min_x, _max_x);
+        double y = std::clamp(crowd.y[i] + vy * step, _min_y, _max_y);
+        // Borders are hard, a step through one is not taken
+        auto bin = std::size_t(bin_of(crowd.x[i], crowd.y[i]));
+        for (int w = _wall_starts[bin]; w < _wall_starts[bin + 1]; ++w) {
+            auto index = std::size_t(_wall_indices[std::size_t(w)]);
+            if (is_crossing(crowd.x[i], crowd.y[i], x, y, _wall_x1[index],
+                            _wall_y1[index], _wall_x2[index],
+                            _wall_y2[index])) {
+                x = crowd.x[i];
+                y = crowd.y[i];
+                vx = 0;
+                vy = 0;
+                break;
+            }
+        }
+        crowd.x[i] = x;
+        crowd.y[i] = y;
+        crowd.vx[i] = vx;
+        crowd.vy[i] = vy;
+    }
+}
+
+int SocialForcePlanner::bin_of(double x, double y) const noexcept {
+    int column = std::clamp(int((x - _min_x) / CUTOFF), 0, _bin_columns - 1);
+    int row = std::clamp(int((y - _min_y) / CUTOFF), 0, _bin_rows - 1);
+    return row * _bin_columns + column;
+}
+
+Point SocialForcePlanner::cell_of(double x, double y) const noexcept {
+    // A person pushed onto the upper or right edge of the map stays in the
+    // last cell
+    return Point(std::clamp(int(std::floor(x)), _grid->get_lower_left().get_x(),
+                            _grid->get_upper_right().get_x()),
+                 std::clamp(int(std::floor(y)), _grid->get_lower_left().get_y(),
+                            _grid->get_upper_right().get_y()));
+}
@@ -0,0 +1,203 @@
+#include "space_time_search.h"
+
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <utility>
+
+#include "catable.h"
+#include "timed_node.h"
+
+SpaceTimeSearch::SpaceTimeSearch(const DistanceField& field,
+                                 const IntervalCATable& table,
+                                 const FlatHashSet<Point>& stops,
+                                 const SearchBudget& budget,
+                                 SpaceTimeOptions options)
+    : _field(field),
+      _table(table),
+      _stops(stops),
+      _budget(budget),
+      _options(std::move(options)) {}
+
+std::optional<std::vector<Action>> SpaceTimeSearch::search_route(
+    const Point& start, int start_time, int max_steps,
+    const FlatHashSet<Point>* rejoin_cells, SearchFootprint& footprint,
+    int& expansions, bool& cut) const {
+    using NodeQueue =
+        std::priority_queue<std::shared_ptr<TimedNode>,
+                            std::vector<std::shared_ptr<TimedNode>>,
+                            TimedNode::Compare>;
+    NodeQueue open;
+    FlatHashSet<TimePoint> visited;
+    FlatHashMap<Point, int> horizons;
+    std::vector<std::shared_ptr<TimedNode>> time_nodes;
+
+    auto start_node = std::make_shared<TimedNode>(
+        start, 0, _field.get_distance(start), start_time, 0);
+    time_nodes.push_back(start_node);
+    open.push(start_node);
+    visited.insert({start.get_x(), start.get_y(), start_time});
+
+    // The stop and the deadline are polled once per this many expansions
+    const int STOP_CHECK_PERIOD = 256;
+    int steps = 0;
+    while (!open.empty() && steps < max_steps) {
+        if (steps % STOP_CHECK_PERIOD == 0 &&
+            (_options.stop.stop_requested() || _budget.is_expired())) {
+            cut = true;
+            break;
+        }
+        auto current = open.top();
+        open.pop();
+        footprint.add(current->position);
+
+        if (_stops.contains(current->position)) {
+            continue;
+        }
+
+        // Nothing is reserved on the static route after this tick, so the
+        // node already costs exactly f and the rest needs no space-time
+        // search. A repair also ends as soon as the static route from the
+        // node is free again.
+        if (_field.get_distance(current->position) == 0 ||
+            is_past_horizon(current->position, current->time, horizons,
+                            footprint) ||
+            (rejoin_cells != nullptr &&
+             rejoin_cells->contains(current->position) &&
+             find_conflict(get_static_route(current->position),
+                           current->time, footprint) < 0)) {
+            std::vector<Action> path;
+            auto node = current;
+            while (node->parent_index != -1) {
+                auto parent_node = time_nodes[std::size_t(node->parent_index)];
+                path.push_back(
+                    parent_node->position.to_another(node->position));
+                node = parent_node;
+            }
+            std::reverse(path.begin(), path.end());
+            auto position = current->position;
+            for (auto next = _field.get_next(position); next.has_value();
+                 next = _field.get_next(position)) {
+                path.push_back(position.to_another(*next));
+                position = *next;
+            }
+            expansions += steps;
+            return path;
+        }
+
+        auto neighbors =
+            _table.get_neighbors_timestep(current->position, current->time);
+        if (!_options.forced_waits && neighbors.size() == 1 &&
+            !_table.check_move(current->position, neighbors[0],
+                               current->time)) {
+            steps++;
+            continue;
+        }
+
+        for (const auto& neighbor : neighbors) {
+            if (!_field.is_valid_move(current->position, neighbor)) {
+                continue;
+            }
+            int new_h = _field.get_distance(neighbor);
+            if (new_h == DistanceField::UNREACHABLE) {
+                continue;
+            }
+
+            int move_cost = current->position.get_move_cost(neighbor);
+            int new_g = current->g + move_cost;
+            int new_time = current->time + move_cost;
+            TimePoint new_tp = {neighbor.get_x(), neighbor.get_y(), new_time};
+
+            if (visited.contains(new_tp)) {
+                continue;
+            }
+
+            auto new_node = std::make_shared<TimedNode>(
+                neighbor, new_g, new_h, new_time, time_nodes.size(),
+                current->self_index);
+            if (_options.congestion) {
+                // Committed routes crowd the same corridors, so of equal
+                // nodes the one that met less traffic is expanded first. It
+                // waits less, and so do the searches after it.
+                new_node->tie =
+                    current->tie + _table.get_reserved_ticks(neighbor);
+            }
+            time_nodes.push_back(new_node);
+            open.push(new_node);
+            visited.insert(new_tp);
+        }
+
+        steps++;
+    }
+
+    expansions += steps;
+    return std::nullopt;
+}
+
+std::vector<Point> SpaceTimeSearch::get_static_route(const Point& start) const {
+    std::vector<Point> cells{start};
+    for (auto next = _field.get_next(start); next.has_value();
+         next = _field.get_next(cells.back())) {
+        cells.push_back(*next);
+    }
+    return cells;
+}
+
+int SpaceTimeSearch::find_conflict(const std::vector<Point>& cells,
+                                   int start_time,
+                                   SearchFootprint& footprint) const {
+    footprint.add(cells[0]);
+    if (_stops.contains(cells[0])) {
+        return 0;
+    }
+    int time = start_time;
+    for (std::size_t i = 0; i + 1 < cells.size(); ++i) {
+        footprint.add(cells[i + 1]);
+        if (_stops.contains(cells[i + 1]) ||
+            !_table.check_move(cells[i], cells[i + 1], time)) {
+            return static_cast<int>(i);
+        }
+        time += cells[i].get_move_cost(cells[i + 1]);
+    }
+    return -1;
+}
+
+bool SpaceTimeSearch::is_past_horizon(const Point& cell, int time,
+                                      FlatHashMap<Point, int>& horizons,
+                                      SearchFootprint& footprint) const {
+    if (_stops.empty() && time > _table.get_horizon()) {
+        // The static route is still read, so it belongs to the footprint
+        get_static_horizon(cell, horizons, footprint);
+        return true;
+    }
+    return time > get_static_horizon(cell, horizons, footprint);
+}
+
+int SpaceTimeSearch::get_static_horizon(const Point& cell,
+                                        FlatHashMap<Point, int>& horizons,
+                                        SearchFootprint& footprint) const {
+    // Last reserved tick over the static route from <cell>, UNREACHABLE if
+    // the route crosses a stop. Routes of neighbouring cells merge quickly,
+    // so the values are memoized for the whole search.
+    std::vector<Point> route;
+    int horizon = -1;
+    std::optional<Point> position = cell;
+    while (position.has_value()) {
+        if (const int* known = horizons.find(*position)) {
+            horizon = *known;
+            break;
+        }
+        route.push_back(*position);
+        footprint.add(*position);
+        position = _field.get_next(*position);
+    }
+    for (auto it = route.rbegin(); it != route.rend(); ++it) {
+        if (horizon != DistanceField::UNREACHABLE) {
+            horizon = _stops.contains(*it)
+                          ? DistanceField::UNREACHABLE
+                          : std::max(horizon, _table.last_visited(*it));
+        }
+        horizons.insert(*it, horizon);
+    }
+    return horizon;
+}
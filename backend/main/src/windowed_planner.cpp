@@ -0,0 +1,254 @@
+#include "windowed_planner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <tuple>
+#include <utility>
+
+#include "catable.h"
+
+namespace {
+// Simulated ticks after which the persons still on the way are given up
+constexpr int MAX_TIME = 50000;
+// Rounds without a new minimum of the remaining distance before planning
+// gives up on the persons who are still on the way
+constexpr int MAX_STALLED_ROUNDS = 32;
+// Every action started in the first half of the window has to end inside it
+constexpr int MIN_WINDOW = 2 * get_cost(Action::RIGHT_UP);
+
+// Trajectory of a person waiting at <cell> from <from_time> to at least
+// <until_time>
+std::vector<Point> stay_until(const Point& cell, int from_time,
+                              int until_time) {
+    int wait_count = std::max(0, until_time - from_time +
+                                     get_cost(Action::WAIT) - 1) /
+                     get_cost(Action::WAIT);
+    return std::vector<Point>(std::size_t(wait_count) + 1, cell);
+}
+
+struct WindowNode {
+    Point position;
+    int time;
+    int parent_index;
+};
+}  // namespace
+
+WindowedPlanner::WindowedPlanner(const std::vector<Person>& persons,
+                                 const std::vector<Goal>& goals, Grid* grid,
+                                 WindowedOptions options)
+    : Planner(persons, goals, grid),
+      _window(std::max(options.window, MIN_WINDOW)),
+      _field(*grid, get_goal_positions()),
+      _table(grid->get_lower_left(), grid->get_upper_right()) {}
+
+std::vector<std::vector<Action>> WindowedPlanner::plan_all_routes() {
+    std::vector<std::vector<Action>> routes(_persons.size());
+    _agents.clear();
+    for (const auto& person : _persons) {
+        auto position = person.get_position();
+        int distance = _field.get_distance(position);
+        auto status = distance == 0 ? AgentStatus::ARRIVED
+                      : distance == DistanceField::UNREACHABLE
+                          ? AgentStatus::UNREACHABLE
+                          : AgentStatus::MOVING;
+        _agents.push_back({status, position, position, 0, 0, -1});
+    }
+
+    _partial = false;
+    int half_window = _window / 2;
+    std::int64_t best_remaining = std::numeric_limits<std::int64_t>::max();
+    int stalled_rounds = 0;
+    for (int round = 0, round_start = 0; round_start < MAX_TIME;
+         ++round, round_start += half_window) {
+        auto order = get_round_order();
+        if (order.empty()) {
+            break;
+        }
+        _table.clear();
+        _parked.clear();
+        reserve_current_moves(round_start);
+
+        int commit_end = round_start + half_window;
+        int window_end = round_start + _window;
+        for (int agent_id : order) {
+            // Persons who do not plan in this round stay parked, so the
+            // routes so far never conflict
+            if (_budget->is_exhausted()) {
+                _partial = true;
+                break;
+            }
+            auto& agent = _agents[std::size_t(agent_id)];
+            agent.planned_round = round;
+            auto cells = plan_window(agent_id, round, commit_end, window_end);
+            _table.add_trajectory(agent_id, cells, agent.ready_time);
+
+            // Only the actions started before the next round are kept
+            auto& route = routes[std::size_t(agent_id)];
+            int time = agent.ready_time;
+            for (std::size_t i = 1; i < cells.size() && time < commit_end;
+                 ++i) {
+                route.push_back(cells[i - 1].to_another(cells[i]));
+                agent.previous = cells[i - 1];
+                agent.position = cells[i];
+                agent.move_start = time;
+                time += cells[i - 1].get_move_cost(cells[i]);
+                agent.ready_time = time;
+            }
+            if (_field.get_distance(agent.position) == 0) {
+                agent.status = AgentStatus::ARRIVED;
+                continue;
+            }
+            // The person stays where the kept part ends until it replans
+            _table.add_trajectory(
+                agent_id,
+                stay_until(agent.position, agent.ready_time, window_end),
+                agent.ready_time);
+        }
+        if (_partial) {
+            break;
+        }
+
+        std::int64_t remaining = 0;
+        for (const auto& agent : _agents) {
+            if (agent.status == AgentStatus::MOVING) {
+                remaining += _field.get_distance(agent.position);
+            }
+        }
+        if (remaining < best_remaining) {
+            best_remaining = remaining;
+            stalled_rounds = 0;
+        } else if (++stalled_rounds >= MAX_STALLED_ROUNDS) {
+            // Persons who are still on the way keep the part of the route
+            // they have walked, it never conflicts with the other routes
+            break;
+        }
+    }
+    return routes;
+}
+
+std::vector<Point> WindowedPlanner::plan_window(int agent_id, int round,
+                                                int commit_end,
+                                                int window_end) const {
+    const auto& agent = _agents[std::size_t(agent_id)];
+    // f, minus time to prefer deeper nodes on ties, node index
+    using QueueItem = std::tuple<int, int, int>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>,
+                        std::greater<QueueItem>>
+        open;
+    std::vector<WindowNode> nodes;
+    FlatHashSet<TimePoint> visited;
+
+    nodes.push_back({agent.position, agent.ready_time, -1});
+    open.emplace(agent.ready_time + _field.get_distance(agent.position),
+                 -agent.ready_time, 0);
+    visited.insert({agent.position.get_x(), agent.position.get_y(),
+                    agent.ready_time});
+
+    int terminal_index = -1;
+    std::int64_t expansions = 0;
+    while (!open.empty()) {
+        int index = std::get<2>(open.top());
+        open.pop();
+        ++expansions;
+        WindowNode current = nodes[std::size_t(index)];
+        // Beyond the window the static distance is the rest of the route
+        if (current.time >= window_end ||
+            _field.get_distance(current.position) == 0) {
+            terminal_index = index;
+            break;
+        }
+
+        auto candidates = current.position.get_neighbors();
+        candidates.push_back(current.position);
+        for (const auto& next : candidates) {
+            if (!_field.is_valid_move(current.position, next) ||
+                is_parked(next, agent_id, round)) {
+                continue;
+            }
+            int distance = _field.get_distance(next);
+            if (distance == DistanceField::UNREACHABLE ||
+                !_table.check_move(current.position, next, current.time)) {
+                continue;
+            }
+            int new_time = current.time + current.position.get_move_cost(next);
+            // The route is cut at the first point after <commit_end> and the
+            // person waits there until the next round, so nobody may come to
+            // that cell later
+            if (current.time < commit_end && new_time >= commit_end &&
+                _table.last_visited(next) >= new_time) {
+                continue;
+            }
+            if (!visited.insert({next.get_x(), next.get_y(), new_time})) {
+                continue;
+            }
+            nodes.push_back({next, new_time, index});
+            open.emplace(new_time + distance, -new_time,
+                         static_cast<int>(nodes.size()) - 1);
+        }
+    }
+
+    _budget->spend(expansions);
+    if (terminal_index == -1) {
+        // Waiting at the parked cell is always possible, so this is only a
+        // safety net
+        return stay_until(agent.position, agent.ready_time, window_end);
+    }
+    std::vector<Point> cells;
+    for (int index = terminal_index; index != -1;
+         index = nodes[std::size_t(index)].parent_index) {
+        cells.push_back(nodes[std::size_t(index)].position);
+    }
+    std::reverse(cells.begin(), cells.end());
+    return cells;
+}
+
+bool WindowedPlanner::is_parked(const Point& cell, int agent_id,
+                                int round) const {
+    const int* owner = _parked.find(cell);
+    return owner != nullptr && *owner != agent_id &&
+           _agents[std::size_t(*owner)].planned_round != round;
+}
+
+void WindowedPlanner::reserve_current_moves(int round_start) {
+    for (int agent_id = 0; agent_id < static_cast<int>(_agents.size());
+         ++agent_id) {
+        const auto& agent = _agents[std::size_t(agent_id)];
+        if (agent.status == AgentStatus::MOVING) {
+            _parked.insert(agent.position, agent_id);
+        } else if (agent.status == AgentStatus::UNREACHABLE) {
+            // Persons who can not reach any goal stand still forever
+            _parked.insert(agent.position, agent_id);
+            continue;
+        }
+        // Persons who arrived during the last action still finish it
+        if (agent.move_start < agent.ready_time &&
+            agent.ready_time > round_start) {
+            _table.add_trajectory(agent_id, {agent.previous, agent.position},
+                                  agent.move_start);
+        } else if (agent.status == AgentStatus::MOVING) {
+            _table.add_trajectory(agent_id, {agent.position},
+                                  agent.ready_time);
+        }
+    }
+}
+
+std::vector<int> WindowedPlanner::get_round_order() const {
+    std::vector<std::pair<int, int>> data;
+    for (int i = 0; i < static_cast<int>(_agents.size()); ++i) {
+        const auto& agent = _agents[std::size_t(i)];
+        if (agent.status == AgentStatus::MOVING) {
+            data.push_back({_field.get_distance(agent.position), i});
+        }
+    }
+    std::sort(data.begin(), data.end());
+
+    std::vector<int> order;
+    order.reserve(data.size());
+    for (const auto& [distance, agent_id] : data) {
+        order.push_back(agent_id);
+    }
+    return order;
+}
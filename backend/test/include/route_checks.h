@@ -0,0 +1,86 @@
+#ifndef ROUTE_CHECKS_H
+#define ROUTE_CHECKS_H
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "actions.h"
+#include "grid.h"
+#include "person.h"
+#include "point.h"
+#include "segment.h"
+
+// Checks of planned routes shared by the planner tests. They follow the
+// rules of the reservation tables: a person keeps its cell until its move
+// ends, two persons never share a cell at one tick and never swap cells.
+
+inline std::vector<Point> to_trajectory(const Person &person,
+                                        const std::vector<Action> &route) {
+    std::vector<Point> trajectory{person.get_position()};
+    for (auto action : route) {
+        trajectory.push_back(trajectory.back() + action);
+    }
+    return trajectory;
+}
+
+// Cell of the person at every tick until its final tick: an action from a
+// to b started at s with cost c keeps the person at a until s + c - 1
+inline std::vector<Point> to_timeline(const Person &person,
+                                      const std::vector<Action> &route) {
+    std::vector<Point> timeline{person.get_position()};
+    for (auto action : route) {
+        Point next = timeline.back() + action;
+        for (int i = 1; i < get_cost(action); ++i) {
+            timeline.push_back(timeline.back());
+        }
+        timeline.push_back(next);
+    }
+    return timeline;
+}
+
+inline void expect_no_conflicts(const std::vector<Person> &persons,
+                                const std::vector<std::vector<Action>> &routes,
+                                const Grid &grid) {
+    std::vector<std::vector<Point>> timelines;
+    std::map<std::tuple<int, int, int>, std::size_t> owners;
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        auto trajectory = to_trajectory(persons[i], routes[i]);
+        for (std::size_t k = 1; k < trajectory.size(); ++k) {
+            ASSERT_FALSE(grid.is_incorrect_move(
+                Segment(trajectory[k - 1], trajectory[k])));
+        }
+        timelines.push_back(to_timeline(persons[i], routes[i]));
+        for (std::size_t t = 0; t < timelines[i].size(); ++t) {
+            const auto &cell = timelines[i][t];
+            auto [it, inserted] =
+                owners.insert({{cell.get_x(), cell.get_y(), int(t)}, i});
+            ASSERT_TRUE(inserted) << "persons " << it->second << " and " << i
+                                  << " at tick " << t;
+        }
+    }
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        for (std::size_t t = 1; t < timelines[i].size(); ++t) {
+            const auto &from = timelines[i][t - 1];
+            const auto &to = timelines[i][t];
+            auto it = owners.find({to.get_x(), to.get_y(), int(t) - 1});
+            if (from == to || it == owners.end()) {
+                continue;
+            }
+            const auto &other = timelines[it->second];
+            ASSERT_FALSE(t < other.size() && other[t] == from)
+                << "persons " << i << " and " << it->second << " swap at tick "
+                << t;
+        }
+    }
+}
+
+inline Point final_position(const Person &person,
+                            const std::vector<Action> &route) {
+    return to_trajectory(person, route).back();
+}
+
+#endif  // ROUTE_CHECKS_H
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "concurrent_catable.h"
+#include "interval_catable.h"
+
+namespace {
+// Random walks that touch and overlap each other on a small board
+std::vector<std::vector<Point>> make_walks(int count) {
+    std::vector<std::vector<Point>> walks;
+    unsigned state = 777;
+    auto next_random = [&state](int bound) {
+        state = state * 1103515245u + 12345u;
+        return int((state >> 16) % unsigned(bound));
+    };
+    for (int i = 0; i < count; ++i) {
+        std::vector<Point> walk{Point{next_random(6), next_random(6)}};
+        for (int step = 0; step < 10; ++step) {
+            const auto &last = walk.back();
+            walk.push_back(Point{last.get_x() + next_random(3) - 1,
+                                 last.get_y() + next_random(3) - 1});
+        }
+        walks.push_back(walk);
+    }
+    return walks;
+}
+}  // namespace
+
+TEST(test_concurrent_catable, same_answers_as_interval_catable) {
+    ConcurrentCATable table(Point{-10, -10}, Point{10, 10}, 1);
+    IntervalCATable expected(Point{-10, -10}, Point{10, 10});
+    auto walks = make_walks(30);
+    for (std::size_t i = 0; i < walks.size(); ++i) {
+        table.add_trajectory(int(i), walks[i], int(i % 4));
+        expected.add_trajectory(int(i), walks[i], int(i % 4));
+    }
+    ASSERT_EQ(table.get_epoch(), walks.size());
+    ASSERT_EQ(table.get_horizon(), expected.get_horizon());
+    for (int x = -2; x < 8; ++x) {
+        for (int y = -2; y < 8; ++y) {
+            Point cell{x, y};
+            ASSERT_EQ(table.last_visited(cell), expected.last_visited(cell));
+            for (int time = 0; time < 30; ++time) {
+                ASSERT_EQ(table.get_neighbors_timestep(cell, time),
+                          expected.get_neighbors_timestep(cell, time));
+            }
+        }
+    }
+
+    table.clear();
+    ASSERT_EQ(table.last_visited(Point{1, 1}), -1);
+    ASSERT_EQ(table.get_horizon(), -1);
+}
+
+TEST(test_concurrent_catable, readers_run_while_writers_commit) {
+    // Two writers reserve [4r, 4r + 2] on every cell of their half in round
+    // r while readers keep scanning the board. A reader never sees a torn
+    // array and never sees a cell go back to an earlier round.
+    constexpr int SIDE = 8;
+    constexpr int ROUNDS = 200;
+    constexpr std::size_t READERS = 3;
+    ConcurrentCATable table(Point{0, 0}, Point{SIDE - 1, SIDE - 1}, READERS);
+    std::atomic<int> writers_left(2);
+    std::atomic<std::size_t> readers_started(0);
+    std::atomic<int> bad_reads(0);
+    {
+        std::vector<std::jthread> threads;
+        for (int writer = 0; writer < 2; ++writer) {
+            threads.emplace_back([&, writer] {
+                while (readers_started.load() < READERS) {
+                    std::this_thread::yield();
+                }
+                for (int round = 0; round < ROUNDS; ++round) {
+                    for (int y = writer; y < SIDE; y += 2) {
+                        for (int x = 0; x < SIDE; ++x) {
+                            table.add_trajectory(0, {Point{x, y}, Point{x, y}},
+                                                 4 * round);
+                        }
+                    }
+                }
+                --writers_left;
+            });
+        }
+        for (std::size_t reader = 0; reader < READERS; ++reader) {
+            threads.emplace_back([&, reader] {
+                std::vector<int> seen(SIDE * SIDE, -1);
+                ++readers_started;
+                while (writers_left.load() > 0) {
+                    auto guard = table.pin(reader);
+                    for (int id = 0; id < SIDE * SIDE; ++id) {
+                        Point cell{id % SIDE, id / SIDE};
+                        int last = table.last_visited(cell);
+                        if (last < seen[std::size_t(id)] ||
+                            (last != -1 && last % 4 != 2)) {
+                            ++bad_reads;
+                        }
+                        seen[std::size_t(id)] = last;
+                        // A reserved tick stays reserved
+                        if (last >= 2 &&
+                            table.check_move(cell, cell, last - 1)) {
+                            ++bad_reads;
+                        }
+                    }
+                }
+            });
+        }
+    }
+    ASSERT_EQ(bad_reads.load(), 0);
+    ASSERT_EQ(table.get_epoch(), std::uint64_t(SIDE * SIDE * ROUNDS));
+    for (int id = 0; id < SIDE * SIDE; ++id) {
+        ASSERT_EQ(table.last_visited(Point{id % SIDE, id / SIDE}),
+                  4 * (ROUNDS - 1) + 2);
+    }
+}
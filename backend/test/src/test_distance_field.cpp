@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "distance_field.h"
+#include "grid.h"
+#include "point.h"
+
+TEST(test_distance_field, open_grid_is_octile_distance) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    DistanceField field(grid, {Point(5, 5)});
+    ASSERT_EQ(field.get_distance(Point(5, 5)), 0);
+    ASSERT_EQ(field.get_distance(Point(5, 7)), 4);
+    ASSERT_EQ(field.get_distance(Point(7, 8)), 8);
+    ASSERT_EQ(field.get_distance(Point(11, 5)), DistanceField::UNREACHABLE);
+}
+
+TEST(test_distance_field, without_diagonals_is_manhattan_distance) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    DistanceField field(grid, {Point(5, 5)}, false);
+    ASSERT_EQ(field.get_distance(Point(5, 7)), 4);
+    ASSERT_EQ(field.get_distance(Point(7, 8)), 10);
+    ASSERT_TRUE(field.is_valid_move(Point(7, 8), Point(6, 7)));
+}
+
+TEST(test_distance_field, nearest_of_several_goals) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    DistanceField field(grid, {Point(0, 0), Point(10, 0)});
+    ASSERT_EQ(field.get_distance(Point(9, 0)), 2);
+    ASSERT_EQ(field.get_distance(Point(1, 1)), 3);
+}
+
+TEST(test_distance_field, route_goes_around_wall) {
+    std::vector<Border> borders = {Border{Point{5, 0}, Point{5, 8}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    DistanceField field(grid, {Point(6, 0)});
+    ASSERT_FALSE(field.is_valid_move(Point(4, 0), Point(6, 0)));
+    ASSERT_FALSE(field.is_valid_move(Point(4, 0), Point(5, 0)));
+    ASSERT_TRUE(field.is_valid_move(Point(4, 9), Point(5, 9)));
+    ASSERT_GT(field.get_distance(Point(4, 0)), 16);
+
+    Point current(4, 0);
+    int steps = 0;
+    for (auto next = field.get_next(current); next.has_value();
+         next = field.get_next(current)) {
+        ASSERT_EQ(field.get_distance(*next) + current.get_move_cost(*next),
+                  field.get_distance(current));
+        current = *next;
+        ++steps;
+    }
+    ASSERT_EQ(current, Point(6, 0));
+    ASSERT_GT(steps, 0);
+}
+
+TEST(test_distance_field, closed_area_is_unreachable) {
+    std::vector<Border> borders = {
+        Border{Point{0, 0}, Point{0, 2}}, Border{Point{0, 0}, Point{2, 0}},
+        Border{Point{2, 2}, Point{0, 2}}, Border{Point{2, 2}, Point{2, 0}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    DistanceField field(grid, {Point(8, 8)});
+    ASSERT_EQ(field.get_distance(Point(1, 1)), DistanceField::UNREACHABLE);
+    ASSERT_FALSE(field.get_next(Point(1, 1)).has_value());
+    ASSERT_NE(field.get_distance(Point(3, 3)), DistanceField::UNREACHABLE);
+}
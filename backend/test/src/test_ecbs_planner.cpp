@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "actions.h"
+#include "ecbs_planner.h"
+#include "grid.h"
+#include "person.h"
+#include "point.h"
+#include "route_checks.h"
+#include "search_budget.h"
+
+TEST(test_ecbs_planner, single_person_takes_cheapest_route) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1))};
+    std::vector<Goal> goals{Goal(0, Point(4, 3))};
+
+    EcbsPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 1);
+    ASSERT_EQ(final_position(persons[0], routes[0]), Point(4, 3));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["sum_of_costs"], 8);
+    ASSERT_EQ(stats["lower_bound"], 8);
+    ASSERT_EQ(stats["bound_permille"], 1000);
+    ASSERT_EQ(stats["high_level_nodes"], 1);
+}
+
+TEST(test_ecbs_planner, reached_and_unreachable_persons_stay) {
+    std::vector<Border> borders = {
+        Border{Point{0, 0}, Point{0, 2}}, Border{Point{0, 0}, Point{2, 0}},
+        Border{Point{2, 2}, Point{0, 2}}, Border{Point{2, 2}, Point{2, 0}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(8, 8)),
+                                Person(2, Point(5, 8))};
+    std::vector<Goal> goals{Goal(0, Point(8, 8))};
+
+    EcbsPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 3);
+    ASSERT_TRUE(routes[0].empty());
+    ASSERT_TRUE(routes[1].empty());
+    ASSERT_EQ(final_position(persons[2], routes[2]), Point(8, 8));
+    ASSERT_EQ(planner.get_stats()["failed_routes"], 0);
+}
+
+TEST(test_ecbs_planner, collision_at_goal_is_resolved) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(5, 1))};
+    std::vector<Goal> goals{Goal(0, Point(3, 1))};
+
+    EcbsPlanner planner(persons, goals, &grid, EcbsOptions{1.0});
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    ASSERT_EQ(final_position(persons[0], routes[0]), Point(3, 1));
+    ASSERT_EQ(final_position(persons[1], routes[1]), Point(3, 1));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["sum_of_costs"], 10);
+    ASSERT_EQ(stats["bound_permille"], 1000);
+    ASSERT_GT(stats["high_level_nodes"], 1);
+}
+
+TEST(test_ecbs_planner, crowd_passes_narrow_gap_within_bound) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 12; ++i) {
+        persons.emplace_back(i, Point(3 + i % 4, 6 + i / 4 * 3));
+        goals.emplace_back(i, Point(14 + i % 4, 4 + i / 4 * 6));
+    }
+
+    EcbsPlanner planner(persons, goals, &grid, EcbsOptions{1.5});
+    auto routes = planner.plan_all_routes();
+    ASSERT_FALSE(planner.is_partial());
+    expect_no_conflicts(persons, routes, grid);
+    std::int64_t total = 0;
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_GT(final_position(persons[i], routes[i]).get_x(), 10)
+            << "person " << i;
+        for (auto action : routes[i]) {
+            total += get_cost(action);
+        }
+    }
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["sum_of_costs"], total);
+    ASSERT_LE(stats["bound_permille"], 1500);
+    ASSERT_LE(total * 2, stats["lower_bound"] * 3);
+}
+
+TEST(test_ecbs_planner, tighter_bound_never_costs_more) {
+    std::vector<Border> borders = {Border{Point{6, 0}, Point{6, 3}},
+                                   Border{Point{6, 5}, Point{6, 8}}};
+    Grid grid(borders, Point(0, 0), Point(12, 8));
+    std::vector<Person> persons;
+    for (int i = 0; i < 6; ++i) {
+        persons.emplace_back(i, Point(2 + i % 2, 2 + i / 2 * 2));
+    }
+    std::vector<Goal> goals{Goal(0, Point(10, 2)), Goal(1, Point(10, 6))};
+
+    EcbsPlanner optimal(persons, goals, &grid, EcbsOptions{1.0});
+    auto routes = optimal.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    EcbsPlanner bounded(persons, goals, &grid, EcbsOptions{2.0});
+    routes = bounded.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+
+    auto cost = optimal.get_stats()["sum_of_costs"];
+    ASSERT_GT(cost, 0);
+    ASSERT_EQ(optimal.get_stats()["bound_permille"], 1000);
+    ASSERT_LE(cost, bounded.get_stats()["sum_of_costs"]);
+    ASSERT_LE(bounded.get_stats()["sum_of_costs"], 2 * cost);
+}
+
+TEST(test_ecbs_planner, exhausted_budget_leaves_colliding_persons) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    for (std::int64_t expansions : {0, 500, 2000}) {
+        EcbsPlanner planner(persons, goals, &grid);
+        planner.set_budget(std::make_shared<SearchBudget>(
+            std::chrono::milliseconds(0), expansions));
+        auto routes = planner.plan_all_routes();
+        ASSERT_TRUE(planner.is_partial());
+        ASSERT_EQ(routes.size(), persons.size());
+        expect_no_conflicts(persons, routes, grid);
+        ASSERT_GT(planner.get_stats()["failed_routes"], 0);
+    }
+}
+
+TEST(test_ecbs_planner, persons_in_one_cell_finish) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(1, 1)),
+                                Person(2, Point(5, 1))};
+    std::vector<Goal> goals{Goal(0, Point(8, 8))};
+
+    EcbsPlanner planner(persons, goals, &grid);
+    planner.set_budget(std::make_shared<SearchBudget>(
+        std::chrono::milliseconds(300), SearchBudget::UNLIMITED));
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 3);
+    ASSERT_EQ(final_position(persons[2], routes[2]), Point(8, 8));
+    // The two can not both stand in their cell at the first tick
+    ASSERT_TRUE(routes[0].empty() || routes[1].empty());
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include <unordered_set>
+
+#include "catable.h"
+#include "flat_hash.h"
+#include "point.h"
+
+TEST(test_flat_hash, empty_set) {
+    FlatHashSet<Point> set;
+    ASSERT_TRUE(set.empty());
+    ASSERT_FALSE(set.contains(Point(0, 0)));
+}
+
+TEST(test_flat_hash, insert_reports_new_keys) {
+    FlatHashSet<Point> set;
+    ASSERT_TRUE(set.insert(Point(1, 2)));
+    ASSERT_FALSE(set.insert(Point(1, 2)));
+    ASSERT_TRUE(set.insert(Point(2, 1)));
+    ASSERT_EQ(set.size(), 2);
+    ASSERT_TRUE(set.contains(Point(2, 1)));
+    ASSERT_FALSE(set.contains(Point(-1, -2)));
+}
+
+TEST(test_flat_hash, negative_coordinates_are_distinct) {
+    FlatHashSet<TimePoint> set;
+    set.insert({-1, 0, 0});
+    ASSERT_FALSE(set.contains({0, -1, 0}));
+    ASSERT_FALSE(set.contains({-1, 0, 1}));
+    ASSERT_TRUE(set.contains({-1, 0, 0}));
+}
+
+TEST(test_flat_hash, far_cells_and_late_ticks_are_distinct) {
+    constexpr int FAR = MAX_KEY_COORDINATE;
+    constexpr int LATE = 1 << 22;
+    FlatHashSet<TimePoint> set;
+    set.insert({FAR, -FAR, LATE});
+    ASSERT_FALSE(set.contains({FAR, -FAR, 0}));
+    ASSERT_FALSE(set.contains({-1, -FAR, LATE}));
+    ASSERT_FALSE(set.contains({FAR, 1, LATE}));
+    ASSERT_TRUE(set.contains({FAR, -FAR, LATE}));
+    set.insert({0, 0, std::numeric_limits<int>::max()});
+    ASSERT_FALSE(set.contains({0, 1, 0}));
+    ASSERT_FALSE(set.contains({1, 0, 0}));
+}
+
+TEST(test_flat_hash, map_default_value_and_update) {
+    FlatHashMap<Point, int> map;
+    ASSERT_EQ(map.find(Point(3, 3)), nullptr);
+    map[Point(3, 3)] = std::max(5, map[Point(3, 3)]);
+    ASSERT_EQ(*map.find(Point(3, 3)), 5);
+    ASSERT_FALSE(map.insert(Point(3, 3), 7));
+    ASSERT_EQ(map[Point(3, 3)], 5);
+}
+
+TEST(test_flat_hash, clear_keeps_set_usable) {
+    FlatHashSet<Point> set;
+    for (int i = 0; i < 100; ++i) {
+        set.insert(Point(i, i));
+    }
+    set.clear();
+    ASSERT_TRUE(set.empty());
+    ASSERT_FALSE(set.contains(Point(5, 5)));
+    ASSERT_TRUE(set.insert(Point(5, 5)));
+}
+
+TEST(test_flat_hash, random_against_std) {
+    std::mt19937 generator(239);
+    std::uniform_int_distribution<int> coordinate(-300, 300);
+    std::uniform_int_distribution<int> time(0, 5000);
+    FlatHashSet<TimePoint> flat;
+    std::unordered_set<std::int64_t> reference;
+    auto key = [](int x, int y, int t) {
+        return (std::int64_t(x) * 1000 + y) * 10000 + t;
+    };
+    for (int i = 0; i < 20000; ++i) {
+        int x = coordinate(generator);
+        int y = coordinate(generator);
+        int t = time(generator);
+        ASSERT_EQ(flat.insert({x, y, t}),
+                  reference.insert(key(x, y, t)).second);
+    }
+    for (int i = 0; i < 20000; ++i) {
+        int x = coordinate(generator);
+        int y = coordinate(generator);
+        int t = time(generator);
+        ASSERT_EQ(flat.contains({x, y, t}), reference.contains(key(x, y, t)));
+    }
+    ASSERT_EQ(flat.size(), reference.size());
+}
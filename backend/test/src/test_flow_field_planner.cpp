@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "actions.h"
+#include "flow_field_planner.h"
+#include "grid.h"
+#include "person.h"
+#include "point.h"
+#include "route_checks.h"
+#include "search_budget.h"
+
+TEST(test_flow_field_planner, single_person_follows_field) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1))};
+    std::vector<Goal> goals{Goal(0, Point(4, 3))};
+
+    FlowFieldPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes[0].size(), 3);
+    ASSERT_EQ(final_position(persons[0], routes[0]), Point(4, 3));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["makespan"], 8);
+    ASSERT_EQ(stats["unfinished_routes"], 0);
+}
+
+TEST(test_flow_field_planner, persons_behind_each_other_reach_goal) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(2, 1))};
+    std::vector<Goal> goals{Goal(0, Point(5, 1))};
+
+    FlowFieldPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    ASSERT_EQ(final_position(persons[0], routes[0]), Point(5, 1));
+    ASSERT_EQ(final_position(persons[1], routes[1]), Point(5, 1));
+}
+
+TEST(test_flow_field_planner, reached_and_unreachable_persons_stay) {
+    std::vector<Border> borders = {
+        Border{Point{0, 0}, Point{0, 2}}, Border{Point{0, 0}, Point{2, 0}},
+        Border{Point{2, 2}, Point{0, 2}}, Border{Point{2, 2}, Point{2, 0}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(8, 8)),
+                                Person(2, Point(5, 8))};
+    std::vector<Goal> goals{Goal(0, Point(8, 8))};
+
+    FlowFieldPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_TRUE(routes[0].empty());
+    ASSERT_TRUE(routes[1].empty());
+    ASSERT_EQ(final_position(persons[2], routes[2]), Point(8, 8));
+    ASSERT_EQ(planner.get_stats()["unfinished_routes"], 0);
+}
+
+TEST(test_flow_field_planner, crowd_passes_narrow_gap) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    FlowFieldPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_FALSE(planner.is_partial());
+    expect_no_conflicts(persons, routes, grid);
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["unfinished_routes"], 0);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_GT(final_position(persons[i], routes[i]).get_x(), 10);
+    }
+}
+
+TEST(test_flow_field_planner, large_crowd_keeps_cells_apart) {
+    std::vector<Border> borders = {Border{Point{100, 0}, Point{100, 90}},
+                                   Border{Point{100, 110}, Point{100, 200}}};
+    Grid grid(borders, Point(0, 0), Point(200, 200));
+    std::vector<Person> persons;
+    for (int i = 0; i < 1000; ++i) {
+        persons.emplace_back(i, Point(10 + i % 50, 10 + i / 50 * 3));
+    }
+    std::vector<Goal> goals{Goal(0, Point(190, 100)), Goal(1, Point(190, 20))};
+
+    FlowFieldPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    // Cells are checked at the ticks every person decides
+    std::map<std::tuple<int, int, int>, std::size_t> owners;
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        auto timeline = to_timeline(persons[i], routes[i]);
+        for (std::size_t t = 0; t < timeline.size(); ++t) {
+            const auto &cell = timeline[t];
+            auto [it, inserted] =
+                owners.insert({{cell.get_x(), cell.get_y(), int(t)}, i});
+            ASSERT_TRUE(inserted) << "persons " << it->second << " and " << i
+                                  << " at tick " << t;
+        }
+    }
+    ASSERT_EQ(planner.get_stats()["unfinished_routes"], 0);
+}
+
+TEST(test_flow_field_planner, exhausted_budget_is_partial) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1))};
+    std::vector<Goal> goals{Goal(0, Point(15, 15))};
+
+    FlowFieldPlanner planner(persons, goals, &grid);
+    planner.set_budget(
+        std::make_shared<SearchBudget>(std::chrono::milliseconds(0), 3));
+    auto routes = planner.plan_all_routes();
+    ASSERT_TRUE(planner.is_partial());
+    // A diagonal move takes 3 ticks, the budget ends before the next one
+    ASSERT_EQ(routes[0].size(), 1);
+    ASSERT_EQ(planner.get_stats()["unfinished_routes"], 1);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "actions.h"
+#include "flow_planner.h"
+#include "grid.h"
+#include "person.h"
+#include "point.h"
+#include "route_checks.h"
+#include "search_budget.h"
+
+TEST(test_flow_planner, persons_take_one_goal_in_turn) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(3, 1)), Person(1, Point(5, 1)),
+                                Person(2, Point(4, 2))};
+    std::vector<Goal> goals{Goal(0, Point(4, 1))};
+
+    FlowPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_FALSE(planner.is_partial());
+    expect_no_conflicts(persons, routes, grid);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_EQ(final_position(persons[i], routes[i]), Point(4, 1));
+    }
+    // The goal takes one person per step
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["lower_bound"], 2);
+    ASSERT_EQ(stats["horizon"], 6);
+    ASSERT_EQ(stats["makespan"], 6);
+    ASSERT_EQ(stats["sum_of_costs"], 12);
+    ASSERT_EQ(stats["optimal"], 1);
+    ASSERT_EQ(stats["failed_routes"], 0);
+}
+
+TEST(test_flow_planner, followers_reach_goal_by_lower_bound) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(2, 1)),
+                                Person(2, Point(3, 1))};
+    std::vector<Goal> goals{Goal(0, Point(5, 1))};
+
+    FlowPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["horizon"], stats["lower_bound"]);
+    ASSERT_EQ(stats["makespan"], 8);
+    ASSERT_EQ(stats["networks"], 1);
+}
+
+TEST(test_flow_planner, persons_in_one_cell_queue) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(1, 1)),
+                                Person(2, Point(1, 1))};
+    std::vector<Goal> goals{Goal(0, Point(5, 1))};
+
+    FlowPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_FALSE(planner.is_partial());
+    // Every next person leaves the start one step after the one before
+    std::vector<int> costs;
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_EQ(final_position(persons[i], routes[i]), Point(5, 1));
+        int cost = 0;
+        for (auto action : routes[i]) {
+            cost += get_cost(action);
+        }
+        costs.push_back(cost);
+    }
+    std::sort(costs.begin(), costs.end());
+    ASSERT_EQ(costs, (std::vector<int>{8, 10, 12}));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["lower_bound"], 12);
+    ASSERT_EQ(stats["horizon"], 12);
+    ASSERT_EQ(stats["optimal"], 1);
+    ASSERT_EQ(stats["failed_routes"], 0);
+}
+
+TEST(test_flow_planner, reached_and_unreachable_persons_stay) {
+    std::vector<Border> borders = {
+        Border{Point{0, 0}, Point{0, 2}}, Border{Point{0, 0}, Point{2, 0}},
+        Border{Point{2, 2}, Point{0, 2}}, Border{Point{2, 2}, Point{2, 0}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(8, 8)),
+                                Person(2, Point(5, 8))};
+    std::vector<Goal> goals{Goal(0, Point(8, 8))};
+
+    FlowPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 3);
+    ASSERT_TRUE(routes[0].empty());
+    ASSERT_TRUE(routes[1].empty());
+    ASSERT_EQ(final_position(persons[2], routes[2]), Point(8, 8));
+    ASSERT_EQ(planner.get_stats()["sum_of_costs"], 6);
+}
+
+TEST(test_flow_planner, crowd_passes_narrow_gap) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    FlowPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_FALSE(planner.is_partial());
+    expect_no_conflicts(persons, routes, grid);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        auto position = final_position(persons[i], routes[i]);
+        ASSERT_GT(position.get_x(), 10) << "person " << i;
+    }
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["failed_routes"], 0);
+    ASSERT_EQ(stats["optimal"], 1);
+    ASSERT_EQ(stats["makespan"], stats["horizon"]);
+    // The gap takes a few persons per step only
+    ASSERT_GT(stats["horizon"], stats["lower_bound"]);
+}
+
+TEST(test_flow_planner, exhausted_budget_keeps_routes_consistent) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    for (std::int64_t expansions : {0, 2000, 20000}) {
+        FlowPlanner planner(persons, goals, &grid);
+        planner.set_budget(std::make_shared<SearchBudget>(
+            std::chrono::milliseconds(0), expansions));
+        auto routes = planner.plan_all_routes();
+        ASSERT_EQ(routes.size(), persons.size());
+        expect_no_conflicts(persons, routes, grid);
+        if (planner.is_partial()) {
+            ASSERT_GT(planner.get_stats()["failed_routes"], 0);
+        }
+    }
+}
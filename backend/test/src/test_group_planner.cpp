@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "actions.h"
+#include "grid.h"
+#include "group_planner.h"
+#include "person.h"
+#include "point.h"
+#include "route_checks.h"
+#include "search_budget.h"
+
+TEST(test_group_planner, group_moves_as_one_formation) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(30, 30));
+    std::vector<Person> persons;
+    for (int i = 0; i < 9; ++i) {
+        persons.emplace_back(i, Point(2 + i % 3, 2 + i / 3));
+    }
+    std::vector<Goal> goals{Goal(0, Point(25, 3))};
+    GroupOptions options;
+    options.groups = {{0, 1, 2, 3, 4, 5, 6, 7, 8}};
+
+    GroupPlanner planner(persons, goals, &grid, options);
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_EQ(final_position(persons[i], routes[i]), Point(25, 3));
+        // Every member starts with the moves of the formation
+        ASSERT_GE(routes[i].size(), 20u);
+        ASSERT_TRUE(std::equal(routes[i].begin(), routes[i].begin() + 20,
+                               routes[5].begin()));
+    }
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["group_searches"], 1);
+    ASSERT_EQ(stats["member_searches"], 8);
+    ASSERT_EQ(stats["split_groups"], 0);
+    ASSERT_EQ(stats["failed_routes"], 0);
+    ASSERT_FALSE(planner.is_partial());
+}
+
+TEST(test_group_planner, members_in_one_cell_queue) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(30, 30));
+    std::vector<Person> persons{Person(0, Point(2, 2)), Person(1, Point(2, 2)),
+                                Person(2, Point(2, 2)), Person(3, Point(3, 2))};
+    std::vector<Goal> goals{Goal(0, Point(20, 2))};
+    GroupOptions options;
+    options.groups = {{0, 1, 2, 3}};
+
+    GroupPlanner planner(persons, goals, &grid, options);
+    auto routes = planner.plan_all_routes();
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_EQ(final_position(persons[i], routes[i]), Point(20, 2));
+    }
+    // The queue shares only its start cell, while it waits to leave
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        auto first = to_timeline(persons[i], routes[i]);
+        for (std::size_t j = i + 1; j < persons.size(); ++j) {
+            auto second = to_timeline(persons[j], routes[j]);
+            for (std::size_t t = 0; t < std::min(first.size(), second.size());
+                 ++t) {
+                ASSERT_TRUE(first[t] != second[t] || first[t] == Point(2, 2))
+                    << "persons " << i << " and " << j << " at tick " << t;
+            }
+        }
+    }
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["group_searches"], 1);
+    ASSERT_EQ(stats["staggered_routes"], 2);
+    ASSERT_EQ(stats["failed_routes"], 0);
+}
+
+TEST(test_group_planner, persons_without_group_move_alone) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(2, 1)),
+                                Person(2, Point(5, 5))};
+    std::vector<Goal> goals{Goal(0, Point(5, 1))};
+
+    GroupPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_EQ(final_position(persons[i], routes[i]), Point(5, 1));
+    }
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["group_searches"], 0);
+    ASSERT_EQ(stats["member_searches"], 3);
+}
+
+TEST(test_group_planner, wide_formation_splits_at_narrow_gap) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    for (int i = 0; i < 6; ++i) {
+        persons.emplace_back(i, Point(3 + i % 2, 8 + i / 2 * 2));
+    }
+    std::vector<Goal> goals{Goal(0, Point(16, 10))};
+    GroupOptions options;
+    options.groups = {{0, 1, 2, 3, 4, 5}};
+
+    GroupPlanner planner(persons, goals, &grid, options);
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_EQ(final_position(persons[i], routes[i]), Point(16, 10));
+    }
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["split_groups"], 1);
+    ASSERT_EQ(stats["failed_routes"], 0);
+}
+
+TEST(test_group_planner, groups_crossing_keep_clear) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    for (int i = 0; i < 4; ++i) {
+        persons.emplace_back(i, Point(1 + i % 2, 9 + i / 2));
+    }
+    for (int i = 0; i < 4; ++i) {
+        persons.emplace_back(4 + i, Point(9 + i % 2, 1 + i / 2));
+    }
+    std::vector<Goal> goals{Goal(0, Point(18, 10)), Goal(1, Point(10, 18))};
+    GroupOptions options;
+    options.groups = {{0, 1, 2, 3}, {4, 5, 6, 7}};
+
+    GroupPlanner planner(persons, goals, &grid, options);
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_FALSE(routes[i].empty());
+    }
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["group_searches"], 2);
+    ASSERT_EQ(stats["failed_routes"], 0);
+}
+
+TEST(test_group_planner, budget_cut_is_partial) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(30, 30));
+    std::vector<Person> persons;
+    for (int i = 0; i < 4; ++i) {
+        persons.emplace_back(i, Point(2 + i % 2, 2 + i / 2));
+    }
+    std::vector<Goal> goals{Goal(0, Point(28, 28))};
+    GroupOptions options;
+    options.groups = {{0, 1, 2, 3}};
+
+    GroupPlanner planner(persons, goals, &grid, options);
+    planner.set_budget(
+        std::make_shared<SearchBudget>(std::chrono::milliseconds(0), 5));
+    auto routes = planner.plan_all_routes();
+    ASSERT_TRUE(planner.is_partial());
+    expect_no_conflicts(persons, routes, grid);
+}
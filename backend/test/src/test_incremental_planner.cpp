@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "actions.h"
+#include "distance_field.h"
+#include "grid.h"
+#include "incremental_distance_field.h"
+#include "incremental_planner.h"
+#include "person.h"
+#include "point.h"
+#include "search_budget.h"
+#include "simple_planner.h"
+
+namespace {
+std::int64_t get_route_cost(const std::vector<Action> &route) {
+    std::int64_t cost = 0;
+    for (auto action : route) {
+        cost += get_cost(action);
+    }
+    return cost;
+}
+
+void expect_same_distances(IncrementalDistanceField &field, const Grid &grid,
+                           const std::vector<Point> &goals) {
+    std::vector<Point> cells;
+    for (int x = grid.get_lower_left().get_x();
+         x <= grid.get_upper_right().get_x(); ++x) {
+        for (int y = grid.get_lower_left().get_y();
+             y <= grid.get_upper_right().get_y(); ++y) {
+            cells.emplace_back(x, y);
+        }
+    }
+    SearchBudget budget;
+    ASSERT_TRUE(field.repair(cells, budget));
+    DistanceField expected(grid, goals);
+    for (const auto &cell : cells) {
+        ASSERT_TRUE(field.is_exact(cell));
+        ASSERT_EQ(field.get_distance(cell), expected.get_distance(cell))
+            << cell.get_x() << " " << cell.get_y();
+    }
+}
+
+void expect_simple_routes(const std::vector<Person> &persons,
+                          const std::vector<Goal> &goals, Grid &grid,
+                          const std::vector<std::vector<Action>> &routes) {
+    SimplePlanner simple(persons, goals, &grid);
+    auto expected = simple.plan_all_routes();
+    ASSERT_EQ(routes.size(), expected.size());
+    for (std::size_t i = 0; i < routes.size(); ++i) {
+        ASSERT_EQ(get_route_cost(routes[i]), get_route_cost(expected[i]));
+        Point cell = persons[i].get_position();
+        for (auto action : routes[i]) {
+            ASSERT_FALSE(grid.is_incorrect_move(Segment(cell, cell + action)));
+            cell = cell + action;
+        }
+        if (!routes[i].empty()) {
+            ASSERT_EQ(cell, goals[0].get_position());
+        }
+    }
+}
+}  // namespace
+
+TEST(test_incremental_planner, first_plan_is_simple_planner_routes) {
+    std::vector<Border> borders = {Border{Point{5, 0}, Point{5, 8}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons = {Person(1, Point(1, 1)),
+                                   Person(2, Point(9, 9)),
+                                   Person(3, Point(4, 0))};
+    std::vector<Goal> goals = {Goal(1, Point(7, 2))};
+    IncrementalPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    expect_simple_routes(persons, goals, grid, routes);
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["rebuilt"], 1);
+    ASSERT_EQ(stats["repaired_cells"], 0);
+    ASSERT_FALSE(planner.is_partial());
+}
+
+TEST(test_incremental_planner, border_edits_repair_only_part_of_field) {
+    auto field = std::make_shared<IncrementalDistanceField>();
+    std::vector<Person> persons = {Person(1, Point(2, 10)),
+                                   Person(2, Point(18, 18))};
+    std::vector<Goal> goals = {Goal(1, Point(17, 10))};
+    std::vector<Border> borders;
+    Grid open(borders, Point(0, 0), Point(20, 20));
+    IncrementalPlanner first(persons, goals, &open, field);
+    first.plan_all_routes();
+
+    borders = {Border{Point{10, 3}, Point{10, 17}}};
+    Grid walled(borders, Point(0, 0), Point(20, 20));
+    IncrementalPlanner second(persons, goals, &walled, field);
+    auto routes = second.plan_all_routes();
+    expect_simple_routes(persons, goals, walled, routes);
+    auto stats = second.get_stats();
+    ASSERT_EQ(stats["rebuilt"], 0);
+    ASSERT_EQ(stats["changed_borders"], 1);
+    ASSERT_GT(stats["changed_moves"], 0);
+    ASSERT_GT(stats["repaired_cells"], 0);
+    ASSERT_LT(stats["repaired_cells"], 21 * 21);
+
+    // Taking the wall away brings the old distances back
+    borders.clear();
+    Grid reopened(borders, Point(0, 0), Point(20, 20));
+    IncrementalPlanner third(persons, goals, &reopened, field);
+    routes = third.plan_all_routes();
+    expect_simple_routes(persons, goals, reopened, routes);
+    ASSERT_EQ(third.get_stats()["rebuilt"], 0);
+    expect_same_distances(*field, reopened, {Point(17, 10)});
+}
+
+TEST(test_incremental_planner, repaired_field_equals_fresh_field) {
+    IncrementalDistanceField field;
+    std::vector<Point> goals = {Point(0, 0), Point(14, 3)};
+    std::vector<std::vector<Border>> edits = {
+        {},
+        {Border{Point{3, 0}, Point{3, 12}}},
+        {Border{Point{3, 0}, Point{3, 12}}, Border{Point{3, 12}, Point{11, 12}}},
+        {Border{Point{12, 12}, Point{3, 12}}, Border{Point{0, 5}, Point{9, 14}}},
+        {Border{Point{0, 5}, Point{9, 14}}, Border{Point{12, 1}, Point{15, 1}},
+         Border{Point{12, 1}, Point{12, 5}}, Border{Point{12, 5}, Point{15, 5}}},
+        {Border{Point{12, 1}, Point{15, 1}}},
+    };
+    for (auto &borders : edits) {
+        Grid grid(borders, Point(0, 0), Point(15, 15));
+        field.update(grid, goals);
+        expect_same_distances(field, grid, goals);
+    }
+}
+
+TEST(test_incremental_planner, new_goals_rebuild_field) {
+    auto field = std::make_shared<IncrementalDistanceField>();
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons = {Person(1, Point(0, 0))};
+    IncrementalPlanner first(persons, {Goal(1, Point(10, 10))}, &grid, field);
+    first.plan_all_routes();
+    std::vector<Goal> goals = {Goal(1, Point(0, 10))};
+    IncrementalPlanner second(persons, goals, &grid, field);
+    auto routes = second.plan_all_routes();
+    ASSERT_EQ(second.get_stats()["rebuilt"], 1);
+    expect_simple_routes(persons, goals, grid, routes);
+}
+
+TEST(test_incremental_planner, cut_repair_goes_on_next_time) {
+    auto field = std::make_shared<IncrementalDistanceField>();
+    std::vector<Person> persons = {Person(1, Point(0, 0)),
+                                   Person(2, Point(38, 38))};
+    std::vector<Goal> goals = {Goal(1, Point(39, 39))};
+    std::vector<Border> borders;
+    Grid open(borders, Point(0, 0), Point(39, 39));
+    IncrementalPlanner first(persons, goals, &open, field);
+    first.plan_all_routes();
+
+    borders = {Border{Point{0, 20}, Point{38, 20}}};
+    Grid walled(borders, Point(0, 0), Point(39, 39));
+    IncrementalPlanner cut(persons, goals, &walled, field);
+    cut.set_budget(std::make_shared<SearchBudget>(
+        std::chrono::milliseconds(0), 256));
+    auto routes = cut.plan_all_routes();
+    ASSERT_TRUE(cut.is_partial());
+    // The person next to the goal is far from the wall
+    ASSERT_EQ(routes[1].size(), 1u);
+    ASSERT_TRUE(routes[0].empty());
+    ASSERT_EQ(cut.get_stats()["failed_routes"], 1);
+
+    IncrementalPlanner rest(persons, goals, &walled, field);
+    routes = rest.plan_all_routes();
+    ASSERT_FALSE(rest.is_partial());
+    ASSERT_EQ(rest.get_stats()["changed_borders"], 0);
+    expect_simple_routes(persons, goals, walled, routes);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "actions.h"
+#include "grid.h"
+#include "independence_planner.h"
+#include "person.h"
+#include "point.h"
+#include "prioritized_planner.h"
+
+TEST(test_independence_planner, distant_persons_keep_static_routes) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons = {Person(0, Point(1, 1)),
+                                   Person(1, Point(19, 19))};
+    std::vector<Goal> goals = {Goal(0, Point(1, 4)), Goal(1, Point(19, 16))};
+    IndependencePlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes[0],
+              std::vector<Action>({Action::UP, Action::UP, Action::UP}));
+    ASSERT_EQ(routes[1],
+              std::vector<Action>({Action::DOWN, Action::DOWN, Action::DOWN}));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["groups"], 2);
+    ASSERT_EQ(stats["group_size_1"], 2);
+    ASSERT_EQ(stats["id_rounds"], 0);
+    ASSERT_EQ(stats["expansions"], 0);
+}
+
+TEST(test_independence_planner, only_interacting_persons_are_merged) {
+    // The first two come to one goal at the same tick, the third is far away
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons = {Person(0, Point(8, 2)),
+                                   Person(1, Point(2, 8)),
+                                   Person(2, Point(15, 15))};
+    std::vector<Goal> goals = {Goal(0, Point(5, 5)), Goal(1, Point(15, 18))};
+    IndependencePlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["groups"], 2);
+    ASSERT_EQ(stats["group_size_1"], 1);
+    ASSERT_EQ(stats["group_size_2"], 1);
+    ASSERT_EQ(stats["largest_group"], 2);
+    ASSERT_EQ(stats["id_rounds"], 1);
+    ASSERT_EQ(stats["failed_routes"], 0);
+
+    // The merged group gets the routes of the dense planner
+    PrioritizedPlanner dense({persons[0], persons[1]}, goals, &grid);
+    auto expected = dense.plan_all_routes();
+    ASSERT_EQ(routes[0], expected[0]);
+    ASSERT_EQ(routes[1], expected[1]);
+    ASSERT_EQ(routes[2],
+              std::vector<Action>({Action::UP, Action::UP, Action::UP}));
+}
+
+TEST(test_independence_planner, same_routes_with_any_threads) {
+    std::vector<Border> borders = {Border{Point{5, 0}, Point{5, 12}},
+                                   Border{Point{5, 16}, Point{5, 25}}};
+    Grid grid(borders, Point(0, 0), Point(20, 25));
+    std::vector<Person> persons;
+    for (int i = 0; i < 50; ++i) {
+        persons.emplace_back(i, Point((i * 7) % 20, (i * 11) % 25));
+    }
+    std::vector<Goal> goals;
+    for (int i = 0; i < 40; ++i) {
+        goals.emplace_back(i, Point(8 + i % 10, 3 + (i / 10) * 6));
+    }
+
+    IndependenceOptions options;
+    options.threads = 1;
+    IndependencePlanner sequential(persons, goals, &grid, options);
+    auto expected = sequential.plan_all_routes();
+    options.threads = 3;
+    IndependencePlanner parallel(persons, goals, &grid, options);
+    ASSERT_EQ(parallel.plan_all_routes(), expected);
+
+    auto stats = parallel.get_stats();
+    std::int64_t grouped = 0;
+    for (const auto &[key, value] : stats) {
+        if (key.rfind("group_size_", 0) == 0) {
+            grouped += value * std::stoll(key.substr(11));
+        }
+    }
+    ASSERT_EQ(grouped, 50);
+    ASSERT_GT(stats["id_rounds"], 0);
+    ASSERT_GT(stats["groups"], 1);
+    ASSERT_EQ(stats, sequential.get_stats());
+}
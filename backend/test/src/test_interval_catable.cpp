@@ -0,0 +1,200 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "interval_catable.h"
+
+IntervalCATable make_table() {
+    return IntervalCATable(Point{-50, -50}, Point{50, 50});
+}
+
+TEST(test_interval_catable, empty_catable) {
+    auto table = make_table();
+    ASSERT_TRUE(table.check_move(Point{1, 1}, Point{1, 2}, 1));
+}
+
+TEST(test_interval_catable, non_cross_trajectories) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}});
+    ASSERT_TRUE(table.check_move(Point{10, 10}, Point{10, 11}, 0));
+}
+
+TEST(test_interval_catable, same_standpoint) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}});
+    ASSERT_FALSE(table.check_move(Point{2, 2}, Point{1, 2}, 0));
+}
+
+TEST(test_interval_catable, swap_persons_not_allowing) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}});
+    ASSERT_FALSE(table.check_move(Point{1, 2}, Point{1, 1}, 0));
+}
+
+TEST(test_interval_catable, swap_diagonal_persons_not_allowing) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{2, 2}});
+    ASSERT_FALSE(table.check_move(Point{2, 2}, Point{1, 1}, 0));
+}
+
+TEST(test_interval_catable, sequential_standing) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}});
+    ASSERT_TRUE(table.check_move(Point{2, 2}, Point{1, 2}, 1));
+}
+
+TEST(test_interval_catable, wait_collision) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 1}, Point{1, 2}});
+    ASSERT_FALSE(table.check_move(Point{2, 1}, Point{1, 1}, 0));
+}
+
+TEST(test_interval_catable, long_wait_is_one_interval) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 1}, Point{1, 1},
+                             Point{1, 1}, Point{1, 2}});
+    ASSERT_EQ(table.last_visited(Point{1, 1}), 7);
+    ASSERT_EQ(table.last_visited(Point{1, 2}), 8);
+    ASSERT_FALSE(table.check_move(Point{1, 1}, Point{1, 1}, 4));
+    ASSERT_TRUE(table.check_move(Point{2, 1}, Point{1, 1}, 6));
+}
+
+TEST(test_interval_catable, touching_trajectories_are_merged) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}});
+    table.add_trajectory(1, {Point{1, 2}, Point{1, 2}, Point{1, 3}});
+    ASSERT_EQ(table.last_visited(Point{1, 2}), 3);
+    ASSERT_FALSE(table.check_move(Point{2, 2}, Point{1, 2}, 0));
+    ASSERT_FALSE(table.check_move(Point{1, 2}, Point{1, 2}, 1));
+    ASSERT_TRUE(table.check_move(Point{2, 2}, Point{1, 2}, 2));
+}
+
+TEST(test_interval_catable, reserved_ticks_of_every_visit) {
+    auto table = make_table();
+    ASSERT_EQ(table.get_reserved_ticks(Point{1, 2}), 0);
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}});
+    table.add_trajectory(1, {Point{1, 2}, Point{1, 2}, Point{1, 3}}, 10);
+    // [2, 2] of the first person and [10, 13] of the second one
+    ASSERT_EQ(table.get_reserved_ticks(Point{1, 2}), 5);
+    ASSERT_EQ(table.get_reserved_ticks(Point{1, 1}), 2);
+    ASSERT_EQ(table.get_reserved_ticks(Point{9, 9}), 0);
+}
+
+TEST(test_interval_catable, outside_bounds_is_free) {
+    IntervalCATable table(Point{0, 0}, Point{3, 3});
+    table.add_trajectory(0, {Point{3, 3}, Point{4, 4}});
+    ASSERT_EQ(table.last_visited(Point{4, 4}), -1);
+    ASSERT_TRUE(table.check_move(Point{5, 4}, Point{4, 4}, 0));
+}
+
+TEST(test_interval_catable, far_reservations_survive_growth) {
+    // The index starts at the first cell and grows to the corners of the
+    // bounds, every reservation made before must stay where it was
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}});
+    table.add_trajectory(1, {Point{-50, -50}, Point{-49, -50}});
+    table.add_trajectory(2, {Point{50, 50}, Point{50, 49}});
+    ASSERT_EQ(table.last_visited(Point{1, 2}), 2);
+    ASSERT_EQ(table.last_visited(Point{-49, -50}), 2);
+    ASSERT_EQ(table.last_visited(Point{50, 49}), 2);
+    ASSERT_FALSE(table.check_move(Point{2, 2}, Point{1, 2}, 0));
+    table.rollback(1);
+    ASSERT_EQ(table.last_visited(Point{1, 1}), 1);
+    ASSERT_EQ(table.last_visited(Point{-50, -50}), -1);
+    ASSERT_EQ(table.last_visited(Point{50, 50}), -1);
+    table.add_trajectory(3, {Point{-20, 30}, Point{-20, 31}});
+    ASSERT_EQ(table.last_visited(Point{-20, 31}), 2);
+    ASSERT_EQ(table.last_visited(Point{1, 2}), 2);
+}
+
+TEST(test_interval_catable, clear_removes_reservations) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}});
+    table.clear();
+    ASSERT_EQ(table.last_visited(Point{1, 1}), -1);
+    ASSERT_TRUE(table.check_move(Point{2, 2}, Point{1, 2}, 0));
+}
+
+TEST(test_interval_catable, trajectory_with_start_time) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}}, 10);
+    ASSERT_EQ(table.last_visited(Point{1, 2}), 12);
+    ASSERT_TRUE(table.check_move(Point{2, 1}, Point{1, 1}, 0));
+    ASSERT_FALSE(table.check_move(Point{2, 1}, Point{1, 1}, 9));
+}
+
+TEST(test_interval_catable, horizon_is_last_reserved_tick) {
+    auto table = make_table();
+    ASSERT_EQ(table.get_horizon(), -1);
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}, Point{2, 3}});
+    table.add_trajectory(1, {Point{5, 5}, Point{5, 6}});
+    ASSERT_EQ(table.get_horizon(), 5);
+    table.clear();
+    ASSERT_EQ(table.get_horizon(), -1);
+}
+
+TEST(test_interval_catable, rollback_removes_later_trajectories) {
+    auto table = make_table();
+    table.add_trajectory(0, {Point{1, 1}, Point{1, 2}});
+    table.add_trajectory(1, {Point{1, 3}, Point{1, 3}, Point{1, 2}});
+    table.add_trajectory(2, {Point{4, 4}, Point{5, 5}});
+    ASSERT_EQ(table.get_trajectory_count(), 3);
+    table.rollback(1);
+    ASSERT_EQ(table.get_trajectory_count(), 1);
+    ASSERT_EQ(table.last_visited(Point{1, 2}), 2);
+    ASSERT_EQ(table.last_visited(Point{1, 3}), -1);
+    ASSERT_EQ(table.last_visited(Point{5, 5}), -1);
+    ASSERT_EQ(table.get_horizon(), 2);
+    table.rollback(0);
+    ASSERT_EQ(table.last_visited(Point{1, 1}), -1);
+    ASSERT_EQ(table.get_horizon(), -1);
+}
+
+TEST(test_interval_catable, rollback_restores_merged_intervals) {
+    // Random walks on a small board merge intervals all the time, the table
+    // after a rollback must answer like one built without the later walks
+    std::vector<std::vector<Point>> trajectories;
+    unsigned state = 12345;
+    auto next_random = [&state](int bound) {
+        state = state * 1103515245u + 12345u;
+        return int((state >> 16) % unsigned(bound));
+    };
+    for (int i = 0; i < 40; ++i) {
+        std::vector<Point> trajectory{Point{next_random(6), next_random(6)}};
+        for (int step = 0; step < 12; ++step) {
+            const auto &last = trajectory.back();
+            trajectory.push_back(Point{last.get_x() + next_random(3) - 1,
+                                       last.get_y() + next_random(3) - 1});
+        }
+        trajectories.push_back(trajectory);
+    }
+
+    for (std::size_t kept : {0u, 1u, 17u, 39u}) {
+        auto table = make_table();
+        auto expected = make_table();
+        for (std::size_t i = 0; i < trajectories.size(); ++i) {
+            table.add_trajectory(int(i), trajectories[i], int(i % 5));
+            if (i < kept) {
+                expected.add_trajectory(int(i), trajectories[i], int(i % 5));
+            }
+        }
+        table.rollback(kept);
+        ASSERT_EQ(table.get_horizon(), expected.get_horizon());
+        for (int x = -2; x < 8; ++x) {
+            for (int y = -2; y < 8; ++y) {
+                Point cell{x, y};
+                ASSERT_EQ(table.last_visited(cell),
+                          expected.last_visited(cell));
+                for (int time = 0; time < 40; ++time) {
+                    for (const auto &next : cell.get_neighbors()) {
+                        ASSERT_EQ(table.check_move(cell, next, time),
+                                  expected.check_move(cell, next, time));
+                    }
+                    ASSERT_EQ(table.check_move(cell, cell, time),
+                              expected.check_move(cell, cell, time));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "actions.h"
+#include "grid.h"
+#include "lacam_planner.h"
+#include "person.h"
+#include "point.h"
+#include "route_checks.h"
+#include "search_budget.h"
+
+TEST(test_lacam_planner, single_person_takes_straight_route) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1))};
+    std::vector<Goal> goals{Goal(0, Point(4, 3))};
+
+    LacamPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 1);
+    ASSERT_EQ(routes[0].size(), 5);
+    ASSERT_EQ(final_position(persons[0], routes[0]), Point(4, 3));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["sum_of_costs"], 10);
+    ASSERT_EQ(stats["waits"], 0);
+}
+
+TEST(test_lacam_planner, reached_and_unreachable_persons_stay) {
+    std::vector<Border> borders = {
+        Border{Point{0, 0}, Point{0, 2}}, Border{Point{0, 0}, Point{2, 0}},
+        Border{Point{2, 2}, Point{0, 2}}, Border{Point{2, 2}, Point{2, 0}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(8, 8)),
+                                Person(2, Point(5, 8))};
+    std::vector<Goal> goals{Goal(0, Point(8, 8))};
+
+    LacamPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 3);
+    ASSERT_TRUE(routes[0].empty());
+    ASSERT_TRUE(routes[1].empty());
+    ASSERT_EQ(final_position(persons[2], routes[2]), Point(8, 8));
+}
+
+TEST(test_lacam_planner, second_person_waits_for_goal) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(5, 1))};
+    std::vector<Goal> goals{Goal(0, Point(3, 1))};
+
+    LacamPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes[0], std::vector<Action>({Action::RIGHT, Action::RIGHT}));
+    ASSERT_EQ(routes[1], std::vector<Action>(
+                             {Action::LEFT, Action::WAIT, Action::LEFT}));
+    ASSERT_EQ(planner.get_stats()["sum_of_costs"], 10);
+    expect_no_conflicts(persons, routes, grid);
+}
+
+TEST(test_lacam_planner, crowd_passes_narrow_gap) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    LacamPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), persons.size());
+    expect_no_conflicts(persons, routes, grid);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        auto position = final_position(persons[i], routes[i]);
+        ASSERT_GT(position.get_x(), 10) << "person " << i;
+    }
+    ASSERT_EQ(planner.get_stats()["unfinished_routes"], 0);
+}
+
+TEST(test_lacam_planner, refinement_never_costs_more) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 4}},
+                                   Border{Point{10, 6}, Point{10, 10}}};
+    Grid grid(borders, Point(0, 0), Point(20, 10));
+    std::vector<Person> persons;
+    for (int i = 0; i < 30; ++i) {
+        persons.emplace_back(i, Point(i % 10, i / 10 * 3));
+    }
+    std::vector<Goal> goals{Goal(0, Point(18, 2)), Goal(1, Point(18, 8))};
+
+    LacamPlanner first(persons, goals, &grid);
+    first.plan_all_routes();
+    auto first_cost = first.get_stats()["sum_of_costs"];
+
+    LacamPlanner refined(persons, goals, &grid, LacamOptions{true, 0});
+    refined.set_budget(
+        std::make_shared<SearchBudget>(std::chrono::milliseconds(200)));
+    auto routes = refined.plan_all_routes();
+    ASSERT_FALSE(refined.is_partial());
+    expect_no_conflicts(persons, routes, grid);
+    auto stats = refined.get_stats();
+    ASSERT_GT(stats["sum_of_costs"], 0);
+    ASSERT_LE(stats["sum_of_costs"], first_cost);
+    std::int64_t total = 0;
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        for (auto action : routes[i]) {
+            total += get_cost(action);
+        }
+    }
+    ASSERT_EQ(total, stats["sum_of_costs"]);
+}
+
+TEST(test_lacam_planner, exhausted_budget_keeps_routes_consistent) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    for (std::int64_t expansions : {0, 5, 20}) {
+        LacamPlanner planner(persons, goals, &grid);
+        planner.set_budget(std::make_shared<SearchBudget>(
+            std::chrono::milliseconds(0), expansions));
+        auto routes = planner.plan_all_routes();
+        ASSERT_TRUE(planner.is_partial());
+        ASSERT_EQ(routes.size(), persons.size());
+        expect_no_conflicts(persons, routes, grid);
+        ASSERT_GT(planner.get_stats()["unfinished_routes"], 0);
+    }
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "actions.h"
+#include "grid.h"
+#include "lns_planner.h"
+#include "pbs_planner.h"
+#include "person.h"
+#include "point.h"
+#include "route_checks.h"
+#include "search_budget.h"
+
+namespace {
+// Returns the same routes whatever the budget
+class FixedPlanner : public Planner {
+ public:
+    FixedPlanner(const std::vector<Person> &persons,
+                 const std::vector<Goal> &goals, Grid *grid,
+                 std::vector<std::vector<Action>> routes)
+        : Planner(persons, goals, grid), _routes(std::move(routes)) {}
+
+    std::vector<std::vector<Action>> plan_all_routes() override {
+        return _routes;
+    }
+
+ private:
+    std::vector<std::vector<Action>> _routes;
+};
+
+int get_route_cost(const std::vector<Action> &route) {
+    int cost = 0;
+    for (auto action : route) {
+        cost += get_cost(action);
+    }
+    return cost;
+}
+}  // namespace
+
+TEST(test_lns_planner, shortens_detour_of_initial_routes) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1)),
+                                Person(1, Point(1, 10))};
+    std::vector<Goal> goals{Goal(0, Point(6, 1)), Goal(1, Point(6, 10))};
+    std::vector<std::vector<Action>> initial{
+        {Action::UP, Action::RIGHT, Action::RIGHT, Action::RIGHT,
+         Action::RIGHT, Action::RIGHT, Action::DOWN},
+        {Action::RIGHT, Action::WAIT, Action::RIGHT, Action::RIGHT,
+         Action::RIGHT, Action::RIGHT}};
+
+    LnsOptions options;
+    options.threads = 1;
+    options.iterations = 10;
+    LnsPlanner planner(
+        persons, goals, &grid,
+        std::make_unique<FixedPlanner>(persons, goals, &grid, initial),
+        options);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(get_route_cost(routes[0]), 10);
+    ASSERT_EQ(get_route_cost(routes[1]), 10);
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["initial_sum_of_costs"], 26);
+    ASSERT_EQ(stats["sum_of_costs"], 20);
+    ASSERT_EQ(stats["makespan"], 10);
+    ASSERT_GT(stats["lns_improvements"], 0);
+    // The lower bound is reached, so the search stops early
+    ASSERT_LT(stats["lns_iterations"], 10);
+}
+
+TEST(test_lns_planner, plans_persons_without_routes) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(3, 3))};
+    std::vector<Goal> goals{Goal(0, Point(5, 1))};
+
+    LnsOptions options;
+    options.threads = 1;
+    LnsPlanner planner(persons, goals, &grid,
+                       std::make_unique<FixedPlanner>(
+                           persons, goals, &grid,
+                           std::vector<std::vector<Action>>(2)),
+                       options);
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    ASSERT_EQ(to_trajectory(persons[0], routes[0]).back(), Point(5, 1));
+    ASSERT_EQ(to_trajectory(persons[1], routes[1]).back(), Point(5, 1));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["initial_failed_routes"], 2);
+    ASSERT_EQ(stats["failed_routes"], 0);
+}
+
+TEST(test_lns_planner, improves_pbs_routes_and_reports_progress) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    std::vector<LnsProgress> progress;
+    LnsOptions options;
+    options.threads = 4;
+    options.iterations = 64;
+    options.on_improvement = [&progress](const LnsProgress &best) {
+        progress.push_back(best);
+    };
+    LnsPlanner planner(
+        persons, goals, &grid,
+        std::make_unique<PbsPlanner>(persons, goals, &grid), options);
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+
+    auto stats = planner.get_stats();
+    ASSERT_FALSE(progress.empty());
+    ASSERT_EQ(progress.front().iteration, 0);
+    ASSERT_EQ(progress.front().sum_of_costs, stats["initial_sum_of_costs"]);
+    for (std::size_t i = 1; i < progress.size(); ++i) {
+        ASSERT_LT(std::tie(progress[i].failed_routes, progress[i].sum_of_costs),
+                  std::tie(progress[i - 1].failed_routes,
+                           progress[i - 1].sum_of_costs));
+    }
+    ASSERT_EQ(progress.back().sum_of_costs, stats["sum_of_costs"]);
+    ASSERT_EQ(progress.back().makespan, stats["makespan"]);
+    ASSERT_LE(stats["sum_of_costs"], stats["initial_sum_of_costs"]);
+    std::int64_t total = 0;
+    for (const auto &route : routes) {
+        total += get_route_cost(route);
+    }
+    ASSERT_EQ(stats["sum_of_costs"], total);
+    ASSERT_EQ(stats["failed_routes"], 0);
+}
+
+TEST(test_lns_planner, stops_at_deadline) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1))};
+    std::vector<Goal> goals{Goal(0, Point(6, 1))};
+    std::vector<std::vector<Action>> initial{
+        {Action::UP, Action::RIGHT, Action::RIGHT, Action::RIGHT,
+         Action::RIGHT, Action::RIGHT, Action::DOWN}};
+
+    LnsPlanner planner(
+        persons, goals, &grid,
+        std::make_unique<FixedPlanner>(persons, goals, &grid, initial));
+    planner.set_budget(
+        std::make_shared<SearchBudget>(std::chrono::milliseconds(1)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes, initial);
+    ASSERT_EQ(planner.get_stats()["lns_iterations"], 0);
+}
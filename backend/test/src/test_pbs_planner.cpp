@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "actions.h"
+#include "grid.h"
+#include "pbs_planner.h"
+#include "person.h"
+#include "point.h"
+#include "route_checks.h"
+#include "search_budget.h"
+
+TEST(test_pbs_planner, single_person_needs_no_priorities) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1))};
+    std::vector<Goal> goals{Goal(0, Point(4, 3))};
+
+    PbsPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 1);
+    ASSERT_EQ(final_position(persons[0], routes[0]), Point(4, 3));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["sum_of_costs"], 8);
+    ASSERT_EQ(stats["high_level_nodes"], 1);
+    ASSERT_EQ(stats["priority_pairs"], 0);
+}
+
+TEST(test_pbs_planner, reached_and_unreachable_persons_stay) {
+    std::vector<Border> borders = {
+        Border{Point{0, 0}, Point{0, 2}}, Border{Point{0, 0}, Point{2, 0}},
+        Border{Point{2, 2}, Point{0, 2}}, Border{Point{2, 2}, Point{2, 0}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(8, 8)),
+                                Person(2, Point(5, 8))};
+    std::vector<Goal> goals{Goal(0, Point(8, 8))};
+
+    PbsPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 3);
+    ASSERT_TRUE(routes[0].empty());
+    ASSERT_TRUE(routes[1].empty());
+    ASSERT_EQ(final_position(persons[2], routes[2]), Point(8, 8));
+    ASSERT_EQ(planner.get_stats()["failed_routes"], 0);
+}
+
+TEST(test_pbs_planner, only_colliding_persons_get_priorities) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(5, 1)),
+                                Person(2, Point(17, 8))};
+    std::vector<Goal> goals{Goal(0, Point(3, 1)), Goal(1, Point(19, 8))};
+
+    PbsPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    ASSERT_EQ(final_position(persons[0], routes[0]), Point(3, 1));
+    ASSERT_EQ(final_position(persons[1], routes[1]), Point(3, 1));
+    ASSERT_EQ(routes[2], std::vector<Action>({Action::RIGHT, Action::RIGHT}));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["priority_pairs"], 1);
+    ASSERT_EQ(stats["sum_of_costs"], 14);
+}
+
+TEST(test_pbs_planner, crowd_passes_narrow_gap) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    PbsPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_FALSE(planner.is_partial());
+    expect_no_conflicts(persons, routes, grid);
+    std::int64_t total = 0;
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_GT(final_position(persons[i], routes[i]).get_x(), 10)
+            << "person " << i;
+        for (auto action : routes[i]) {
+            total += get_cost(action);
+        }
+    }
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["sum_of_costs"], total);
+    ASSERT_EQ(stats["failed_routes"], 0);
+    ASSERT_GT(stats["priority_pairs"], 0);
+}
+
+TEST(test_pbs_planner, exhausted_budget_leaves_colliding_persons) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    for (std::int64_t expansions : {0, 100, 300}) {
+        PbsPlanner planner(persons, goals, &grid);
+        planner.set_budget(std::make_shared<SearchBudget>(
+            std::chrono::milliseconds(0), expansions));
+        auto routes = planner.plan_all_routes();
+        ASSERT_TRUE(planner.is_partial());
+        ASSERT_EQ(routes.size(), persons.size());
+        expect_no_conflicts(persons, routes, grid);
+        ASSERT_GT(planner.get_stats()["failed_routes"], 0);
+    }
+}
+
+TEST(test_pbs_planner, persons_in_one_cell_finish) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(1, 1)),
+                                Person(2, Point(5, 1))};
+    std::vector<Goal> goals{Goal(0, Point(8, 8))};
+
+    PbsPlanner planner(persons, goals, &grid);
+    planner.set_budget(std::make_shared<SearchBudget>(
+        std::chrono::milliseconds(300), SearchBudget::UNLIMITED));
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 3);
+    ASSERT_EQ(final_position(persons[2], routes[2]), Point(8, 8));
+    // The two can not both stand in their cell at the first tick
+    ASSERT_TRUE(routes[0].empty() || routes[1].empty());
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "actions.h"
+#include "grid.h"
+#include "person.h"
+#include "pibt_planner.h"
+#include "point.h"
+#include "route_checks.h"
+#include "search_budget.h"
+
+TEST(test_pibt_planner, single_person_takes_shortest_route) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1))};
+    std::vector<Goal> goals{Goal(0, Point(15, 4))};
+
+    PibtPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 1);
+    ASSERT_EQ(routes[0].size(), 14);
+    ASSERT_EQ(final_position(persons[0], routes[0]), Point(15, 4));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["makespan"], 3 * 3 + 11 * 2);
+    ASSERT_EQ(stats["waits"], 0);
+    ASSERT_EQ(stats["unfinished_routes"], 0);
+}
+
+TEST(test_pibt_planner, reached_and_unreachable_persons_stay) {
+    std::vector<Border> borders = {
+        Border{Point{0, 0}, Point{0, 2}}, Border{Point{0, 0}, Point{2, 0}},
+        Border{Point{2, 2}, Point{0, 2}}, Border{Point{2, 2}, Point{2, 0}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(8, 8)),
+                                Person(2, Point(5, 8))};
+    std::vector<Goal> goals{Goal(0, Point(8, 8))};
+
+    PibtPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 3);
+    ASSERT_TRUE(routes[0].empty());
+    ASSERT_TRUE(routes[1].empty());
+    ASSERT_EQ(final_position(persons[2], routes[2]), Point(8, 8));
+}
+
+TEST(test_pibt_planner, second_person_waits_for_goal) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(5, 1))};
+    std::vector<Goal> goals{Goal(0, Point(3, 1))};
+
+    PibtPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes[0], std::vector<Action>({Action::RIGHT, Action::RIGHT}));
+    ASSERT_EQ(routes[1], std::vector<Action>(
+                             {Action::LEFT, Action::WAIT, Action::LEFT}));
+    expect_no_conflicts(persons, routes, grid);
+}
+
+TEST(test_pibt_planner, crowd_passes_narrow_gap) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    PibtPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), persons.size());
+    expect_no_conflicts(persons, routes, grid);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        auto position = final_position(persons[i], routes[i]);
+        ASSERT_GT(position.get_x(), 10) << "person " << i;
+    }
+    ASSERT_EQ(planner.get_stats()["unfinished_routes"], 0);
+}
+
+TEST(test_pibt_planner, opposite_flows_do_not_collide) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(12, 6));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int y = 0; y <= 6; ++y) {
+        persons.emplace_back(y, Point(0, y));
+        persons.emplace_back(7 + y, Point(12, y));
+    }
+    goals.emplace_back(0, Point(12, 3));
+    goals.emplace_back(1, Point(0, 3));
+
+    PibtPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    expect_no_conflicts(persons, routes, grid);
+    ASSERT_EQ(planner.get_stats()["unfinished_routes"], 0);
+}
+
+TEST(test_pibt_planner, thousands_of_persons) {
+    std::vector<Border> borders = {Border{Point{50, 0}, Point{50, 40}},
+                                   Border{Point{50, 60}, Point{50, 100}}};
+    Grid grid(borders, Point(0, 0), Point(100, 100));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 2000; ++i) {
+        persons.emplace_back(i, Point(i % 50, i / 50));
+    }
+    for (int i = 0; i < 100; ++i) {
+        goals.emplace_back(i, Point(60 + i % 40, 1 + (i / 40) * 40));
+    }
+
+    PibtPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), persons.size());
+    expect_no_conflicts(persons, routes, grid);
+    ASSERT_EQ(planner.get_stats()["unfinished_routes"], 0);
+}
+
+TEST(test_pibt_planner, exhausted_budget_keeps_routes_consistent) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 9}},
+                                   Border{Point{10, 11}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+        goals.emplace_back(i, Point(14 + i % 6, 2 + i / 6 * 4));
+    }
+
+    for (std::int64_t expansions : {0, 50, 200}) {
+        PibtPlanner planner(persons, goals, &grid);
+        planner.set_budget(std::make_shared<SearchBudget>(
+            std::chrono::milliseconds(0), expansions));
+        auto routes = planner.plan_all_routes();
+        ASSERT_TRUE(planner.is_partial());
+        ASSERT_EQ(routes.size(), persons.size());
+        expect_no_conflicts(persons, routes, grid);
+    }
+}
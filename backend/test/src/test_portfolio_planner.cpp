@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "actions.h"
+#include "grid.h"
+#include "person.h"
+#include "point.h"
+#include "portfolio_planner.h"
+#include "prioritized_planner.h"
+#include "search_budget.h"
+
+namespace {
+struct Scene {
+    Grid grid;
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+};
+
+// Crowd behind two walls with gaps, priority orders matter here
+Scene make_crowd(int count) {
+    std::vector<Border> borders = {
+        Border{Point{5, 0}, Point{5, 12}}, Border{Point{5, 16}, Point{5, 25}},
+        Border{Point{15, 25}, Point{15, 13}},
+        Border{Point{15, 9}, Point{15, 0}},
+    };
+    Scene scene{Grid(borders, Point(0, 0), Point(20, 25)), {}, {}};
+    for (int i = 0; i < count; ++i) {
+        scene.persons.emplace_back(i, Point((i * 7) % 20, (i * 11) % 25));
+    }
+    for (int i = 0; i < 70; ++i) {
+        scene.goals.emplace_back(i, Point(16 + i % 5, 3 + (i / 5) % 20));
+    }
+    return scene;
+}
+
+int count_failed(const std::vector<Person> &persons,
+                 const std::vector<Goal> &goals,
+                 const std::vector<std::vector<Action>> &routes) {
+    int failed = 0;
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        bool at_goal = false;
+        for (const auto &goal : goals) {
+            at_goal |= goal.get_position() == persons[i].get_position();
+        }
+        failed += routes[i].empty() && !at_goal ? 1 : 0;
+    }
+    return failed;
+}
+
+int get_makespan(const std::vector<std::vector<Action>> &routes) {
+    int makespan = 0;
+    for (const auto &route : routes) {
+        int cost = 0;
+        for (auto action : route) {
+            cost += get_cost(action);
+        }
+        makespan = std::max(makespan, cost);
+    }
+    return makespan;
+}
+}  // namespace
+
+TEST(test_portfolio_planner, single_run_is_shortest_first) {
+    auto scene = make_crowd(60);
+    PrioritizedPlanner prioritized(scene.persons, scene.goals, &scene.grid);
+    PortfolioOptions options;
+    options.runs = 1;
+    PortfolioPlanner portfolio(scene.persons, scene.goals, &scene.grid,
+                               options);
+    ASSERT_EQ(portfolio.plan_all_routes(), prioritized.plan_all_routes());
+    ASSERT_EQ(portfolio.get_stats()["portfolio_best_run"], 0);
+}
+
+TEST(test_portfolio_planner, never_worse_than_shortest_first) {
+    auto scene = make_crowd(60);
+    PrioritizedPlanner prioritized(scene.persons, scene.goals, &scene.grid);
+    auto expected = prioritized.plan_all_routes();
+
+    for (unsigned threads : {1u, 3u}) {
+        PortfolioOptions options;
+        options.runs = 6;
+        options.threads = threads;
+        PortfolioPlanner portfolio(scene.persons, scene.goals, &scene.grid,
+                                   options);
+        auto routes = portfolio.plan_all_routes();
+        int failed = count_failed(scene.persons, scene.goals, routes);
+        int expected_failed =
+            count_failed(scene.persons, scene.goals, expected);
+        ASSERT_LE(failed, expected_failed);
+        if (failed == expected_failed) {
+            ASSERT_LE(get_makespan(routes), get_makespan(expected));
+        }
+        auto stats = portfolio.get_stats();
+        ASSERT_EQ(stats["portfolio_runs"], 6);
+        ASSERT_EQ(stats["makespan"], get_makespan(routes));
+    }
+}
+
+TEST(test_portfolio_planner, perfect_run_cancels_the_rest) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons = {Person(0, Point(1, 1))};
+    std::vector<Goal> goals = {Goal(0, Point(1, 4))};
+    PortfolioOptions options;
+    options.runs = 8;
+    options.threads = 1;
+    PortfolioPlanner portfolio(persons, goals, &grid, options);
+    auto routes = portfolio.plan_all_routes();
+    ASSERT_EQ(routes[0],
+              std::vector<Action>({Action::UP, Action::UP, Action::UP}));
+    // The first run already reaches the lower bound, the others are
+    // cancelled before they plan anybody
+    ASSERT_EQ(portfolio.get_stats()["portfolio_finished_runs"], 1);
+}
+
+TEST(test_portfolio_planner, runs_share_the_budget) {
+    auto scene = make_crowd(60);
+    PortfolioOptions options;
+    options.runs = 4;
+    options.threads = 2;
+    PortfolioPlanner portfolio(scene.persons, scene.goals, &scene.grid,
+                               options);
+    auto budget = std::make_shared<SearchBudget>(std::chrono::milliseconds(0),
+                                                 200);
+    portfolio.set_budget(budget);
+    auto routes = portfolio.plan_all_routes();
+    ASSERT_EQ(routes.size(), scene.persons.size());
+    ASSERT_TRUE(portfolio.is_partial());
+    ASSERT_EQ(portfolio.get_stats()["portfolio_finished_runs"], 4);
+}
@@ -1,10 +1,13 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <set>
 #include <stdexcept>
+#include <tuple>
 #include <vector>
 
 #include "actions.h"
+#include "distance_field.h"
 #include "grid.h"
 #include "person.h"
 #include "point.h"
@@ -134,3 +137,327 @@ TEST(test_routes, prioritized_locked_person) {
 // There were tests about swap routes
 // As far as I understand, there is no possibility for prioritized planner to
 // generate them
+
+TEST(test_routes, prioritized_several_locked_persons) {
+    std::vector<Border> borders = {
+        Border{Point{0, 0}, Point{0, 2}}, Border{Point{0, 0}, Point{2, 0}},
+        Border{Point{2, 2}, Point{0, 2}}, Border{Point{2, 2}, Point{2, 0}},
+        Border{Point{6, 0}, Point{6, 2}}, Border{Point{6, 0}, Point{8, 0}},
+        Border{Point{8, 2}, Point{6, 2}}, Border{Point{8, 2}, Point{8, 0}},
+    };
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    persons.emplace_back(0, Point(0, 0));
+    persons.emplace_back(1, Point(7, 1));
+    persons.emplace_back(2, Point(5, 5));
+    persons.emplace_back(3, Point(4, 9));
+    goals.emplace_back(0, Point(8, 5));
+
+    PrioritizedPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 4);
+    ASSERT_EQ(routes[0].size(), 0);
+    ASSERT_EQ(routes[1].size(), 0);
+    ASSERT_EQ(routes[2].size(), 3);
+    ASSERT_GT(routes[3].size(), 0);
+    Point current = persons[3].get_position();
+    for (auto action : routes[3]) {
+        current = current + action;
+    }
+    ASSERT_EQ(current, Point(8, 5));
+}
+
+TEST(test_routes, prioritized_parallel_same_as_sequential) {
+    std::vector<Border> borders = {
+        Border{Point{5, 0}, Point{5, 12}}, Border{Point{5, 16}, Point{5, 25}},
+        Border{Point{15, 25}, Point{15, 13}},
+        Border{Point{15, 9}, Point{15, 0}},
+    };
+    Grid grid(borders, Point(0, 0), Point(20, 25));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 60; ++i) {
+        persons.emplace_back(i, Point((i * 7) % 20, (i * 11) % 25));
+    }
+    for (int i = 0; i < 70; ++i) {
+        goals.emplace_back(i, Point(16 + i % 5, 3 + (i / 5) % 20));
+    }
+
+    PrioritizedPlanner sequential(persons, goals, &grid);
+    auto expected = sequential.plan_all_routes();
+    for (unsigned threads : {2u, 4u, 8u}) {
+        for (unsigned window : {0u, 3u, 64u}) {
+            PrioritizedOptions options;
+            options.threads = threads;
+            options.window = window;
+            PrioritizedPlanner parallel(persons, goals, &grid, options);
+            ASSERT_EQ(parallel.plan_all_routes(), expected);
+        }
+    }
+}
+
+TEST(test_routes, prioritized_late_person_follows_static_route) {
+    std::vector<Border> borders = {Border{Point{6, 0}, Point{6, 14}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    persons.emplace_back(0, Point(4, 15));
+    persons.emplace_back(1, Point(2, 2));
+    goals.emplace_back(0, Point(10, 2));
+
+    PrioritizedPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_EQ(routes.size(), 2);
+    // The first person is gone long before the second one comes around the
+    // wall, so the second route is the static shortest route
+    int cost = 0;
+    Point current = persons[1].get_position();
+    for (auto action : routes[1]) {
+        Point next = current + action;
+        ASSERT_FALSE(grid.is_incorrect_move(Segment(current, next)));
+        cost += get_cost(action);
+        current = next;
+    }
+    ASSERT_EQ(current, Point(10, 2));
+    DistanceField field(grid, {Point(10, 2)});
+    ASSERT_EQ(cost, field.get_distance(persons[1].get_position()));
+}
+
+TEST(test_routes, prioritized_lazy_free_route_needs_no_search) {
+    std::vector<Border> borders = {Border{Point{6, 0}, Point{6, 14}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    persons.emplace_back(0, Point(2, 2));
+    goals.emplace_back(0, Point(10, 2));
+
+    PrioritizedOptions options;
+    options.lazy = true;
+    PrioritizedPlanner planner(persons, goals, &grid, options);
+    auto routes = planner.plan_all_routes();
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["static_routes"], 1);
+    ASSERT_EQ(stats["expansions"], 0);
+    int cost = 0;
+    for (auto action : routes[0]) {
+        cost += get_cost(action);
+    }
+    DistanceField field(grid, {Point(10, 2)});
+    ASSERT_EQ(cost, field.get_distance(persons[0].get_position()));
+}
+
+TEST(test_routes, prioritized_lazy_counts_every_person) {
+    std::vector<Border> borders = {
+        Border{Point{5, 0}, Point{5, 12}}, Border{Point{5, 16}, Point{5, 25}},
+        Border{Point{15, 25}, Point{15, 13}},
+        Border{Point{15, 9}, Point{15, 0}},
+    };
+    Grid grid(borders, Point(0, 0), Point(20, 25));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 60; ++i) {
+        persons.emplace_back(i, Point((i * 7) % 20, (i * 11) % 25));
+    }
+    for (int i = 0; i < 70; ++i) {
+        goals.emplace_back(i, Point(16 + i % 5, 3 + (i / 5) % 20));
+    }
+
+    PrioritizedOptions options;
+    options.lazy = true;
+    PrioritizedPlanner planner(persons, goals, &grid, options);
+    auto routes = planner.plan_all_routes();
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["static_routes"] + stats["repaired_routes"] +
+                  stats["searched_routes"] + stats["failed_routes"],
+              60);
+    ASSERT_GT(stats["repaired_routes"], 0);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        Point current = persons[i].get_position();
+        for (auto action : routes[i]) {
+            Point next = current + action;
+            ASSERT_FALSE(grid.is_incorrect_move(Segment(current, next)));
+            current = next;
+        }
+    }
+
+    // Lazy search stays deterministic with speculative planning
+    options.threads = 4;
+    PrioritizedPlanner parallel(persons, goals, &grid, options);
+    ASSERT_EQ(parallel.plan_all_routes(), routes);
+}
+
+TEST(test_routes, prioritized_congestion_waits_less) {
+    std::vector<Border> borders = {
+        Border{Point{5, 0}, Point{5, 12}}, Border{Point{5, 16}, Point{5, 25}},
+        Border{Point{15, 25}, Point{15, 13}},
+        Border{Point{15, 9}, Point{15, 0}},
+    };
+    Grid grid(borders, Point(0, 0), Point(20, 25));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 60; ++i) {
+        persons.emplace_back(i, Point((i * 7) % 20, (i * 11) % 25));
+    }
+    for (int i = 0; i < 70; ++i) {
+        goals.emplace_back(i, Point(16 + i % 5, 3 + (i / 5) % 20));
+    }
+
+    PrioritizedPlanner plain(persons, goals, &grid);
+    plain.plan_all_routes();
+    auto plain_stats = plain.get_stats();
+
+    PrioritizedOptions options;
+    options.congestion = true;
+    PrioritizedPlanner guided(persons, goals, &grid, options);
+    auto expected = guided.plan_all_routes();
+    auto stats = guided.get_stats();
+    ASSERT_LT(stats["waits"], plain_stats["waits"]);
+    ASSERT_EQ(stats["failed_routes"], plain_stats["failed_routes"]);
+
+    options.threads = 4;
+    PrioritizedPlanner parallel(persons, goals, &grid, options);
+    ASSERT_EQ(parallel.plan_all_routes(), expected);
+}
+
+TEST(test_routes, prioritized_keeps_valid_previous_routes) {
+    std::vector<Border> borders = {
+        Border{Point{5, 0}, Point{5, 12}}, Border{Point{5, 16}, Point{5, 25}},
+        Border{Point{15, 25}, Point{15, 13}},
+        Border{Point{15, 9}, Point{15, 0}},
+    };
+    Grid grid(borders, Point(0, 0), Point(20, 25));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 60; ++i) {
+        persons.emplace_back(i, Point((i * 7) % 20, (i * 11) % 25));
+    }
+    for (int i = 0; i < 70; ++i) {
+        goals.emplace_back(i, Point(16 + i % 5, 3 + (i / 5) % 20));
+    }
+
+    PrioritizedPlanner first(persons, goals, &grid);
+    auto previous = first.plan_all_routes();
+    auto first_stats = first.get_stats();
+
+    PrioritizedOptions options;
+    options.previous_routes.assign(previous.begin(), previous.end());
+    PrioritizedPlanner planner(persons, goals, &grid, options);
+    ASSERT_EQ(planner.plan_all_routes(), previous);
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["kept_routes"], first_stats["searched_routes"]);
+    ASSERT_EQ(stats["expansions"], 0);
+}
+
+TEST(test_routes, prioritized_replans_persons_with_invalid_previous_routes) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(30, 30));
+    std::vector<Person> persons;
+    std::vector<Goal> goals;
+    for (int i = 0; i < 10; ++i) {
+        persons.emplace_back(i, Point(2, 2 + 2 * i));
+    }
+    goals.emplace_back(0, Point(25, 15));
+
+    PrioritizedPlanner first(persons, goals, &grid);
+    auto previous = first.plan_all_routes();
+
+    // One person moved and a wall now crosses the route of another one
+    persons[0] = Person(0, Point(3, 2));
+    Point wall_cell = persons[9].get_position() + previous[9][0];
+    std::vector<Border> new_borders = {
+        Border{Point{wall_cell.get_x(), wall_cell.get_y() - 1},
+               Point{wall_cell.get_x(), wall_cell.get_y() + 1}}};
+    Grid new_grid(new_borders, Point(0, 0), Point(30, 30));
+    PrioritizedOptions options;
+    options.previous_routes.assign(previous.begin(), previous.end());
+    PrioritizedPlanner planner(persons, goals, &new_grid, options);
+    auto routes = planner.plan_all_routes();
+    auto stats = planner.get_stats();
+    ASSERT_GT(stats["kept_routes"], 0);
+    ASSERT_LE(stats["kept_routes"], 8);
+    ASSERT_EQ(stats["failed_routes"], 0);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        Point current = persons[i].get_position();
+        for (auto action : routes[i]) {
+            Point next = current + action;
+            ASSERT_FALSE(new_grid.is_incorrect_move(Segment(current, next)));
+            current = next;
+        }
+        ASSERT_EQ(current, Point(25, 15));
+    }
+}
+
+TEST(test_routes, simple_shares_routes_of_one_start) {
+    std::vector<Border> borders = {Border{Point{6, 0}, Point{6, 14}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    for (int i = 0; i < 5; ++i) {
+        persons.emplace_back(i, Point(2, 2));
+    }
+    persons.emplace_back(5, Point(4, 8));
+    std::vector<Goal> goals = {Goal(0, Point(15, 3))};
+
+    SimplePlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    auto alone = planner.calculate_route(persons[0]);
+    ASSERT_TRUE(alone.has_value());
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_EQ(routes[std::size_t(i)], *alone);
+    }
+    ASSERT_EQ(routes[5], *planner.calculate_route(persons[5]));
+}
+
+TEST(test_routes, prioritized_staggers_persons_in_one_cell) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    for (int i = 0; i < 6; ++i) {
+        persons.emplace_back(i, Point(2, 2));
+    }
+    persons.emplace_back(6, Point(9, 2));
+    std::vector<Goal> goals = {Goal(0, Point(15, 15))};
+
+    PrioritizedPlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["staggered_routes"], 5);
+    ASSERT_EQ(stats["searched_routes"], 2);
+    ASSERT_EQ(stats["failed_routes"], 0);
+
+    // After leaving the queue nobody meets anybody
+    std::set<std::tuple<int, int, int>> taken;
+    std::size_t previous_waits = 0;
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        Point current = persons[i].get_position();
+        std::size_t waits = 0;
+        for (; waits < routes[i].size() && routes[i][waits] == Action::WAIT;
+             ++waits) {
+        }
+        if (i > 0 && i < 6) {
+            ASSERT_GT(waits, previous_waits);
+        }
+        previous_waits = waits;
+        int time = int(waits) * get_cost(Action::WAIT);
+        for (std::size_t k = waits; k < routes[i].size(); ++k) {
+            Point next = current + routes[i][k];
+            for (int tick = 1; tick < get_cost(routes[i][k]); ++tick) {
+                ASSERT_TRUE(taken
+                                .insert({current.get_x(), current.get_y(),
+                                         time + tick})
+                                .second);
+            }
+            time += get_cost(routes[i][k]);
+            ASSERT_TRUE(
+                taken.insert({next.get_x(), next.get_y(), time}).second);
+            current = next;
+        }
+        ASSERT_EQ(current, Point(15, 15));
+    }
+
+    PrioritizedOptions options;
+    options.threads = 4;
+    options.window = 3;
+    PrioritizedPlanner parallel(persons, goals, &grid, options);
+    ASSERT_EQ(parallel.plan_all_routes(), routes);
+}
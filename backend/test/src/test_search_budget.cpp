@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "actions.h"
+#include "grid.h"
+#include "person.h"
+#include "point.h"
+#include "prioritized_planner.h"
+#include "random_planner.h"
+#include "search_budget.h"
+#include "simple_planner.h"
+
+namespace {
+void expect_valid_moves(const std::vector<Person> &persons,
+                        const std::vector<std::vector<Action>> &routes,
+                        const Grid &grid) {
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        Point current = persons[i].get_position();
+        for (auto action : routes[i]) {
+            Point next = current + action;
+            ASSERT_FALSE(grid.is_incorrect_move(Segment(current, next)));
+            current = next;
+        }
+    }
+}
+}  // namespace
+
+TEST(test_search_budget, unlimited_budget_gives_search_limit) {
+    SearchBudget budget;
+    budget.spend(1000000);
+    ASSERT_FALSE(budget.is_exhausted());
+    ASSERT_EQ(budget.get_share(10), SearchBudget::DEFAULT_SEARCH_LIMIT);
+}
+
+TEST(test_search_budget, share_splits_the_rest) {
+    SearchBudget budget(std::chrono::milliseconds(0), 1000, 300);
+    ASSERT_EQ(budget.get_share(1), 300);
+    ASSERT_EQ(budget.get_share(4), 250);
+    budget.spend(900);
+    ASSERT_EQ(budget.get_share(4), 25);
+    ASSERT_FALSE(budget.is_exhausted());
+    budget.spend(200);
+    ASSERT_EQ(budget.get_share(1), 0);
+    ASSERT_TRUE(budget.is_exhausted());
+}
+
+TEST(test_search_budget, deadline_expires) {
+    SearchBudget budget(std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_TRUE(budget.is_expired());
+    ASSERT_TRUE(budget.is_exhausted());
+}
+
+TEST(test_search_budget, prioritized_returns_partial_routes) {
+    std::vector<Border> borders = {Border{Point{6, 0}, Point{6, 14}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    std::vector<Goal> goals = {Goal(0, Point(10, 2))};
+    for (int i = 0; i < 10; ++i) {
+        persons.emplace_back(i, Point(i % 5, 2 * (i / 5) + 2));
+    }
+
+    PrioritizedPlanner complete(persons, goals, &grid);
+    complete.plan_all_routes();
+    ASSERT_FALSE(complete.is_partial());
+
+    PrioritizedPlanner planner(persons, goals, &grid);
+    auto budget =
+        std::make_shared<SearchBudget>(std::chrono::milliseconds(0), 50);
+    planner.set_budget(budget);
+    auto routes = planner.plan_all_routes();
+    ASSERT_TRUE(planner.is_partial());
+    ASSERT_EQ(routes.size(), persons.size());
+    expect_valid_moves(persons, routes, grid);
+}
+
+TEST(test_search_budget, lazy_static_routes_need_no_budget) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons = {Person(0, Point(1, 1)),
+                                   Person(1, Point(15, 15))};
+    std::vector<Goal> goals = {Goal(0, Point(1, 4)), Goal(1, Point(15, 12))};
+    PrioritizedOptions options;
+    options.lazy = true;
+    PrioritizedPlanner planner(persons, goals, &grid, options);
+    planner.set_budget(
+        std::make_shared<SearchBudget>(std::chrono::milliseconds(0), 0));
+    auto routes = planner.plan_all_routes();
+    ASSERT_FALSE(planner.is_partial());
+    ASSERT_EQ(routes[0].size(), 3);
+    ASSERT_EQ(routes[1].size(), 3);
+}
+
+TEST(test_search_budget, simple_and_random_stop_when_exhausted) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons = {Person(0, Point(1, 1)),
+                                   Person(1, Point(15, 15))};
+    std::vector<Goal> goals = {Goal(0, Point(10, 10))};
+
+    SimplePlanner simple(persons, goals, &grid);
+    simple.set_budget(
+        std::make_shared<SearchBudget>(std::chrono::milliseconds(0), 1));
+    auto routes = simple.plan_all_routes();
+    ASSERT_TRUE(simple.is_partial());
+    ASSERT_FALSE(routes[0].empty());
+    ASSERT_TRUE(routes[1].empty());
+
+    RandomPlanner random(persons, goals, &grid);
+    random.set_budget(
+        std::make_shared<SearchBudget>(std::chrono::milliseconds(0), 3));
+    routes = random.plan_all_routes();
+    ASSERT_TRUE(random.is_partial());
+    expect_valid_moves(persons, routes, grid);
+}
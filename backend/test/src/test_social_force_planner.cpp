@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "actions.h"
+#include "grid.h"
+#include "person.h"
+#include "point.h"
+#include "route_checks.h"
+#include "search_budget.h"
+#include "social_force_planner.h"
+
+namespace {
+// Persons of this planner may share cells, so only the moves are checked
+void expect_valid_moves(const std::vector<Person> &persons,
+                        const std::vector<std::vector<Action>> &routes,
+                        const Grid &grid) {
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        auto trajectory = to_trajectory(persons[i], routes[i]);
+        for (std::size_t k = 1; k < trajectory.size(); ++k) {
+            ASSERT_FALSE(grid.is_incorrect_move(
+                Segment(trajectory[k - 1], trajectory[k])))
+                << "person " << i << " step " << k;
+        }
+    }
+}
+}  // namespace
+
+TEST(test_social_force_planner, single_person_walks_to_goal) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1))};
+    std::vector<Goal> goals{Goal(0, Point(8, 5))};
+
+    SocialForcePlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    expect_valid_moves(persons, routes, grid);
+    ASSERT_EQ(to_trajectory(persons[0], routes[0]).back(), Point(8, 5));
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["unfinished_routes"], 0);
+    // Not faster than the cheapest route of 4 diagonals and 3 straight moves
+    ASSERT_GE(stats["makespan"], 18);
+}
+
+TEST(test_social_force_planner, person_next_to_border_walks_away) {
+    // The border runs along the left side of cell (5, 3), the person stands
+    // in the middle of the cell and is not on it
+    std::vector<Border> borders = {Border{Point{5, 0}, Point{5, 10}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(5, 3))};
+    std::vector<Goal> goals{Goal(0, Point(8, 3))};
+
+    SocialForcePlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    expect_valid_moves(persons, routes, grid);
+    ASSERT_EQ(to_trajectory(persons[0], routes[0]).back(), Point(8, 3));
+    ASSERT_EQ(planner.get_stats()["unfinished_routes"], 0);
+}
+
+TEST(test_social_force_planner, stuck_crowd_stops_early) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(3, 1))};
+    std::vector<Goal> goals{Goal(0, Point(8, 8))};
+
+    SocialForceOptions options;
+    options.speed = 0;
+    SocialForcePlanner planner(persons, goals, &grid, options);
+    auto routes = planner.plan_all_routes();
+    ASSERT_FALSE(planner.is_partial());
+    ASSERT_TRUE(routes[0].empty());
+    ASSERT_TRUE(routes[1].empty());
+    // 100 ticks without a move are 400 steps of a quarter tick
+    auto stats = planner.get_stats();
+    ASSERT_EQ(stats["steps"], 400);
+    ASSERT_EQ(stats["unfinished_routes"], 2);
+}
+
+TEST(test_social_force_planner, reached_and_unreachable_persons_stay) {
+    std::vector<Border> borders = {
+        Border{Point{0, 0}, Point{0, 2}}, Border{Point{0, 0}, Point{2, 0}},
+        Border{Point{2, 2}, Point{0, 2}}, Border{Point{2, 2}, Point{2, 0}}};
+    Grid grid(borders, Point(0, 0), Point(10, 10));
+    std::vector<Person> persons{Person(0, Point(1, 1)), Person(1, Point(8, 8)),
+                                Person(2, Point(5, 8))};
+    std::vector<Goal> goals{Goal(0, Point(8, 8))};
+
+    SocialForcePlanner planner(persons, goals, &grid);
+    auto routes = planner.plan_all_routes();
+    ASSERT_TRUE(routes[0].empty());
+    ASSERT_TRUE(routes[1].empty());
+    ASSERT_EQ(to_trajectory(persons[2], routes[2]).back(), Point(8, 8));
+}
+
+TEST(test_social_force_planner, crowd_passes_narrow_gap) {
+    std::vector<Border> borders = {Border{Point{10, 0}, Point{10, 8}},
+                                   Border{Point{10, 12}, Point{10, 20}}};
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons;
+    for (int i = 0; i < 24; ++i) {
+        persons.emplace_back(i, Point(1 + i % 6, 6 + i / 6 * 2));
+    }
+    std::vector<Goal> goals{Goal(0, Point(17, 10)), Goal(1, Point(17, 4)),
+                            Goal(2, Point(17, 16))};
+
+    SocialForceOptions options;
+    options.threads = 1;
+    SocialForcePlanner planner(persons, goals, &grid, options);
+    auto routes = planner.plan_all_routes();
+    ASSERT_FALSE(planner.is_partial());
+    expect_valid_moves(persons, routes, grid);
+    ASSERT_EQ(planner.get_stats()["unfinished_routes"], 0);
+    for (std::size_t i = 0; i < persons.size(); ++i) {
+        ASSERT_GT(to_trajectory(persons[i], routes[i]).back().get_x(), 10);
+    }
+
+    // Every tile writes only its own persons, so threads change nothing
+    options.threads = 4;
+    SocialForcePlanner threaded(persons, goals, &grid, options);
+    ASSERT_EQ(threaded.plan_all_routes(), routes);
+}
+
+TEST(test_social_force_planner, exhausted_budget_is_partial) {
+    std::vector<Border> borders;
+    Grid grid(borders, Point(0, 0), Point(20, 20));
+    std::vector<Person> persons{Person(0, Point(1, 1))};
+    std::vector<Goal> goals{Goal(0, Point(15, 15))};
+
+    SocialForcePlanner planner(persons, goals, &grid);
+    planner.set_budget(
+        std::make_shared<SearchBudget>(std::chrono::milliseconds(0), 10));
+    auto routes = planner.plan_all_routes();
+    ASSERT_TRUE(planner.is_partial());
+    ASSERT_EQ(planner.get_stats()["steps"], 10);
+    ASSERT_EQ(planner.get_stats()["unfinished_routes"], 1);
+}